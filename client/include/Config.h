@@ -8,4 +8,19 @@
 // 客户端测试使用的服务器 IP 地址
 #define SERVER_IP "127.0.0.1"
 
+// 等待响应的超时时间（毫秒）；分片传输未收齐时，每次超时都会发送确认请求重传
+#define RECV_TIMEOUT_MS 1000
+// 分片传输未收齐时最多等待的超时次数
+#define FRAGMENT_WAIT_RETRIES 5
+// 收到 SERVER_BUSY 后按服务端建议的间隔重发请求的最大次数
+#define BUSY_MAX_RETRIES 3
+// 登录后发送心跳的间隔（毫秒），应明显小于服务端的 HEARTBEAT_TIMEOUT_MS
+#define HEARTBEAT_INTERVAL_MS 30000
+// 登录时是否请求服务端压缩大响应（离线消息、聊天记录）
+#define ACCEPT_COMPRESSION 1
+// 批量刷新时每个 MULTI_REQ 携带的子请求数，不应超过服务端的 MULTI_MAX_REQUESTS（批量按子请求数限速）
+#define MULTI_BATCH_SIZE 8
+// 分页查看聊天记录时每页请求的条数（服务端另有上限）
+#define HISTORY_PAGE_SIZE 50
+
 #endif // CONFIG_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Protocol.h"
 #include "Config.h"
+#include "Fragment.h"
+#include "Compression.h"
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -8,52 +10,225 @@
 #include <limits>
 #include <cstring>
 #include <functional>
+#include <map>
 #include <csignal> 
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 int currentUserId = -1;
+std::atomic<int> heartbeatUserId{-1};  // currentUserId 的副本，供心跳线程读取
+std::atomic<uint32_t> nextRequestId{1};  // 每个请求一个编号，服务端在响应头中带回
 int sock;
 sockaddr_in serv;
 
-std::vector<uint8_t> buildPacket(MessageType type, const std::vector<uint8_t>& body) {
-    PacketHeader hdr{type, static_cast<uint32_t>(body.size())};
-    std::vector<uint8_t> pkt(sizeof(hdr) + body.size());
-    memcpy(pkt.data(), &hdr, sizeof(hdr));
-    if (!body.empty())
-        memcpy(pkt.data() + sizeof(hdr), body.data(), body.size());
-    return pkt;
+template <typename T>
+std::vector<uint8_t> makeRequest(MessageType type, const T &msg, uint16_t flags = 0) {
+    return buildMessage(type, nextRequestId.fetch_add(1, std::memory_order_relaxed), msg, flags);
 }
 
-void sendRequest(const std::vector<uint8_t> &pkt) {
+// 一个完整响应：分片响应在重组后给出原始类型与负载
+struct Response {
+    PacketHeader header;
+    std::vector<uint8_t> body;
+
+    template <typename T>
+    bool decode(T &msg) const { return decodeMessage(body.data(), body.size(), msg); }
+    // 好友与好友请求列表：服务端按请求的版本回复，版本 2 起为紧凑编码
+    template <typename T>
+    bool decodeList(T &msg) const {
+        return header.version >= VERSION_COMPACT_LISTS ? decodeCompact(body.data(), body.size(), msg) : decode(msg);
+    }
+};
+
+// 登录期间定期发送心跳，服务端超过 HEARTBEAT_TIMEOUT_MS 未收到即视为掉线
+void heartbeatLoop() {
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(HEARTBEAT_INTERVAL_MS));
+        int userId = heartbeatUserId.load(std::memory_order_relaxed);
+        if (userId < 0) continue;
+        std::vector<uint8_t> pkt = makeRequest(HEARTBEAT_REQ, UserReq{userId});
+        sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv));
+    }
+}
+
+void sendFragmentAck(const std::vector<uint8_t> &ack) {
+    std::vector<uint8_t> pkt = buildPacket(FRAGMENT_ACK, 0, ack);
+    sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv));
+}
+
+// 打印服务端主动推送的消息（requestId 为 0），返回是否为推送
+bool printPush(const PacketHeader &hdr, const uint8_t *body) {
+    if (hdr.type == PRIVATE_MSG_PUSH) {
+        PrivateMsgPush msg;
+        if (decodeMessage(body, hdr.length, msg))
+            std::cout << "\n[私聊消息] 来自用户 " << msg.senderId << ": " << msg.message << std::endl;
+        return true;
+    }
+    if (hdr.type == GROUP_MSG) {
+        GroupMsg msg;
+        if (decodeMessage(body, hdr.length, msg))
+            std::cout << "\n[群消息] 群 " << msg.groupId << ": " << msg.message << std::endl;
+        return true;
+    }
+    return false;
+}
+
+// 压缩封装的负载在此解开，之后的解码与未压缩时相同
+bool unpackResponse(Response &resp) {
+    if (!(resp.header.flags & FLAG_COMPRESSED)) return true;
+    std::vector<uint8_t> raw;
+    if (!unpackPayload(resp.body.data(), resp.body.size(), raw)) {
+        std::cerr << "[ERROR] 压缩响应解压失败" << std::endl;
+        return false;
+    }
+    std::cout << "[DEBUG] 压缩响应 " << resp.body.size() << " -> " << raw.size() << " 字节" << std::endl;
+    resp.body = std::move(raw);
+    resp.header.flags &= ~FLAG_COMPRESSED;
+    resp.header.length = static_cast<uint32_t>(resp.body.size());
+    return true;
+}
+
+// 接收 requestId 对应的一个完整响应：分片在此重组并回复确认，等待超时时发送确认请求服务端重传缺失分片
+// 格式错误的数据报与早先请求的迟到响应被忽略，期间收到的推送消息直接打印
+bool receiveResponse(uint32_t requestId, Response &resp) {
+    static Reassembler reassembler;
+    uint8_t buf[2048];
+    int timeouts = 0;
+    while (timeouts <= FRAGMENT_WAIT_RETRIES) {
+        socklen_t len = sizeof(serv);
+        ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&serv), &len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && !reassembler.idle()) {
+                for (const auto &ack : reassembler.pendingAcks()) sendFragmentAck(ack);
+                ++timeouts;
+                continue;
+            }
+            return false;
+        }
+
+        PacketHeader hdr;
+        if (!decodeHeader(buf, n, hdr)) continue;
+        const uint8_t *body = buf + PACKET_HEADER_SIZE;
+        if (printPush(hdr, body)) continue;
+        if (hdr.type != FRAGMENT_DATA) {
+            if (hdr.requestId != requestId) continue;
+            resp.header = hdr;
+            resp.body.assign(body, body + hdr.length);
+            return unpackResponse(resp);
+        }
+        // 迟到的分片也要重组并确认，否则服务端会一直重传
+        uint8_t type;
+        std::vector<uint8_t> payload, ack;
+        bool done = reassembler.add(body, hdr.length, type, payload, ack);
+        if (!ack.empty()) sendFragmentAck(ack);
+        if (done && hdr.requestId == requestId) {
+            std::cout << "[DEBUG] 分片响应重组完成，长度: " << payload.size() << std::endl;
+            // 分片的 flags 与版本与原响应一致
+            resp.header = PacketHeader{type, hdr.flags, requestId, static_cast<uint32_t>(payload.size()), hdr.version};
+            resp.body = std::move(payload);
+            return unpackResponse(resp);
+        }
+    }
+    return false;
+}
+
+// 打印登录后推送的离线消息列表
+void printOfflineMessages(const Response &resp) {
+    OfflineMsgListResp list;
+    if (resp.header.type != OFFLINE_MSG_LIST_RESP || !resp.decode(list)) return;
+    for (const auto &msg : list.messages)
+        std::cout << "[离线消息] 来自用户 " << msg.senderId << ": " << msg.content << std::endl;
+    std::cout << "共 " << list.messages.size() << " 条离线消息" << std::endl;
+}
+
+// 把 MULTI_RESP 拆成各子请求的响应，子响应沿用外层的 requestId 与版本，压缩的子响应在此解开
+bool splitMulti(const Response &resp, std::vector<Response> &subs) {
+    MultiResp multi;
+    if (!resp.decode(multi)) {
+        std::cerr << "[ERROR] 批量响应格式错误" << std::endl;
+        return false;
+    }
+    for (const auto &r : multi.responses) {
+        Response sub;
+        sub.header = PacketHeader{r.type, r.flags, resp.header.requestId, static_cast<uint32_t>(r.body.size()),
+                                  resp.header.version};
+        sub.body.assign(r.body.begin(), r.body.end());
+        if (unpackResponse(sub)) subs.push_back(std::move(sub));
+    }
+    return true;
+}
+
+// 多个已编码的子请求负载打包成一个 MULTI_REQ，子请求个数不应超过服务端的 MULTI_MAX_REQUESTS
+std::vector<uint8_t> makeMultiRequest(const std::vector<std::pair<MessageType, std::vector<uint8_t>>> &subs) {
+    MultiReq multi;
+    multi.requests.reserve(subs.size());
+    for (const auto &s : subs)
+        multi.requests.push_back({s.first, std::string_view(reinterpret_cast<const char*>(s.second.data()),
+                                                            s.second.size())});
+    return makeRequest(MULTI_REQ, multi);
+}
+
+// 发送请求并等待响应；服务端过载时回复 SERVER_BUSY：等待建议的间隔后原样重发
+bool exchange(const std::vector<uint8_t> &pkt, Response &resp) {
+    PacketHeader req;
+    decodeHeader(pkt.data(), pkt.size(), req);
     // 发送数据包
     if (sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv)) < 0) {
         perror("sendto");
-        return;
+        return false;
     }
     std::cout << "[DEBUG] Sent request packet of size: " << pkt.size() << std::endl;
-    
-    uint8_t buf[2048];
-    socklen_t len = sizeof(serv);
-    ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&serv), &len);
 
-    if (n <= static_cast<ssize_t>(sizeof(PacketHeader))) {
+    if (!receiveResponse(req.requestId, resp)) {
         std::cerr << "无效响应或者超时" << std::endl;
+        return false;
+    }
+    ServerBusy busy;
+    for (int retries = 0; resp.header.type == SERVER_BUSY && resp.decode(busy); ++retries) {
+        if (retries >= BUSY_MAX_RETRIES) {
+            std::cerr << "服务器繁忙，请稍后再试" << std::endl;
+            return false;
+        }
+        std::cout << "[DEBUG] 服务器繁忙，" << busy.retryAfterMs << " 毫秒后重试" << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(busy.retryAfterMs));
+        sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv));
+        if (!receiveResponse(req.requestId, resp)) {
+            std::cerr << "无效响应或者超时" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printResponse(const Response &resp) {
+    // 批量响应逐个打印其中的子响应
+    if (resp.header.type == MULTI_RESP) {
+        std::vector<Response> subs;
+        if (!splitMulti(resp, subs)) return;
+        std::cout << "[批量响应] 共 " << subs.size() << " 个子响应" << std::endl;
+        for (const auto &sub : subs) printResponse(sub);
         return;
     }
 
-    PacketHeader r;
-    memcpy(&r, buf, sizeof(r));
-    r.length = ntohl(r.length);
-    bool ok = buf[sizeof(r)];
-    std::cout << "响应类型：" << static_cast<int>(r.type)
+    StatusResp status{false};
+    resp.decode(status);  // 所有响应的首字节都是成功标志
+    bool ok = status.ok;
+    std::cout << "响应类型：" << static_cast<int>(resp.header.type)
               << (ok ? " 成功" : " 失败") << std::endl;
 
-    switch (r.type) {
+    switch (resp.header.type) {
         case LOGIN_RESP: {
-            bool loginOk = buf[sizeof(r)];
-            if (loginOk) {
-                memcpy(&currentUserId, buf + sizeof(r) + 1, sizeof(currentUserId));
-                currentUserId = ntohl(currentUserId);
+            LoginResp login;
+            if (resp.decode(login) && login.ok) {
+                currentUserId = login.userId;
+                heartbeatUserId.store(currentUserId, std::memory_order_relaxed);
                 std::cout << ", 登录用户ID = " << currentUserId << std::endl;
+                // 登录成功后服务端紧接着推送离线消息列表（同一 requestId），较大时以分片到达
+                Response offline;
+                if (receiveResponse(resp.header.requestId, offline)) printOfflineMessages(offline);
             } else {
                 std::cout << ", 登录失败，用户可能已经在线或用户名/密码错误" << std::endl;
             }
@@ -63,6 +238,7 @@ void sendRequest(const std::vector<uint8_t> &pkt) {
         case LOGOUT_RESP:
             if (ok) {
                 currentUserId = -1;
+                heartbeatUserId.store(-1, std::memory_order_relaxed);
                 std::cout << ", 已退出登录" << std::endl;
             }   
             break;
@@ -70,73 +246,64 @@ void sendRequest(const std::vector<uint8_t> &pkt) {
         case DELETE_USER_RESP:
             if (ok) {
                 currentUserId = -1;
+                heartbeatUserId.store(-1, std::memory_order_relaxed);
                 std::cout << ", 当前账户已注销，自动退出登录" << std::endl;
             }
             break;
 
         case FRIEND_REQUEST_LIST_RESP: {
-            r.length = ntohl(r.length);
-            bool listOk = buf[sizeof(r)] != 0;
-            if (!listOk) {
-                std::cout << ", 查看好友请求失败" << std::endl;
+            FriendRequestListResp list;
+            if (!resp.decodeList(list)) {
+                std::cerr << "响应格式错误" << std::endl;
                 return;
             }
-
-            const uint8_t* p = buf + sizeof(r) + 1;
-            size_t remaining = n - (sizeof(r) + 1);
-            if (remaining % (sizeof(int) * 2) != 0) {
-                std::cerr << "响应格式错误（长度不匹配）" << std::endl;
+            if (!list.ok) {
+                std::cout << ", 查看好友请求失败" << std::endl;
                 return;
             }
 
-            int count = remaining / (sizeof(int) * 2);
-            std::cout << "\n[好友请求列表] 共 " << count << " 条请求：" << std::endl;
-
-            for (int i = 0; i < count; ++i) {
-                int reqId, fromId;
-                memcpy(&reqId, p, sizeof(int)); p += sizeof(int);
-                memcpy(&fromId, p, sizeof(int)); p += sizeof(int);
-                reqId = ntohl(reqId);
-                fromId = ntohl(fromId);
-                std::cout << "请求ID: " << reqId << ", 来自用户ID: " << fromId << std::endl;
-            }
+            std::cout << "\n[好友请求列表] 共 " << list.requests.size() << " 条请求：" << std::endl;
+            for (const auto &r : list.requests)
+                std::cout << "请求ID: " << r.requestId << ", 来自用户ID: " << r.fromUserId << std::endl;
             break;
         }
 
         case FRIEND_LIST_RESP: {
-            size_t hdrSize = sizeof(r);
-            const uint8_t* p = buf + hdrSize + 1;
-            size_t remaining = n - (hdrSize + 1);
+            std::cout << "\n[DEBUG] 好友列表响应长度: " << resp.body.size() << std::endl;
 
-            std::cout << "\n[DEBUG] 好友列表总响应长度: " << n
-                    << ", header: " << hdrSize << ", body: " << remaining << std::endl;
-
-            if (remaining % 5 != 0) {
-                std::cerr << "[错误] 好友列表响应格式不正确（剩余: " << remaining << "）" << std::endl;
+            FriendListResp list;
+            if (!resp.decodeList(list)) {
+                std::cerr << "[错误] 好友列表响应格式不正确" << std::endl;
                 return;
             }
 
-            int count = remaining / 5;
-            std::cout << "[好友列表] 共 " << count << " 人：" << std::endl;
-
-            for (int i = 0; i < count; ++i) {
-                uint32_t fid = 0;
-                memcpy(&fid, p, 4); fid = ntohl(fid); p += 4;
-                uint8_t blocked = *p++;
-                std::cout << "好友ID: " << fid;
-                if (blocked) std::cout << " [已拉黑]";
+            std::cout << "[好友列表] 共 " << list.friends.size() << " 人：" << std::endl;
+            for (const auto &f : list.friends) {
+                std::cout << "好友ID: " << f.friendId;
+                if (f.blocked) std::cout << " [已拉黑]";
                 std::cout << std::endl;
             }
             break;
         }
 
+        case CHAT_HISTORY_RESP: {
+            ChatHistoryResp history;
+            if (!resp.decode(history)) {
+                std::cerr << "响应格式错误" << std::endl;
+                return;
+            }
+            std::cout << "\n[聊天记录] 共 " << history.messages.size() << " 条：" << std::endl;
+            for (const auto &m : history.messages)
+                std::cout << "用户 " << m.senderId << ": " << m.content << std::endl;
+            break;
+        }
+
         case FRIEND_REQUEST_ACTION_RESP:
             std::cout << ", 好友请求处理完成" << std::endl;
             break;
 
         case FRIEND_REQUEST_RESP: {
-            bool requestOk = buf[sizeof(r)];
-            if (!requestOk) {
+            if (!ok) {
                 std::cout << "你和该用户之间已经有待确认的好友请求，不能重复发送" << std::endl;
             } else {
                 std::cout << "好友请求已成功发送" << std::endl;
@@ -145,8 +312,7 @@ void sendRequest(const std::vector<uint8_t> &pkt) {
         }
 
         case CREATE_GROUP_RESP: {
-            bool groupOk = buf[sizeof(r)];
-            if (groupOk) {
+            if (ok) {
                 std::cout << "群组创建成功！" << std::endl;
             } else {
                 std::cout << "群组创建失败，请检查群组名称是否已存在。" << std::endl;
@@ -154,8 +320,7 @@ void sendRequest(const std::vector<uint8_t> &pkt) {
             break;
         }
         case PRIVATE_MSG_RESP: {
-            bool msgOk = buf[sizeof(r)];
-            if (msgOk) {
+            if (ok) {
                 std::cout << "私聊消息发送成功" << std::endl;
             } else {
                 std::cout << "私聊消息发送失败" << std::endl;
@@ -167,12 +332,83 @@ void sendRequest(const std::vector<uint8_t> &pkt) {
     std::cout << std::endl;
 }
 
+void sendRequest(const std::vector<uint8_t> &pkt) {
+    Response resp;
+    if (exchange(pkt, resp)) printResponse(resp);
+}
+
+// 刷新好友与聊天记录：好友列表与好友请求合并成一个批量请求，
+// 再按 MULTI_BATCH_SIZE 个好友一批拉取聊天记录，往返次数从好友数 + 2 降到约好友数 / 批大小 + 1
+void refreshAll() {
+    Response resp;
+    if (!exchange(makeMultiRequest({{FRIEND_LIST_REQ, encodeMessage(UserReq{currentUserId})},
+                                    {FRIEND_REQUEST_LIST_REQ, encodeMessage(UserReq{currentUserId})}}), resp))
+        return;
+    printResponse(resp);
+
+    std::vector<Response> subs;
+    FriendListResp list{false, {}};
+    if (resp.header.type != MULTI_RESP || !splitMulti(resp, subs)) return;
+    for (const auto &sub : subs)
+        if (sub.header.type == FRIEND_LIST_RESP) sub.decodeList(list);
+
+    for (size_t i = 0; i < list.friends.size(); i += MULTI_BATCH_SIZE) {
+        std::vector<std::pair<MessageType, std::vector<uint8_t>>> batch;
+        for (size_t j = i; j < list.friends.size() && j < i + MULTI_BATCH_SIZE; ++j)
+            batch.push_back({CHAT_HISTORY_REQ, encodeMessage(ChatHistoryReq{currentUserId, list.friends[j].friendId})});
+        sendRequest(makeMultiRequest(batch));
+    }
+}
+
+// 分页查看聊天记录（从新到旧）：一页的各块按序号逐块打印，收完一页后询问是否继续向前翻页
+// 等待超时说明有块丢失，以已连续打印的最后一条为游标重新请求，已显示的记录不会重复
+void browseHistory(int peerId) {
+    int32_t before = 0;
+    for (;;) {
+        std::vector<uint8_t> pkt = makeRequest(CHAT_HISTORY_PAGE_REQ,
+                                               ChatHistoryPageReq{currentUserId, peerId, before, HISTORY_PAGE_SIZE});
+        Response resp;
+        if (!exchange(pkt, resp)) return;
+        uint32_t requestId = resp.header.requestId;
+
+        std::map<uint16_t, Response> chunks;  // 已到达但前面的块还没到的块
+        uint16_t next = 0;
+        bool last = false, more = false;
+        do {
+            ChatHistoryPageResp page;
+            if (resp.header.type == CHAT_HISTORY_PAGE_RESP && resp.decode(page) && page.ok)
+                chunks.emplace(page.seq, std::move(resp));
+            for (auto it = chunks.find(next); it != chunks.end(); it = chunks.find(++next)) {
+                it->second.decode(page);
+                for (const auto &m : page.messages) {
+                    std::cout << "[" << m.msgId << "] 用户 " << m.senderId << ": " << m.content << std::endl;
+                    before = m.msgId;
+                }
+                last = page.last;
+                more = page.more;
+                chunks.erase(it);
+            }
+        } while (!last && receiveResponse(requestId, resp));
+
+        if (!last) {
+            std::cout << "[DEBUG] 部分记录未收到，从消息 " << before << " 之前继续请求" << std::endl;
+            continue;
+        }
+        if (!more) {
+            std::cout << "没有更早的聊天记录" << std::endl;
+            return;
+        }
+        int cont = 0;
+        std::cout << "继续查看更早的记录？(1/0): ";
+        std::cin >> cont;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (!cont) return;
+    }
+}
+
 void handleSigint(int) {
     if (currentUserId >= 0) {
-        PacketHeader hdr{LOGOUT_REQ, sizeof(int)};
-        std::vector<uint8_t> pkt(sizeof(hdr) + sizeof(int));
-        memcpy(pkt.data(), &hdr, sizeof(hdr));
-        memcpy(pkt.data() + sizeof(hdr), &currentUserId, sizeof(currentUserId));
+        std::vector<uint8_t> pkt = makeRequest(LOGOUT_REQ, UserReq{currentUserId});
 
         // 发送退出登录请求
         sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv));
@@ -182,13 +418,13 @@ void handleSigint(int) {
         uint8_t buf[2048];
         socklen_t len = sizeof(serv);
         ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&serv), &len);
-        if (n <= static_cast<ssize_t>(sizeof(PacketHeader))) {
+        PacketHeader r;
+        StatusResp status{false};
+        if (n < 0 || !decodeHeader(buf, n, r) ||
+            !decodeMessage(buf + PACKET_HEADER_SIZE, r.length, status)) {
             std::cerr << "无效响应或超时，退出失败" << std::endl;
         } else {
-            PacketHeader r;
-            memcpy(&r, buf, sizeof(r));
-            bool ok = buf[sizeof(r)];
-            if (r.type == LOGOUT_RESP && ok) {
+            if (r.type == LOGOUT_RESP && status.ok) {
                 currentUserId = -1;
                 std::cout << "\n退出登录成功" << std::endl;
             }
@@ -213,6 +449,9 @@ int main() {
         std::cerr << "SERVER_IP 无效" << std::endl;
         return 1;
     }
+    timeval tv{RECV_TIMEOUT_MS / 1000, (RECV_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::thread(heartbeatLoop).detach();
 
     while (true) {
         std::cout << "\n===== LinuxQQ 控制台客户端 =====" << std::endl;
@@ -221,7 +460,9 @@ int main() {
         } else {
             std::cout << "3-修改信息 4-注销账户 5-发请求 6-查看请求\n"
                       << "7-处理请求 8-删除好友 10-好友列表 11-退出登录\n"
-                      << "12-拉黑好友 13-取消拉黑 14-创建群组 15-发送私聊消息 0-退出程序" << std::endl;
+                      << "12-拉黑好友 13-取消拉黑 14-创建群组 15-发送私聊消息 16-刷新好友与聊天记录\n"
+                      << "17-分页查看聊天记录 "
+                      << "0-退出程序" << std::endl;
             std::cout << "当前用户ID: " << currentUserId << std::endl;
         }
         std::cout << "> ";
@@ -234,10 +475,7 @@ int main() {
         switch (op) {
         case 0:
             if (currentUserId >= 0) {
-                PacketHeader hdr{LOGOUT_REQ, sizeof(int)};
-                std::vector<uint8_t> pkt(sizeof(hdr) + sizeof(int));
-                memcpy(pkt.data(), &hdr, sizeof(hdr));
-                memcpy(pkt.data() + sizeof(hdr), &currentUserId, sizeof(currentUserId));
+                std::vector<uint8_t> pkt = makeRequest(LOGOUT_REQ, UserReq{currentUserId});
                 sendto(sock, pkt.data(), pkt.size(), 0, reinterpret_cast<const sockaddr*>(&serv), sizeof(serv));
                 std::cout << "已自动发送退出登录请求" << std::endl;
                 currentUserId = -1;
@@ -248,16 +486,14 @@ int main() {
             std::string u, p;
             std::cout << "用户名: "; std::getline(std::cin, u);
             std::cout << "密码: ";   std::getline(std::cin, p);
-            std::string body = u + '\0' + p + '\0';
-            pkt = buildPacket(REGISTER_REQ, std::vector<uint8_t>(body.begin(), body.end()));
+            pkt = makeRequest(REGISTER_REQ, CredentialsReq{u, p});
         } break;
 
         case 2: {
             std::string u, p;
             std::cout << "用户名: "; std::getline(std::cin, u);
             std::cout << "密码: ";   std::getline(std::cin, p);
-            std::string body = u + '\0' + p + '\0';
-            pkt = buildPacket(LOGIN_REQ, std::vector<uint8_t>(body.begin(), body.end()));
+            pkt = makeRequest(LOGIN_REQ, CredentialsReq{u, p}, ACCEPT_COMPRESSION ? FLAG_ACCEPT_COMPRESSION : 0);
         } break;
 
         case 3: {
@@ -265,20 +501,12 @@ int main() {
             std::string newName, newPwd;
             std::cout << "新用户名: "; std::getline(std::cin, newName);
             std::cout << "新密码: "; std::getline(std::cin, newPwd);
-            std::vector<uint8_t> body(sizeof(int));
-            memcpy(body.data(), &currentUserId, sizeof(int));
-            body.insert(body.end(), newName.begin(), newName.end());
-            body.push_back('\0');
-            body.insert(body.end(), newPwd.begin(), newPwd.end());
-            body.push_back('\0');
-            pkt = buildPacket(UPDATE_USER_REQ, body);
+            pkt = makeRequest(UPDATE_USER_REQ, UpdateUserReq{currentUserId, newName, newPwd});
         } break;
 
         case 4: {
             if (currentUserId < 0) break;
-            std::vector<uint8_t> body(sizeof(int));
-            memcpy(body.data(), &currentUserId, sizeof(int));
-            pkt = buildPacket(DELETE_USER_REQ, body);
+            pkt = makeRequest(DELETE_USER_REQ, UserReq{currentUserId});
         } break;
 
         case 5: {  // 发送好友请求
@@ -287,20 +515,12 @@ int main() {
             int fid;
             std::cout << "好友ID: "; std::cin >> fid; std::cin.ignore();
 
-            // 构建请求数据包
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&currentUserId), reinterpret_cast<uint8_t*>(&currentUserId) + sizeof(int));
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&fid), reinterpret_cast<uint8_t*>(&fid) + sizeof(int));
-
-            // 构建请求
-            pkt = buildPacket(FRIEND_REQUEST_REQ, body);
+            pkt = makeRequest(FRIEND_REQUEST_REQ, UserPairReq{currentUserId, fid});
         } break;
 
         case 6: {
             if (currentUserId < 0) break;
-            std::vector<uint8_t> body(sizeof(int));
-            memcpy(body.data(), &currentUserId, sizeof(int));
-            pkt = buildPacket(FRIEND_REQUEST_LIST_REQ, body);
+            pkt = makeRequest(FRIEND_REQUEST_LIST_REQ, UserReq{currentUserId});
         } break;
 
         case 7: {
@@ -308,10 +528,7 @@ int main() {
             int reqId, acc;
             std::cout << "请求ID: "; std::cin >> reqId;
             std::cout << "接受(1)/拒绝(0): "; std::cin >> acc;
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&reqId), reinterpret_cast<uint8_t*>(&reqId) + sizeof(int));
-            body.push_back(acc ? 1 : 0);
-            pkt = buildPacket(FRIEND_REQUEST_ACTION_REQ, body);
+            pkt = makeRequest(FRIEND_REQUEST_ACTION_REQ, FriendRequestActionReq{reqId, acc != 0});
         } break;
 
 
@@ -319,44 +536,31 @@ int main() {
             if (currentUserId < 0) break;
             int fid;
             std::cout << "好友ID: "; std::cin >> fid;
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&currentUserId), reinterpret_cast<uint8_t*>(&currentUserId) + sizeof(int));
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&fid), reinterpret_cast<uint8_t*>(&fid) + sizeof(int));
-            pkt = buildPacket(DELETE_FRIEND_REQ, body);
+            pkt = makeRequest(DELETE_FRIEND_REQ, UserPairReq{currentUserId, fid});
         } break;
 
         case 10: {
             if (currentUserId < 0) break;
-            std::vector<uint8_t> body(sizeof(int));
-            memcpy(body.data(), &currentUserId, sizeof(int));
-            pkt = buildPacket(FRIEND_LIST_REQ, body);
+            pkt = makeRequest(FRIEND_LIST_REQ, UserReq{currentUserId});
         } break;
 
         case 11: {
             if (currentUserId < 0) break;
-            std::vector<uint8_t> body(sizeof(int));
-            memcpy(body.data(), &currentUserId, sizeof(int));
-            pkt = buildPacket(LOGOUT_REQ, body);
+            pkt = makeRequest(LOGOUT_REQ, UserReq{currentUserId});
         } break;
 
         case 12: {
             if (currentUserId < 0) break;
             int fid;
             std::cout << "好友ID: "; std::cin >> fid;
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&currentUserId), reinterpret_cast<uint8_t*>(&currentUserId) + sizeof(int));
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&fid), reinterpret_cast<uint8_t*>(&fid) + sizeof(int));
-            pkt = buildPacket(BLOCK_USER_REQ, body);
+            pkt = makeRequest(BLOCK_USER_REQ, UserPairReq{currentUserId, fid});
         } break;
 
         case 13: {
             if (currentUserId < 0) break;
             int fid;
             std::cout << "好友ID: "; std::cin >> fid;
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&currentUserId), reinterpret_cast<uint8_t*>(&currentUserId) + sizeof(int));
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&fid), reinterpret_cast<uint8_t*>(&fid) + sizeof(int));
-            pkt = buildPacket(UNBLOCK_USER_REQ, body);
+            pkt = makeRequest(UNBLOCK_USER_REQ, UserPairReq{currentUserId, fid});
         } break;
         
         case 14: {  // 创建群组
@@ -366,14 +570,7 @@ int main() {
             std::cout << "请输入群组名称: ";
             std::getline(std::cin, groupName);
 
-            // 构建请求数据包
-            pkt.clear();
-            pkt.push_back(0);  // 假设0为成功标志，这里没有返回长度和错误码
-            pkt.insert(pkt.end(), groupName.begin(), groupName.end());
-            pkt.push_back('\0');  // 以null结尾
-
-            // 构建请求数据包，消息类型为 CREATE_GROUP_REQ
-            pkt = buildPacket(CREATE_GROUP_REQ, pkt);
+            pkt = makeRequest(CREATE_GROUP_REQ, CreateGroupReq{groupName});
             break;
         }
         
@@ -385,17 +582,24 @@ int main() {
             std::string message;
             std::cout << "消息内容: "; std::getline(std::cin, message);
 
-            // 构建私聊消息请求数据包
-            std::vector<uint8_t> body;
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&currentUserId), reinterpret_cast<uint8_t*>(&currentUserId) + sizeof(int));
-            body.insert(body.end(), reinterpret_cast<uint8_t*>(&receiverId), reinterpret_cast<uint8_t*>(&receiverId) + sizeof(int));
-            body.insert(body.end(), message.begin(), message.end());
-
-            // 构建请求数据包，消息类型为 PRIVATE_MSG_REQ
-            pkt = buildPacket(PRIVATE_MSG_REQ, body);
+            pkt = makeRequest(PRIVATE_MSG_REQ, PrivateMsgReq{currentUserId, receiverId, message});
             break;
         }
 
+        case 16: {  // 刷新好友与聊天记录
+            if (currentUserId < 0) break;
+            refreshAll();
+            continue;
+        }
+
+        case 17: {  // 分页查看聊天记录
+            if (currentUserId < 0) break;
+            int peerId;
+            std::cout << "好友ID: "; std::cin >> peerId; std::cin.ignore();
+            browseHistory(peerId);
+            continue;
+        }
+
         default:
             std::cout << "无效操作码" << std::endl;
             continue;
@@ -0,0 +1,39 @@
+// Compression.h
+// 大响应的负载压缩。协议头 flags 带 FLAG_COMPRESSED 时，负载是压缩封装：
+//   [codec u8][原始长度 u32][数据]
+// codec 为 CODEC_NONE 时数据就是原始负载（过短或压缩没有收益），为 CODEC_ZLIB 时是 zlib 流
+// 是否使用在登录时协商：客户端在 LOGIN_REQ 的 flags 中置 FLAG_ACCEPT_COMPRESSION，
+// 服务端同意时在 LOGIN_RESP 中回显该位，此后该会话的大响应才会压缩
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum CompressionCodec : uint8_t {
+    CODEC_NONE = 0,
+    CODEC_ZLIB = 1,
+};
+
+constexpr size_t COMPRESSION_ENVELOPE_SIZE = 5;
+// 解压后长度的上限，防止伪造的原始长度导致超大分配
+constexpr size_t MAX_DECOMPRESSED_SIZE = 16u << 20;
+
+// 发送端统计：压缩率 = wireBytes / rawBytes，平均开销 = nanos / (compressed + stored)
+struct CompressionStats {
+    std::atomic<uint64_t> compressed{0};  // 以 zlib 发出的负载数
+    std::atomic<uint64_t> stored{0};      // 过短或无收益而原样封装的负载数
+    std::atomic<uint64_t> rawBytes{0};
+    std::atomic<uint64_t> wireBytes{0};
+    std::atomic<uint64_t> nanos{0};       // 压缩耗费的 CPU 时间（纳秒，按线程时钟）
+};
+
+// 把负载打包成压缩封装：不短于 threshold 且压缩后更短时使用 zlib（level 为 zlib 压缩级别），否则原样存放
+std::vector<uint8_t> packPayload(const uint8_t *raw, size_t len, size_t threshold, int level,
+                                 CompressionStats *stats = nullptr);
+// 解开压缩封装；格式错误、解压失败或原始长度超过上限时返回 false
+bool unpackPayload(const uint8_t *data, size_t len, std::vector<uint8_t> &out);
+
+#endif // COMPRESSION_H
@@ -0,0 +1,82 @@
+// Fragment.h
+// 大响应的分片传输：发送端把负载切成不超过 MTU 的编号分片，
+// 接收端按编号重组，并用选择确认(SACK)位图告知发送端只需重传缺失的分片
+// 服务端与客户端共用，字段均为小端序（见 WireFormat.h）
+#ifndef FRAGMENT_H
+#define FRAGMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// 单个分片携带的最大负载字节数：1500 MTU - IP/UDP 头 - 协议头 - 分片头，留有余量
+constexpr size_t FRAGMENT_PAYLOAD_SIZE = 1200;
+// SACK 位图覆盖的分片数量（从首个缺失分片起算）
+constexpr size_t SACK_WINDOW = 512;
+
+// FRAGMENT_DATA 负载 = 分片头 + 数据
+struct FragmentHeader {
+    uint32_t transferId;
+    uint8_t type;          // 原始响应的消息类型
+    uint16_t index;
+    uint16_t count;
+    uint32_t totalLength;  // 原始负载总长度
+};
+constexpr size_t FRAGMENT_HEADER_SIZE = 13;
+
+void encodeFragmentHeader(const FragmentHeader &hdr, uint8_t *out);
+bool decodeFragmentHeader(const uint8_t *data, size_t len, FragmentHeader &hdr);
+
+// FRAGMENT_ACK 负载：编号小于 base 的分片全部收到；bitmap 第 i 位表示分片 base+i 已收到
+struct FragmentAck {
+    uint32_t transferId;
+    uint16_t base;
+    std::vector<uint8_t> bitmap;
+};
+
+std::vector<uint8_t> encodeFragmentAck(const FragmentAck &ack);
+bool decodeFragmentAck(const uint8_t *data, size_t len, FragmentAck &ack);
+
+// 分片接收状态位图
+class SackBitmap {
+public:
+    explicit SackBitmap(size_t count = 0) : words((count + 63) / 64, 0), total(count), received(0) {}
+
+    bool set(size_t i);  // 返回是否为新收到的分片
+    bool test(size_t i) const { return words[i / 64] >> (i % 64) & 1; }
+    bool complete() const { return received == total; }
+    size_t size() const { return total; }
+    size_t firstMissing() const;
+
+    FragmentAck toAck(uint32_t transferId) const;
+    void apply(const FragmentAck &ack);  // 发送端合并接收端的确认
+
+private:
+    std::vector<uint64_t> words;
+    size_t total;
+    size_t received;
+};
+
+// 接收端重组器，同时跟踪多个传输
+class Reassembler {
+public:
+    // 收到一个 FRAGMENT_DATA 负载；重组完成时返回 true，并在 type/payload 中给出原始响应
+    // 需要确认时（收齐、收到末尾分片仍有缺口、重复分片）ack 被置为待发送的确认
+    bool add(const uint8_t *data, size_t len, uint8_t &type, std::vector<uint8_t> &payload,
+             std::vector<uint8_t> &ack);
+    // 等待超时：为所有未完成的传输生成确认，促使发送端重传缺失分片
+    std::vector<std::vector<uint8_t>> pendingAcks() const;
+    bool idle() const { return transfers.empty(); }
+
+private:
+    struct Transfer {
+        uint8_t type;
+        SackBitmap received;
+        std::vector<uint8_t> buffer;
+    };
+    std::unordered_map<uint32_t, Transfer> transfers;
+    std::vector<uint32_t> recentlyCompleted;  // 重复分片到达时据此回复完整确认
+};
+
+#endif // FRAGMENT_H
@@ -0,0 +1,463 @@
+// Protocol.h
+// 服务端与客户端共用的协议定义：消息类型、定长协议头以及各消息负载的编解码
+// 所有整数字段均为小端序，字符串以长度前缀编码、不含结尾的 0 字节
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "WireCodec.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// === 消息类型定义 ===
+enum MessageType : uint8_t {
+    // === 账户相关 ===
+    REGISTER_REQ = 1,
+    REGISTER_RESP,
+    LOGIN_REQ,
+    LOGIN_RESP,
+    LOGOUT_REQ,
+    LOGOUT_RESP,
+    UPDATE_USER_REQ,
+    UPDATE_USER_RESP,
+    DELETE_USER_REQ,
+    DELETE_USER_RESP,
+
+    // === 好友系统 ===
+    FRIEND_REQUEST_REQ,
+    FRIEND_REQUEST_RESP,
+    FRIEND_REQUEST_LIST_REQ,
+    FRIEND_REQUEST_LIST_RESP,
+    FRIEND_REQUEST_ACTION_REQ,
+    FRIEND_REQUEST_ACTION_RESP,
+    DELETE_FRIEND_REQ,
+    DELETE_FRIEND_RESP,
+    BLOCK_USER_REQ,
+    BLOCK_USER_RESP,
+    UNBLOCK_USER_REQ,
+    UNBLOCK_USER_RESP,
+    FRIEND_LIST_REQ,
+    FRIEND_LIST_RESP,
+
+    // === 群组系统 ===
+    CREATE_GROUP_REQ,
+    CREATE_GROUP_RESP,
+    JOIN_GROUP_REQ,
+    JOIN_GROUP_RESP,
+    GROUP_MSG,
+
+    // === 私聊系统 ===
+    PRIVATE_MSG_REQ = 140,
+    PRIVATE_MSG_RESP,
+    PRIVATE_MSG_PUSH,
+    OFFLINE_MSG_LIST_RESP,
+
+    // === 聊天记录 ===
+    CHAT_HISTORY_REQ,
+    CHAT_HISTORY_RESP,
+
+    // === 心跳 ===
+    HEARTBEAT_REQ,  // 客户端 -> 服务端：刷新在线状态（负载为 UserReq），服务端不回复
+
+    // === 分页聊天记录 ===
+    CHAT_HISTORY_PAGE_REQ,   // 客户端 -> 服务端：按游标取一页聊天记录（负载为 ChatHistoryPageReq）
+    CHAT_HISTORY_PAGE_RESP,  // 服务端 -> 客户端：一页记录分成若干块依次发送（负载为 ChatHistoryPageResp）
+
+    // === 批量请求 ===
+    MULTI_REQ = 180,  // 客户端 -> 服务端：一个数据报携带多个子请求（负载为 MultiReq）
+    MULTI_RESP,       // 服务端 -> 客户端：各子请求的响应合并成一个（负载为 MultiResp）
+
+    // === 过载控制 ===
+    SERVER_BUSY = 190,    // 服务端 -> 客户端：请求因过载被拒绝（负载为 ServerBusy）
+
+    // === 分片传输 ===
+    FRAGMENT_DATA = 200,  // 服务端 -> 客户端：大响应的一个分片（见 Fragment.h）
+    FRAGMENT_ACK          // 客户端 -> 服务端：选择确认
+};
+
+// === 协议头 ===
+// 线上布局（16 字节）：
+//   0  magic      u16  PROTOCOL_MAGIC
+//   2  version    u8   发送端使用的协议版本，见下方版本说明
+//   3  type       u8   MessageType
+//   4  flags      u16  特性标志，见下方 FLAG_*
+//   6  reserved   u16  发送端置 0，接收端忽略
+//   8  requestId  u32  客户端为每个请求分配，服务端在响应中原样带回；服务端主动推送时为 0
+//   12 length     u32  负载长度，须与数据报剩余长度一致
+//
+// 协议版本：接收端接受 [PROTOCOL_MIN_VERSION, PROTOCOL_VERSION] 内的任一版本
+// 服务端以请求的版本编码响应并在响应头中带回，旧客户端看到的始终是它认识的格式；
+// 服务端主动推送的消息与版本无关，一律标记为 PROTOCOL_MIN_VERSION
+//   1  初始版本
+//   2  FRIEND_LIST_RESP 与 FRIEND_REQUEST_LIST_RESP 使用紧凑列表编码（见 encodeCompact）
+constexpr uint16_t PROTOCOL_MAGIC = 0x5151;
+constexpr uint8_t PROTOCOL_MIN_VERSION = 1;
+constexpr uint8_t PROTOCOL_VERSION = 2;
+constexpr uint8_t VERSION_COMPACT_LISTS = 2;
+constexpr size_t PACKET_HEADER_SIZE = 16;
+constexpr size_t PACKET_TYPE_OFFSET = 3;  // 已校验过的数据报可直接按偏移读取类型
+
+// 协议头 flags
+constexpr uint16_t FLAG_COMPRESSED = 0x0001;          // 负载为压缩封装（见 Compression.h）
+constexpr uint16_t FLAG_ACCEPT_COMPRESSION = 0x0002;  // LOGIN_REQ/LOGIN_RESP：协商大响应压缩
+
+struct PacketHeader {
+    uint8_t type;
+    uint16_t flags;
+    uint32_t requestId;
+    uint32_t length;  // payload长度
+    uint8_t version = PROTOCOL_VERSION;
+};
+
+void encodeHeader(const PacketHeader &hdr, uint8_t *out);
+// 魔数、版本或长度不符时返回 false
+bool decodeHeader(const uint8_t *data, size_t len, PacketHeader &hdr);
+// 协议头 + 负载拼成完整数据报
+std::vector<uint8_t> buildPacket(uint8_t type, uint32_t requestId, const uint8_t *payload, size_t len,
+                                 uint16_t flags = 0, uint8_t version = PROTOCOL_VERSION);
+inline std::vector<uint8_t> buildPacket(uint8_t type, uint32_t requestId, const std::vector<uint8_t> &payload,
+                                        uint16_t flags = 0, uint8_t version = PROTOCOL_VERSION) {
+    return buildPacket(type, requestId, payload.data(), payload.size(), flags, version);
+}
+
+// === 消息负载 ===
+// 字符串字段是指向接收缓冲区（解码时）或调用方数据（编码时）的视图，不复制
+// 每个结构体的 fields() 按线上顺序列出字段，编解码由 WireCodec.h 据此生成；新增消息只需写出字段表
+
+// 只有成功标志的响应：REGISTER/LOGOUT/UPDATE_USER/DELETE_USER/FRIEND_REQUEST/
+// FRIEND_REQUEST_ACTION/DELETE_FRIEND/BLOCK_USER/UNBLOCK_USER/CREATE_GROUP/JOIN_GROUP/PRIVATE_MSG_RESP
+struct StatusResp {
+    bool ok;
+
+    static constexpr auto fields() { return wire::fields(wire::field(&StatusResp::ok)); }
+};
+
+// REGISTER_REQ / LOGIN_REQ
+struct CredentialsReq {
+    std::string_view username;
+    std::string_view password;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&CredentialsReq::username),
+                            wire::field(&CredentialsReq::password));
+    }
+};
+
+struct LoginResp {
+    bool ok;
+    int32_t userId;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&LoginResp::ok),
+                            wire::field(&LoginResp::userId));
+    }
+};
+
+// 只携带当前用户的请求：LOGOUT/DELETE_USER/FRIEND_REQUEST_LIST/FRIEND_LIST/HEARTBEAT
+struct UserReq {
+    int32_t userId;
+
+    static constexpr auto fields() { return wire::fields(wire::field(&UserReq::userId)); }
+};
+
+struct UpdateUserReq {
+    int32_t userId;
+    std::string_view newName;
+    std::string_view newPassword;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&UpdateUserReq::userId),
+                            wire::field(&UpdateUserReq::newName),
+                            wire::field(&UpdateUserReq::newPassword));
+    }
+};
+
+// 当前用户对另一用户的操作：FRIEND_REQUEST/DELETE_FRIEND/BLOCK_USER/UNBLOCK_USER
+struct UserPairReq {
+    int32_t userId;
+    int32_t targetId;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&UserPairReq::userId),
+                            wire::field(&UserPairReq::targetId));
+    }
+};
+
+struct FriendRequestActionReq {
+    int32_t requestId;
+    bool accept;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&FriendRequestActionReq::requestId),
+                            wire::field(&FriendRequestActionReq::accept));
+    }
+};
+
+struct FriendRequestEntry {
+    int32_t requestId;
+    int32_t fromUserId;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&FriendRequestEntry::requestId),
+                            wire::field(&FriendRequestEntry::fromUserId));
+    }
+};
+
+struct FriendRequestListResp {
+    bool ok;
+    std::vector<FriendRequestEntry> requests;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&FriendRequestListResp::ok),
+                            wire::field(&FriendRequestListResp::requests));
+    }
+};
+
+struct FriendEntry {
+    int32_t friendId;
+    bool blocked;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&FriendEntry::friendId),
+                            wire::field(&FriendEntry::blocked));
+    }
+};
+
+struct FriendListResp {
+    bool ok;
+    std::vector<FriendEntry> friends;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&FriendListResp::ok),
+                            wire::field(&FriendListResp::friends));
+    }
+};
+
+// 紧凑列表编码（版本 2 起）：条目按 ID 升序排列，ID 只存与前一个的 varint 差值（见 Varint.h）
+//   FRIEND_LIST_RESP          ok u8 | count u32 | blocked 位图 (count+7)/8 字节，低位在前 | 好友 ID 差值
+//   FRIEND_REQUEST_LIST_RESP  ok u8 | count u32 | 请求 ID 差值 | 各请求发起人 ID（varint）
+// 编码时按 ID 排序，所以传值
+std::vector<uint8_t> encodeCompact(FriendListResp msg);
+std::vector<uint8_t> encodeCompact(FriendRequestListResp msg);
+bool decodeCompact(const uint8_t *data, size_t len, FriendListResp &msg);
+bool decodeCompact(const uint8_t *data, size_t len, FriendRequestListResp &msg);
+
+struct CreateGroupReq {
+    std::string_view groupName;
+
+    static constexpr auto fields() { return wire::fields(wire::field(&CreateGroupReq::groupName)); }
+};
+
+struct JoinGroupReq {
+    int32_t userId;
+    std::string_view groupName;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&JoinGroupReq::userId),
+                            wire::field(&JoinGroupReq::groupName));
+    }
+};
+
+// GROUP_MSG：双向使用，客户端发出时 groupId 为目标群，服务端推送时为来源群
+struct GroupMsg {
+    int32_t groupId;
+    std::string_view message;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&GroupMsg::groupId),
+                            wire::field<wire::Bytes::Rest>(&GroupMsg::message));
+    }
+};
+
+// 私聊正文占据负载的剩余部分，转发时可以直接引用接收缓冲区
+struct PrivateMsgReq {
+    int32_t senderId;
+    int32_t receiverId;
+    std::string_view message;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&PrivateMsgReq::senderId),
+                            wire::field(&PrivateMsgReq::receiverId),
+                            wire::field<wire::Bytes::Rest>(&PrivateMsgReq::message));
+    }
+};
+
+struct PrivateMsgPush {
+    int32_t senderId;
+    std::string_view message;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&PrivateMsgPush::senderId),
+                            wire::field<wire::Bytes::Rest>(&PrivateMsgPush::message));
+    }
+};
+
+struct ChatMessage {
+    int32_t senderId;
+    std::string_view content;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ChatMessage::senderId),
+                            wire::field<wire::Bytes::Long>(&ChatMessage::content));
+    }
+};
+
+struct OfflineMsgListResp {
+    bool ok;
+    std::vector<ChatMessage> messages;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&OfflineMsgListResp::ok),
+                            wire::field(&OfflineMsgListResp::messages));
+    }
+};
+
+struct ChatHistoryReq {
+    int32_t userId;
+    int32_t peerId;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ChatHistoryReq::userId),
+                            wire::field(&ChatHistoryReq::peerId));
+    }
+};
+
+struct ChatHistoryResp {
+    bool ok;
+    std::vector<ChatMessage> messages;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ChatHistoryResp::ok),
+                            wire::field(&ChatHistoryResp::messages));
+    }
+};
+
+// 分页聊天记录：从 beforeMsgId（0 表示最新）往前取至多 limit 条（0 表示服务端默认页大小，超过上限时截断）
+// 翻页时把上一页最后一条的 msgId 作为下一页的 beforeMsgId，每页的代价与翻到第几页无关
+struct ChatHistoryPageReq {
+    int32_t userId;
+    int32_t peerId;
+    int32_t beforeMsgId;
+    uint16_t limit;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ChatHistoryPageReq::userId),
+                            wire::field(&ChatHistoryPageReq::peerId),
+                            wire::field(&ChatHistoryPageReq::beforeMsgId),
+                            wire::field(&ChatHistoryPageReq::limit));
+    }
+};
+
+struct HistoryEntry {
+    int32_t msgId;
+    int32_t senderId;
+    std::string_view content;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&HistoryEntry::msgId),
+                            wire::field(&HistoryEntry::senderId),
+                            wire::field<wire::Bytes::Long>(&HistoryEntry::content));
+    }
+};
+
+// 一页按 msgId 从新到旧切成若干块，每块单独成一个数据报（单条超长消息照常分片），块内的记录可以独立显示
+// seq 从 0 递增，last 标记本页最后一块，此时 more 表示是否还有更早的记录
+// 某块丢失时客户端不必重取整页：以最后一个连续收到的块末尾的 msgId 为游标重新请求即可
+struct ChatHistoryPageResp {
+    bool ok;
+    uint16_t seq;
+    bool last;
+    bool more;
+    std::vector<HistoryEntry> messages;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ChatHistoryPageResp::ok),
+                            wire::field(&ChatHistoryPageResp::seq),
+                            wire::field(&ChatHistoryPageResp::last),
+                            wire::field(&ChatHistoryPageResp::more),
+                            wire::field(&ChatHistoryPageResp::messages));
+    }
+};
+
+struct ServerBusy {
+    uint8_t requestType;
+    uint32_t retryAfterMs;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&ServerBusy::requestType),
+                            wire::field(&ServerBusy::retryAfterMs));
+    }
+};
+
+// MULTI_REQ：子请求按原有请求格式编码，类型与负载依次排列；requestId 与版本沿用外层协议头
+// 服务端在一个任务内依次处理，数据库写入合并为一次提交；子请求之间互不影响，各自成败
+struct SubRequest {
+    uint8_t type;
+    std::string_view body;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&SubRequest::type),
+                            wire::field(&SubRequest::body));
+    }
+};
+
+struct MultiReq {
+    std::vector<SubRequest> requests;
+
+    static constexpr auto fields() { return wire::fields(wire::field(&MultiReq::requests)); }
+};
+
+// MULTI_RESP：按子请求下标升序排列，index 对应 MultiReq::requests 中的位置
+// 格式错误或不能批量执行的子请求（登录、心跳、分片确认、分页聊天记录、嵌套批量）没有对应条目
+// 子响应的 flags 与单独请求时相同（如 FLAG_COMPRESSED），整个 MULTI_RESP 超过一个数据报时照常分片
+struct SubResponse {
+    uint16_t index;
+    uint8_t type;
+    uint16_t flags;
+    std::string_view body;
+
+    static constexpr auto fields() {
+        return wire::fields(wire::field(&SubResponse::index),
+                            wire::field(&SubResponse::type),
+                            wire::field(&SubResponse::flags),
+                            wire::field<wire::Bytes::Long>(&SubResponse::body));
+    }
+};
+
+struct MultiResp {
+    std::vector<SubResponse> responses;
+
+    static constexpr auto fields() { return wire::fields(wire::field(&MultiResp::responses)); }
+};
+
+// 编码前先算出确切长度，缓冲区只分配一次
+template <typename T>
+std::vector<uint8_t> encodeMessage(const T &msg) {
+    std::vector<uint8_t> out(wire::encodedSize(msg));
+    WireWriter w(out.data());
+    wire::encode(w, msg);
+    return out;
+}
+
+// 协议头与负载直接编码进同一个数据报，省去负载的中间缓冲区
+template <typename T>
+std::vector<uint8_t> buildMessage(uint8_t type, uint32_t requestId, const T &msg, uint16_t flags = 0,
+                                  uint8_t version = PROTOCOL_VERSION) {
+    size_t len = wire::encodedSize(msg);
+    std::vector<uint8_t> packet(PACKET_HEADER_SIZE + len);
+    encodeHeader(PacketHeader{ type, flags, requestId, static_cast<uint32_t>(len), version }, packet.data());
+    WireWriter w(packet.data() + PACKET_HEADER_SIZE);
+    wire::encode(w, msg);
+    return packet;
+}
+
+// 负载末尾多余的字节被忽略，便于以后在消息末尾追加字段
+template <typename T>
+bool decodeMessage(const uint8_t *data, size_t len, T &msg) {
+    WireReader r(data, len);
+    wire::decode(r, msg);
+    return r.ok();
+}
+
+#endif // PROTOCOL_H
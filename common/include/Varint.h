@@ -0,0 +1,54 @@
+// Varint.h
+// 紧凑 ID 列表的基本编码：无符号 LEB128 变长整数（每字节低 7 位有效，最高位表示后面还有字节）
+// 升序 ID 只存相邻差值，好友 ID 聚集时绝大多数差值只占 1 字节
+// 解码端在可用时用 SSE2 一次检查 16 个字节，全是单字节差值时直接向量化求前缀和
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace varint {
+
+constexpr size_t MAX_BYTES = 5;  // uint32_t 最长 5 字节
+
+inline size_t size(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+// 写入调用方按 size() 预留好的缓冲区，返回写入后的位置
+inline uint8_t *put(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+// 读取一个变长整数，越界或超过 5 字节时返回 false
+inline bool get(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+    uint32_t result = 0;
+    for (unsigned shift = 0; shift < 7 * MAX_BYTES && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 解码 count 个差值并逐个累加（模 2^32），得到的 ID 依次写入 out
+// 成功时 p 前进到最后一个差值之后；数据不足或格式错误返回 false
+bool decodeDeltas(const uint8_t *&p, const uint8_t *end, size_t count, uint32_t *out);
+
+} // namespace varint
+
+#endif // VARINT_H
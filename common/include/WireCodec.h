@@ -0,0 +1,230 @@
+// WireCodec.h
+// 由字段描述在编译期生成的编解码：消息结构体用 static constexpr fields() 按线上顺序列出成员，
+// wire::encodedSize / encode / decode 按字段逐个展开，运行时没有类型分派也没有偏移计算
+// 成员的编码由其类型决定：
+//   bool、uint8_t            1 字节
+//   uint16_t                 2 字节
+//   int32_t、uint32_t        4 字节
+//   std::string_view         由 Bytes 指定长度前缀，默认 u16
+//   带 fields() 的结构体      按其字段内联编码
+//   std::vector<元素>         u32 元素个数 + 各元素
+// 全部字段定长的结构体在编译期得出长度，其列表的长度只需一次乘法
+#ifndef WIRECODEC_H
+#define WIRECODEC_H
+
+#include "WireFormat.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace wire {
+
+// 字符串字段的长度前缀
+enum class Bytes {
+    Short,  // u16 长度前缀（用户名、群名等）
+    Long,   // u32 长度前缀（消息正文）
+    Rest,   // 无前缀，占据负载剩余部分，只能是最后一个字段
+};
+
+template <typename C, typename M, Bytes B>
+struct Field {
+    M C::*member;
+};
+
+template <Bytes B = Bytes::Short, typename C, typename M>
+constexpr Field<C, M, B> field(M C::*member) {
+    return {member};
+}
+
+template <typename... F>
+constexpr std::tuple<F...> fields(F... f) {
+    return std::tuple<F...>(f...);
+}
+
+template <typename F>
+struct FieldTraits;
+
+template <typename C, typename M, Bytes B>
+struct FieldTraits<Field<C, M, B>> {
+    using Member = M;
+    static constexpr Bytes bytes = B;
+};
+
+template <typename T, typename = void>
+struct HasFields : std::false_type {};
+
+template <typename T>
+struct HasFields<T, std::void_t<decltype(T::fields())>> : std::true_type {};
+
+template <typename T>
+struct IsVector : std::false_type {};
+
+template <typename E>
+struct IsVector<std::vector<E>> : std::true_type {};
+
+constexpr size_t VARIABLE = SIZE_MAX;
+
+template <typename T>
+constexpr size_t fixedSize();
+template <typename T>
+constexpr size_t minSize();
+
+template <typename M>
+constexpr size_t scalarSize() {
+    static_assert(sizeof(M) == 1 || sizeof(M) == 2 || sizeof(M) == 4, "不支持的整数字段宽度");
+    return sizeof(M);
+}
+
+// 字段编码后的固定长度，变长字段返回 VARIABLE
+template <typename M, Bytes B>
+constexpr size_t fieldFixedSize() {
+    if constexpr (std::is_integral_v<M>) return scalarSize<M>();
+    else if constexpr (HasFields<M>::value) return fixedSize<M>();
+    else return VARIABLE;
+}
+
+// 字段编码后的最短长度，用于在解码列表前检查元素个数是否可信
+template <typename M, Bytes B>
+constexpr size_t fieldMinSize() {
+    if constexpr (std::is_integral_v<M>) return scalarSize<M>();
+    else if constexpr (std::is_same_v<M, std::string_view>) return B == Bytes::Short ? 2 : B == Bytes::Long ? 4 : 0;
+    else if constexpr (HasFields<M>::value) return minSize<M>();
+    else {
+        static_assert(IsVector<M>::value, "字段类型没有对应的编码");
+        return 4;
+    }
+}
+
+template <typename T>
+constexpr size_t fixedSize() {
+    return std::apply([](auto... f) {
+        size_t sizes[] = {size_t(0), fieldFixedSize<typename FieldTraits<decltype(f)>::Member,
+                                                    FieldTraits<decltype(f)>::bytes>()...};
+        size_t total = 0;
+        for (size_t s : sizes) {
+            if (s == VARIABLE) return VARIABLE;
+            total += s;
+        }
+        return total;
+    }, T::fields());
+}
+
+template <typename T>
+constexpr size_t minSize() {
+    return std::apply([](auto... f) {
+        return (size_t(0) + ... + fieldMinSize<typename FieldTraits<decltype(f)>::Member,
+                                                FieldTraits<decltype(f)>::bytes>());
+    }, T::fields());
+}
+
+template <typename T>
+size_t encodedSize(const T &msg);
+template <typename T>
+void encode(WireWriter &w, const T &msg);
+template <typename T>
+void decode(WireReader &r, T &msg);
+
+template <typename M, Bytes B>
+size_t valueSize(const M &v) {
+    if constexpr (std::is_integral_v<M>) {
+        return scalarSize<M>();
+    } else if constexpr (std::is_same_v<M, std::string_view>) {
+        size_t len = B == Bytes::Short ? std::min<size_t>(v.size(), UINT16_MAX) : v.size();
+        return fieldMinSize<M, B>() + len;
+    } else if constexpr (HasFields<M>::value) {
+        return encodedSize(v);
+    } else {
+        using E = typename M::value_type;
+        constexpr size_t each = fieldFixedSize<E, Bytes::Short>();
+        if constexpr (each != VARIABLE) {
+            return 4 + v.size() * each;
+        } else {
+            size_t total = 4;
+            for (const auto &e : v) total += valueSize<E, Bytes::Short>(e);
+            return total;
+        }
+    }
+}
+
+template <typename M, Bytes B>
+void encodeValue(WireWriter &w, const M &v) {
+    if constexpr (std::is_same_v<M, bool>) {
+        w.boolean(v);
+    } else if constexpr (std::is_integral_v<M>) {
+        if constexpr (scalarSize<M>() == 1) w.u8(static_cast<uint8_t>(v));
+        else if constexpr (scalarSize<M>() == 2) w.u16(static_cast<uint16_t>(v));
+        else w.u32(static_cast<uint32_t>(v));
+    } else if constexpr (std::is_same_v<M, std::string_view>) {
+        if constexpr (B == Bytes::Short) w.str(v);
+        else if constexpr (B == Bytes::Long) w.blob(v);
+        else w.rest(v);
+    } else if constexpr (HasFields<M>::value) {
+        encode(w, v);
+    } else {
+        w.u32(static_cast<uint32_t>(v.size()));
+        for (const auto &e : v) encodeValue<typename M::value_type, Bytes::Short>(w, e);
+    }
+}
+
+template <typename M, Bytes B>
+void decodeValue(WireReader &r, M &v) {
+    if constexpr (std::is_same_v<M, bool>) {
+        v = r.boolean();
+    } else if constexpr (std::is_integral_v<M>) {
+        if constexpr (scalarSize<M>() == 1) v = static_cast<M>(r.u8());
+        else if constexpr (scalarSize<M>() == 2) v = static_cast<M>(r.u16());
+        else v = static_cast<M>(r.u32());
+    } else if constexpr (std::is_same_v<M, std::string_view>) {
+        if constexpr (B == Bytes::Short) v = r.str();
+        else if constexpr (B == Bytes::Long) v = r.blob();
+        else v = r.rest();
+    } else if constexpr (HasFields<M>::value) {
+        decode(r, v);
+    } else {
+        // 元素个数超出剩余字节所能容纳的上限时视为格式错误，避免按伪造的个数预留内存
+        using E = typename M::value_type;
+        constexpr size_t each = std::max<size_t>(1, fieldMinSize<E, Bytes::Short>());
+        uint32_t n = r.u32();
+        if (!r.ok() || n > r.remaining() / each) {
+            r.fail();
+            return;
+        }
+        v.resize(n);
+        for (auto &e : v) decodeValue<E, Bytes::Short>(r, e);
+    }
+}
+
+template <typename T>
+size_t encodedSize(const T &msg) {
+    constexpr size_t fixed = fixedSize<T>();
+    if constexpr (fixed != VARIABLE) {
+        return fixed;
+    } else {
+        return std::apply([&msg](auto... f) {
+            return (size_t(0) + ... + valueSize<typename FieldTraits<decltype(f)>::Member,
+                                                FieldTraits<decltype(f)>::bytes>(msg.*(f.member)));
+        }, T::fields());
+    }
+}
+
+template <typename T>
+void encode(WireWriter &w, const T &msg) {
+    std::apply([&w, &msg](auto... f) {
+        (encodeValue<typename FieldTraits<decltype(f)>::Member, FieldTraits<decltype(f)>::bytes>(w, msg.*(f.member)), ...);
+    }, T::fields());
+}
+
+template <typename T>
+void decode(WireReader &r, T &msg) {
+    std::apply([&r, &msg](auto... f) {
+        (decodeValue<typename FieldTraits<decltype(f)>::Member, FieldTraits<decltype(f)>::bytes>(r, msg.*(f.member)), ...);
+    }, T::fields());
+}
+
+} // namespace wire
+
+#endif // WIRECODEC_H
@@ -0,0 +1,137 @@
+// WireFormat.h
+// 线上格式的基本读写：所有整数一律小端序，字符串带长度前缀
+// WireReader 只返回指向原缓冲区的视图，不复制数据；越界读取不抛异常也不逐字段报错，
+// 而是置失败标志并返回零值，调用方在解码结束时检查一次 ok() 即可
+#ifndef WIREFORMAT_H
+#define WIREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace wire {
+
+inline uint16_t load16(const uint8_t *p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap16(v);
+#endif
+    return v;
+}
+
+inline uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline void store16(uint8_t *p, uint16_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap16(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+inline void store32(uint8_t *p, uint32_t v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+} // namespace wire
+
+class WireReader {
+public:
+    WireReader(const uint8_t *data, size_t size) : pos(data), end(data + size), good(true) {}
+
+    bool ok() const { return good; }
+    size_t remaining() const { return static_cast<size_t>(end - pos); }
+    bool empty() const { return pos == end; }
+    // 调用方发现语义错误（如列表长度越界）时手动置失败
+    void fail() {
+        good = false;
+        pos = end;
+    }
+
+    uint8_t u8() { return take(1) ? pos[-1] : 0; }
+    uint16_t u16() { return take(2) ? wire::load16(pos - 2) : 0; }
+    uint32_t u32() { return take(4) ? wire::load32(pos - 4) : 0; }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    bool boolean() { return u8() != 0; }
+
+    // 固定长度的原始字节
+    std::string_view bytes(size_t n) {
+        const uint8_t *p = pos;
+        return take(n) ? view(p, n) : std::string_view();
+    }
+    // u16 长度前缀的短字符串（用户名、密码、群名）
+    std::string_view str() { return bytes(u16()); }
+    // u32 长度前缀的长内容（消息正文）
+    std::string_view blob() { return bytes(u32()); }
+    // 负载剩余的全部字节
+    std::string_view rest() { return bytes(remaining()); }
+
+private:
+    bool take(size_t n) {
+        if (n > remaining()) {
+            fail();
+            return false;
+        }
+        pos += n;
+        return true;
+    }
+    static std::string_view view(const uint8_t *p, size_t n) {
+        return std::string_view(reinterpret_cast<const char*>(p), n);
+    }
+
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool good;
+};
+
+// 写入调用方预先分配好的缓冲区，不做边界检查：缓冲区大小由 wire::encodedSize 事先算出（见 WireCodec.h）
+class WireWriter {
+public:
+    explicit WireWriter(uint8_t *out) : pos(out) {}
+
+    uint8_t *position() const { return pos; }
+
+    void u8(uint8_t v) { *pos++ = v; }
+    void u16(uint16_t v) { wire::store16(advance(2), v); }
+    void u32(uint32_t v) { wire::store32(advance(4), v); }
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void boolean(bool v) { u8(v ? 1 : 0); }
+
+    void bytes(const void *data, size_t n) {
+        if (n) memcpy(advance(n), data, n);
+    }
+    void bytes(std::string_view s) { bytes(s.data(), s.size()); }
+    // 超出 u16 的部分被截断，与 WireReader::str 对应
+    void str(std::string_view s) {
+        if (s.size() > UINT16_MAX) s = s.substr(0, UINT16_MAX);
+        u16(static_cast<uint16_t>(s.size()));
+        bytes(s);
+    }
+    void blob(std::string_view s) {
+        u32(static_cast<uint32_t>(s.size()));
+        bytes(s);
+    }
+    void rest(std::string_view s) { bytes(s); }
+
+private:
+    uint8_t *advance(size_t n) {
+        uint8_t *p = pos;
+        pos += n;
+        return p;
+    }
+
+    uint8_t *pos;
+};
+
+#endif // WIREFORMAT_H
@@ -0,0 +1,114 @@
+#include "Compression.h"
+#include "WireFormat.h"
+#include <zlib.h>
+#include <cstring>
+#include <ctime>
+
+namespace {
+uint64_t threadCpuNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 每个线程复用一个 deflate 流：deflateInit 要分配并清零几百 KB 的窗口与哈希表，
+// 对几 KB 的响应而言这比压缩本身还贵；deflateReset 只重置状态
+class Deflater {
+public:
+    ~Deflater() {
+        if (ready) deflateEnd(&stream);
+    }
+
+    z_stream *get(int wantLevel) {
+        if (ready && level != wantLevel) {
+            deflateEnd(&stream);
+            ready = false;
+        }
+        if (!ready) {
+            stream = z_stream{};
+            if (deflateInit(&stream, wantLevel) != Z_OK) return nullptr;
+            ready = true;
+            level = wantLevel;
+        } else if (deflateReset(&stream) != Z_OK) {
+            return nullptr;
+        }
+        return &stream;
+    }
+
+private:
+    z_stream stream{};
+    bool ready = false;
+    int level = 0;
+};
+
+// 一次性压缩到 out，结果不短于原文时视为无收益
+bool deflateInto(const uint8_t *raw, size_t len, int level, uint8_t *out, size_t capacity, size_t &written) {
+    thread_local Deflater deflater;
+    z_stream *zs = deflater.get(level);
+    if (!zs) return false;
+    zs->next_in = const_cast<Bytef*>(raw);
+    zs->avail_in = static_cast<uInt>(len);
+    zs->next_out = out;
+    zs->avail_out = static_cast<uInt>(capacity);
+    if (deflate(zs, Z_FINISH) != Z_STREAM_END) return false;
+    written = capacity - zs->avail_out;
+    return written < len;
+}
+
+std::vector<uint8_t> storeRaw(const uint8_t *raw, size_t len) {
+    std::vector<uint8_t> out(COMPRESSION_ENVELOPE_SIZE + len);
+    out[0] = CODEC_NONE;
+    wire::store32(out.data() + 1, static_cast<uint32_t>(len));
+    if (len) memcpy(out.data() + COMPRESSION_ENVELOPE_SIZE, raw, len);
+    return out;
+}
+}
+
+std::vector<uint8_t> packPayload(const uint8_t *raw, size_t len, size_t threshold, int level,
+                                 CompressionStats *stats) {
+    std::vector<uint8_t> out;
+    uint64_t start = stats ? threadCpuNanos() : 0;
+    if (len >= threshold && len <= MAX_DECOMPRESSED_SIZE) {
+        size_t bound = compressBound(static_cast<uLong>(len));
+        out.resize(COMPRESSION_ENVELOPE_SIZE + bound);
+        size_t written = 0;
+        if (deflateInto(raw, len, level, out.data() + COMPRESSION_ENVELOPE_SIZE, bound, written)) {
+            out[0] = CODEC_ZLIB;
+            wire::store32(out.data() + 1, static_cast<uint32_t>(len));
+            out.resize(COMPRESSION_ENVELOPE_SIZE + written);
+        } else {
+            out.clear();
+        }
+    }
+    bool compressed = !out.empty();
+    if (!compressed) out = storeRaw(raw, len);
+    if (stats) {
+        (compressed ? stats->compressed : stats->stored).fetch_add(1, std::memory_order_relaxed);
+        stats->rawBytes.fetch_add(len, std::memory_order_relaxed);
+        stats->wireBytes.fetch_add(out.size(), std::memory_order_relaxed);
+        stats->nanos.fetch_add(threadCpuNanos() - start, std::memory_order_relaxed);
+    }
+    return out;
+}
+
+bool unpackPayload(const uint8_t *data, size_t len, std::vector<uint8_t> &out) {
+    if (len < COMPRESSION_ENVELOPE_SIZE) return false;
+    uint8_t codec = data[0];
+    size_t rawLen = wire::load32(data + 1);
+    const uint8_t *body = data + COMPRESSION_ENVELOPE_SIZE;
+    size_t bodyLen = len - COMPRESSION_ENVELOPE_SIZE;
+    if (rawLen > MAX_DECOMPRESSED_SIZE) return false;
+    if (codec == CODEC_NONE) {
+        if (bodyLen != rawLen) return false;
+        out.assign(body, body + bodyLen);
+        return true;
+    }
+    if (codec != CODEC_ZLIB) return false;
+    out.resize(rawLen);
+    uLongf written = static_cast<uLongf>(rawLen);
+    if (uncompress(out.data(), &written, body, static_cast<uLong>(bodyLen)) != Z_OK || written != rawLen) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
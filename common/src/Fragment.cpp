@@ -0,0 +1,132 @@
+#include "Fragment.h"
+#include "WireFormat.h"
+#include <algorithm>
+#include <cstring>
+
+using wire::load16;
+using wire::load32;
+using wire::store16;
+using wire::store32;
+
+namespace {
+constexpr size_t ACK_FIXED_SIZE = 6;
+constexpr size_t RECENT_COMPLETED = 64;
+}
+
+void encodeFragmentHeader(const FragmentHeader &hdr, uint8_t *out) {
+    store32(out, hdr.transferId);
+    out[4] = hdr.type;
+    store16(out + 5, hdr.index);
+    store16(out + 7, hdr.count);
+    store32(out + 9, hdr.totalLength);
+}
+
+bool decodeFragmentHeader(const uint8_t *data, size_t len, FragmentHeader &hdr) {
+    if (len < FRAGMENT_HEADER_SIZE) return false;
+    hdr.transferId = load32(data);
+    hdr.type = data[4];
+    hdr.index = load16(data + 5);
+    hdr.count = load16(data + 7);
+    hdr.totalLength = load32(data + 9);
+    // 分片数量须与总长度吻合，且编号在范围内
+    if (hdr.count == 0 || hdr.index >= hdr.count) return false;
+    size_t maxLen = static_cast<size_t>(hdr.count) * FRAGMENT_PAYLOAD_SIZE;
+    size_t minLen = static_cast<size_t>(hdr.count - 1) * FRAGMENT_PAYLOAD_SIZE;
+    return hdr.totalLength <= maxLen && (hdr.count == 1 || hdr.totalLength > minLen);
+}
+
+std::vector<uint8_t> encodeFragmentAck(const FragmentAck &ack) {
+    std::vector<uint8_t> out(ACK_FIXED_SIZE + ack.bitmap.size());
+    store32(out.data(), ack.transferId);
+    store16(out.data() + 4, ack.base);
+    if (!ack.bitmap.empty()) memcpy(out.data() + ACK_FIXED_SIZE, ack.bitmap.data(), ack.bitmap.size());
+    return out;
+}
+
+bool decodeFragmentAck(const uint8_t *data, size_t len, FragmentAck &ack) {
+    if (len < ACK_FIXED_SIZE || len > ACK_FIXED_SIZE + SACK_WINDOW / 8) return false;
+    ack.transferId = load32(data);
+    ack.base = load16(data + 4);
+    ack.bitmap.assign(data + ACK_FIXED_SIZE, data + len);
+    return true;
+}
+
+bool SackBitmap::set(size_t i) {
+    if (i >= total || test(i)) return false;
+    words[i / 64] |= uint64_t(1) << (i % 64);
+    ++received;
+    return true;
+}
+
+size_t SackBitmap::firstMissing() const {
+    for (size_t w = 0; w < words.size(); ++w) {
+        uint64_t missing = ~words[w];
+        if (missing) return std::min(total, w * 64 + __builtin_ctzll(missing));
+    }
+    return total;
+}
+
+FragmentAck SackBitmap::toAck(uint32_t transferId) const {
+    FragmentAck ack;
+    ack.transferId = transferId;
+    size_t base = firstMissing();
+    ack.base = static_cast<uint16_t>(base);
+    size_t window = std::min(SACK_WINDOW, total - base);
+    ack.bitmap.assign((window + 7) / 8, 0);
+    for (size_t j = 1; j < window; ++j)
+        if (test(base + j)) ack.bitmap[j / 8] |= static_cast<uint8_t>(1u << (j % 8));
+    return ack;
+}
+
+void SackBitmap::apply(const FragmentAck &ack) {
+    size_t base = std::min<size_t>(ack.base, total);
+    for (size_t i = firstMissing(); i < base; ++i) set(i);
+    for (size_t j = 0; j < ack.bitmap.size() * 8; ++j)
+        if (ack.bitmap[j / 8] >> (j % 8) & 1) set(base + j);
+}
+
+bool Reassembler::add(const uint8_t *data, size_t len, uint8_t &type, std::vector<uint8_t> &payload,
+                      std::vector<uint8_t> &ack) {
+    ack.clear();
+    FragmentHeader hdr;
+    if (!decodeFragmentHeader(data, len, hdr)) return false;
+    const uint8_t *chunk = data + FRAGMENT_HEADER_SIZE;
+    size_t chunkLen = len - FRAGMENT_HEADER_SIZE;
+    size_t offset = static_cast<size_t>(hdr.index) * FRAGMENT_PAYLOAD_SIZE;
+    if (chunkLen != std::min(FRAGMENT_PAYLOAD_SIZE, hdr.totalLength - offset)) return false;
+
+    // 已完成传输的重传分片：说明发送端没收到最终确认，再确认一次
+    if (std::find(recentlyCompleted.begin(), recentlyCompleted.end(), hdr.transferId) != recentlyCompleted.end()) {
+        ack = encodeFragmentAck(FragmentAck{hdr.transferId, hdr.count, {}});
+        return false;
+    }
+
+    auto it = transfers.find(hdr.transferId);
+    if (it == transfers.end()) {
+        it = transfers.emplace(hdr.transferId, Transfer{hdr.type, SackBitmap(hdr.count), {}}).first;
+        it->second.buffer.resize(hdr.totalLength);
+    }
+    Transfer &t = it->second;
+    if (t.type != hdr.type || t.received.size() != hdr.count || t.buffer.size() != hdr.totalLength) return false;
+
+    if (t.received.set(hdr.index)) memcpy(t.buffer.data() + offset, chunk, chunkLen);
+
+    if (t.received.complete()) {
+        type = t.type;
+        payload = std::move(t.buffer);
+        ack = encodeFragmentAck(FragmentAck{hdr.transferId, hdr.count, {}});
+        transfers.erase(it);
+        if (recentlyCompleted.size() >= RECENT_COMPLETED) recentlyCompleted.erase(recentlyCompleted.begin());
+        recentlyCompleted.push_back(hdr.transferId);
+        return true;
+    }
+    // 末尾分片已到但仍有缺口，立即报告缺失情况
+    if (hdr.index == hdr.count - 1) ack = encodeFragmentAck(t.received.toAck(hdr.transferId));
+    return false;
+}
+
+std::vector<std::vector<uint8_t>> Reassembler::pendingAcks() const {
+    std::vector<std::vector<uint8_t>> acks;
+    for (const auto &kv : transfers) acks.push_back(encodeFragmentAck(kv.second.received.toAck(kv.first)));
+    return acks;
+}
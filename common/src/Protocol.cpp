@@ -0,0 +1,140 @@
+// Protocol.cpp
+// 协议头与紧凑列表的编解码；其余消息负载的编解码由 WireCodec.h 按字段表生成
+
+#include "Protocol.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// ok u8 + count u32
+constexpr size_t COMPACT_LIST_PREFIX = 5;
+
+// 升序 ID 差值的总长度；差值按 32 位无符号回绕计算，负数 ID 同样能正确往返
+template <typename E, typename Id>
+size_t deltaBytes(const std::vector<E> &entries, Id id) {
+    size_t total = 0;
+    uint32_t prev = 0;
+    for (const auto &e : entries) {
+        uint32_t cur = static_cast<uint32_t>(e.*id);
+        total += varint::size(cur - prev);
+        prev = cur;
+    }
+    return total;
+}
+
+template <typename E, typename Id>
+uint8_t *putDeltas(uint8_t *p, const std::vector<E> &entries, Id id) {
+    uint32_t prev = 0;
+    for (const auto &e : entries) {
+        uint32_t cur = static_cast<uint32_t>(e.*id);
+        p = varint::put(p, cur - prev);
+        prev = cur;
+    }
+    return p;
+}
+
+// 读出 ok 与条目数；条目数超过剩余字节时视为格式错误（每个差值至少 1 字节），避免按伪造的个数分配
+bool readCompactPrefix(WireReader &r, bool &ok, uint32_t &count) {
+    ok = r.boolean();
+    count = r.u32();
+    return r.ok() && count <= r.remaining();
+}
+}
+
+void encodeHeader(const PacketHeader &hdr, uint8_t *out) {
+    wire::store16(out, PROTOCOL_MAGIC);
+    out[2] = hdr.version;
+    out[3] = hdr.type;
+    wire::store16(out + 4, hdr.flags);
+    wire::store16(out + 6, 0);
+    wire::store32(out + 8, hdr.requestId);
+    wire::store32(out + 12, hdr.length);
+}
+
+bool decodeHeader(const uint8_t *data, size_t len, PacketHeader &hdr) {
+    if (len < PACKET_HEADER_SIZE) return false;
+    uint32_t word = wire::load32(data);
+    hdr.version = static_cast<uint8_t>(word >> 16);
+    hdr.type = static_cast<uint8_t>(word >> 24);
+    hdr.flags = wire::load16(data + 4);
+    hdr.requestId = wire::load32(data + 8);
+    hdr.length = wire::load32(data + 12);
+    return (word & 0xFFFF) == PROTOCOL_MAGIC && hdr.version >= PROTOCOL_MIN_VERSION &&
+           hdr.version <= PROTOCOL_VERSION && hdr.length == len - PACKET_HEADER_SIZE;
+}
+
+std::vector<uint8_t> buildPacket(uint8_t type, uint32_t requestId, const uint8_t *payload, size_t len,
+                                 uint16_t flags, uint8_t version) {
+    std::vector<uint8_t> packet(PACKET_HEADER_SIZE + len);
+    encodeHeader(PacketHeader{ type, flags, requestId, static_cast<uint32_t>(len), version }, packet.data());
+    if (len) memcpy(packet.data() + PACKET_HEADER_SIZE, payload, len);
+    return packet;
+}
+
+std::vector<uint8_t> encodeCompact(FriendListResp msg) {
+    auto &friends = msg.friends;
+    std::sort(friends.begin(), friends.end(),
+              [](const FriendEntry &a, const FriendEntry &b) { return a.friendId < b.friendId; });
+    size_t bitmapBytes = (friends.size() + 7) / 8;
+    std::vector<uint8_t> out(COMPACT_LIST_PREFIX + bitmapBytes + deltaBytes(friends, &FriendEntry::friendId));
+    WireWriter w(out.data());
+    w.boolean(msg.ok);
+    w.u32(static_cast<uint32_t>(friends.size()));
+    uint8_t *bitmap = w.position();
+    for (size_t i = 0; i < friends.size(); ++i)
+        if (friends[i].blocked) bitmap[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+    putDeltas(bitmap + bitmapBytes, friends, &FriendEntry::friendId);
+    return out;
+}
+
+std::vector<uint8_t> encodeCompact(FriendRequestListResp msg) {
+    auto &requests = msg.requests;
+    std::sort(requests.begin(), requests.end(),
+              [](const FriendRequestEntry &a, const FriendRequestEntry &b) { return a.requestId < b.requestId; });
+    size_t senderBytes = 0;
+    for (const auto &r : requests) senderBytes += varint::size(static_cast<uint32_t>(r.fromUserId));
+    std::vector<uint8_t> out(COMPACT_LIST_PREFIX + deltaBytes(requests, &FriendRequestEntry::requestId) + senderBytes);
+    WireWriter w(out.data());
+    w.boolean(msg.ok);
+    w.u32(static_cast<uint32_t>(requests.size()));
+    uint8_t *p = putDeltas(w.position(), requests, &FriendRequestEntry::requestId);
+    for (const auto &r : requests) p = varint::put(p, static_cast<uint32_t>(r.fromUserId));
+    return out;
+}
+
+bool decodeCompact(const uint8_t *data, size_t len, FriendListResp &msg) {
+    WireReader r(data, len);
+    uint32_t count;
+    if (!readCompactPrefix(r, msg.ok, count)) return false;
+    std::string_view bitmap = r.bytes((count + 7) / 8);
+    std::string_view deltas = r.rest();
+    if (!r.ok()) return false;
+
+    std::vector<uint32_t> ids(count);
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(deltas.data());
+    if (!varint::decodeDeltas(p, p + deltas.size(), count, ids.data())) return false;
+    msg.friends.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        msg.friends[i] = {static_cast<int32_t>(ids[i]), (static_cast<uint8_t>(bitmap[i / 8]) >> (i % 8) & 1) != 0};
+    return true;
+}
+
+bool decodeCompact(const uint8_t *data, size_t len, FriendRequestListResp &msg) {
+    WireReader r(data, len);
+    uint32_t count;
+    if (!readCompactPrefix(r, msg.ok, count)) return false;
+    std::string_view body = r.rest();
+
+    std::vector<uint32_t> ids(count);
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(body.data());
+    const uint8_t *end = p + body.size();
+    if (!varint::decodeDeltas(p, end, count, ids.data())) return false;
+    msg.requests.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t from;
+        if (!varint::get(p, end, from)) return false;
+        msg.requests[i] = {static_cast<int32_t>(ids[i]), static_cast<int32_t>(from)};
+    }
+    return true;
+}
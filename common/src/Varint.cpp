@@ -0,0 +1,84 @@
+#include "Varint.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace varint {
+
+namespace {
+#if defined(__SSE2__)
+constexpr size_t BLOCK = 16;
+
+// 16 个单字节差值：扩展成 16 位求块内前缀和（最大 16 * 127，不会溢出），再扩展成 32 位加上块前的 ID
+inline uint32_t decodeBlock(const uint8_t *p, uint32_t base, uint32_t *out) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 2));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 2));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 4));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 4));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 8));
+    hi = _mm_add_epi16(hi, _mm_set1_epi16(static_cast<short>(_mm_extract_epi16(lo, 7))));
+
+    const __m128i b = _mm_set1_epi32(static_cast<int>(base));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), b));
+    return base + static_cast<uint32_t>(_mm_extract_epi16(hi, 7));
+}
+
+// 块内没有续位字节，即全部是单字节差值
+inline bool singleBytes(const uint8_t *p) {
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0;
+}
+#else
+constexpr size_t BLOCK = 8;
+
+// 没有 SSE2 时按 64 位字检查，8 个单字节差值逐个累加
+inline uint32_t decodeBlock(const uint8_t *p, uint32_t base, uint32_t *out) {
+    for (size_t i = 0; i < BLOCK; ++i) out[i] = base += p[i];
+    return base;
+}
+
+inline bool singleBytes(const uint8_t *p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return (w & 0x8080808080808080ULL) == 0;
+}
+#endif
+}
+
+bool decodeDeltas(const uint8_t *&p, const uint8_t *end, size_t count, uint32_t *out) {
+    const uint8_t *q = p;
+    uint32_t id = 0;
+    size_t i = 0;
+    // 快速路径：剩余差值与字节都够一整块时先检查续位，块内全是单字节差值（ID 密集）就整块向量化；
+    // 否则接下来一块数量的差值按标量解码再重新检查，稀疏列表只多出每块一次的掩码检查
+    while (count - i >= BLOCK && static_cast<size_t>(end - q) >= BLOCK) {
+        if (singleBytes(q)) {
+            id = decodeBlock(q, id, out + i);
+            q += BLOCK;
+            i += BLOCK;
+            continue;
+        }
+        for (size_t stop = i + BLOCK; i < stop; ++i) {
+            uint32_t delta;
+            if (!get(q, end, delta)) return false;
+            out[i] = id += delta;
+        }
+    }
+    for (; i < count; ++i) {
+        uint32_t delta;
+        if (!get(q, end, delta)) return false;
+        out[i] = id += delta;
+    }
+    p = q;
+    return true;
+}
+
+} // namespace varint
@@ -0,0 +1,109 @@
+// CompressionBench.cpp
+// 大响应负载压缩（Compression.h，zlib，级别与阈值取 Config.h）的压缩率与 CPU 开销：
+// 按不同消息条数生成聊天记录响应，编码后打包成压缩封装，统计封装后的字节数、每次打包与解包的线程 CPU 时间
+// 另列每次调用都新建 deflate 流（zlib compress2）的打包时间，对比 packPayload 在线程内复用流的收益
+// 用法：bench_compression [每项迭代次数=2000]
+#include "Compression.h"
+#include "Config.h"
+#include "Protocol.h"
+#include <zlib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 聊天内容：常用短句拼接并带上序号，长短不一，与真实聊天记录一样有大量重复片段
+const char *const PHRASES[] = {
+    "好的，没问题", "晚上一起吃饭吗？", "刚到公司", "那个文件我发你邮箱了，记得看一下",
+    "哈哈哈哈", "明天上午十点开会，别忘了", "ok", "收到", "你看到群里的通知了吗",
+    "周末去爬山，天气预报说是晴天", "see you tomorrow", "the build is green again, merging now",
+};
+constexpr size_t PHRASE_COUNT = sizeof(PHRASES) / sizeof(PHRASES[0]);
+
+std::vector<std::string> makeBodies(size_t count) {
+    std::vector<std::string> bodies;
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < count; ++i) {
+        std::string s;
+        size_t parts = 1 + i % 3;
+        for (size_t p = 0; p < parts; ++p) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            s += PHRASES[x % PHRASE_COUNT];
+            s += ' ';
+        }
+        s += std::to_string(i);
+        bodies.push_back(std::move(s));
+    }
+    return bodies;
+}
+
+uint64_t threadCpuNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 防止编译器把结果未被使用的循环整个删掉
+volatile size_t sink;
+
+// 返回每次调用的线程 CPU 时间（微秒）
+template <typename Fn>
+double usPerOp(long iterations, Fn fn) {
+    size_t acc = 0;
+    for (long i = 0; i < iterations / 10 + 1; ++i) acc += fn();  // 预热：线程内的 deflate 流与分配器
+    uint64_t start = threadCpuNanos();
+    for (long i = 0; i < iterations; ++i) acc += fn();
+    double us = static_cast<double>(threadCpuNanos() - start) / 1000.0;
+    sink = acc;
+    return us / iterations;
+}
+
+void benchHistory(size_t count, long iterations) {
+    std::vector<std::string> bodies = makeBodies(count);
+    ChatHistoryResp resp{true, {}};
+    for (size_t i = 0; i < count; ++i) resp.messages.push_back({i % 2 ? 17 : 42, bodies[i]});
+    std::vector<uint8_t> raw = encodeMessage(resp);
+
+    std::vector<uint8_t> wire = packPayload(raw.data(), raw.size(), COMPRESS_THRESHOLD, COMPRESS_LEVEL);
+    std::vector<uint8_t> check;
+    if (!unpackPayload(wire.data(), wire.size(), check) || check != raw) {
+        printf("%6zu 解包结果与原始负载不一致\n", count);
+        return;
+    }
+
+    double pack = usPerOp(iterations, [&] {
+        return packPayload(raw.data(), raw.size(), COMPRESS_THRESHOLD, COMPRESS_LEVEL).size();
+    });
+    std::vector<uint8_t> out;
+    double unpack = usPerOp(iterations, [&] {
+        return unpackPayload(wire.data(), wire.size(), out) ? out.size() : 0;
+    });
+    std::vector<uint8_t> scratch(compressBound(static_cast<uLong>(raw.size())));
+    double oneShot = usPerOp(iterations, [&] {
+        uLongf n = static_cast<uLongf>(scratch.size());
+        compress2(scratch.data(), &n, raw.data(), static_cast<uLong>(raw.size()), COMPRESS_LEVEL);
+        return static_cast<size_t>(n);
+    });
+
+    printf("%6zu %8zu %8zu %7.2f %6s %9.1f us %9.1f us %9.1f us\n", count, raw.size(), wire.size(),
+           static_cast<double>(wire.size()) / raw.size(), wire[0] == CODEC_ZLIB ? "zlib" : "none", pack, unpack,
+           oneShot);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000;
+    if (iterations <= 0) iterations = 1;
+
+    printf("%ld iterations per row, zlib level %d, threshold %d bytes\n", iterations, COMPRESS_LEVEL,
+           COMPRESS_THRESHOLD);
+    printf("%6s %8s %8s %7s %6s %12s %12s %12s\n", "msgs", "raw", "wire", "ratio", "codec", "pack", "unpack",
+           "compress2");
+    for (size_t count : {5, 20, 100, 500})
+        benchHistory(count, iterations);
+    return 0;
+}
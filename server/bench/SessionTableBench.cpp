@@ -0,0 +1,140 @@
+// SessionTableBench.cpp
+// 在线会话表与它取代的 mutex + unordered_map 的并发对比：多个线程按给定比例混合执行
+// 查找（消息推送）、心跳刷新与登录/退出，统计总吞吐
+// 用法：bench_session_table [线程数=32] [每项时长毫秒=1000]
+#include "SessionTable.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int USERS = 100000;
+
+// 替换前的实现：一把全局锁保护的在线表
+class LegacySessions {
+public:
+    bool insert(int userId, const sockaddr_in &addr, uint32_t now) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return clients.emplace(userId, Entry{{userId, addr}, now}).second;
+    }
+    bool erase(int userId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return clients.erase(userId) > 0;
+    }
+    bool lookup(int userId, sockaddr_in &addr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = clients.find(userId);
+        if (it == clients.end()) return false;
+        addr = it->second.info.addr;
+        return true;
+    }
+    bool touch(int userId, const sockaddr_in &, uint32_t now) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = clients.find(userId);
+        if (it == clients.end()) return false;
+        it->second.lastSeen = now;
+        return true;
+    }
+
+private:
+    struct ClientInfo {
+        int userId;
+        sockaddr_in addr;
+    };
+    struct Entry {
+        ClientInfo info;
+        uint32_t lastSeen;
+    };
+    std::mutex mutex;
+    std::unordered_map<int, Entry> clients;
+};
+
+struct Mix {
+    const char *name;
+    unsigned touchPct;  // 心跳刷新占比
+    unsigned churnPct;  // 退出后立即重新登录占比，其余为查找
+};
+
+sockaddr_in addrOf(int userId) {
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(0x0A000000u | static_cast<uint32_t>(userId));
+    a.sin_port = htons(static_cast<uint16_t>(10000 + userId % 50000));
+    return a;
+}
+
+template <typename Table>
+double run(Table &table, const Mix &mix, unsigned threads, std::chrono::milliseconds duration) {
+    std::atomic<bool> go{false}, stop{false};
+    std::vector<uint64_t> counts(threads * 8, 0);  // 每个线程的计数隔开一个缓存行
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t x = 0x9E3779B97F4A7C15ull * (t + 1), ops = 0;
+            sockaddr_in addr;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 256; ++i) {
+                    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                    int user = static_cast<int>(x % USERS);
+                    unsigned roll = static_cast<unsigned>((x >> 32) % 100);
+                    if (roll < mix.churnPct) {
+                        if (table.erase(user)) table.insert(user, addrOf(user), static_cast<uint32_t>(ops));
+                    } else if (roll < mix.churnPct + mix.touchPct) {
+                        table.touch(user, addrOf(user), static_cast<uint32_t>(ops));
+                    } else {
+                        table.lookup(user, addr);
+                    }
+                }
+                ops += 256;
+            }
+            counts[t * 8] = ops;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto &w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t total = 0;
+    for (unsigned t = 0; t < threads; ++t) total += counts[t * 8];
+    return total / secs / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    unsigned threads = argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 32;
+    std::chrono::milliseconds duration(argc > 2 ? atoi(argv[2]) : 1000);
+    if (threads == 0) threads = 1;
+
+    SessionTable table;
+    LegacySessions legacy;
+    for (int u = 0; u < USERS; ++u) {
+        table.insert(u, addrOf(u));
+        legacy.insert(u, addrOf(u), 0);
+    }
+
+    const Mix mixes[] = {
+        {"lookup only", 0, 0},
+        {"push 90/touch 8/login 2", 8, 2},
+        {"touch heavy 50/50", 50, 0},
+    };
+    printf("%u threads, %d online users, %lld ms per run, hardware threads: %u\n", threads, USERS,
+           static_cast<long long>(duration.count()), std::thread::hardware_concurrency());
+    printf("%-26s %16s %16s %8s\n", "workload", "SessionTable", "mutex+map", "speedup");
+    for (const Mix &mix : mixes) {
+        double a = run(table, mix, threads, duration);
+        double b = run(legacy, mix, threads, duration);
+        printf("%-26s %11.2f Mop/s %11.2f Mop/s %7.2fx\n", mix.name, a, b, a / b);
+    }
+    return 0;
+}
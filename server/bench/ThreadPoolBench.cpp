@@ -0,0 +1,166 @@
+// ThreadPoolBench.cpp
+// 工作窃取线程池与它取代的单队列线程池（一把互斥锁 + 一个 FIFO + 条件变量）在不同工作线程数下的吞吐对比
+//   inject   外部线程逐个提交任务，相当于收包线程把数据报交给工作线程
+//   fan-out  外部线程提交的任务在工作线程上再提交若干后续任务，相当于处理函数派生编码、推送等工作
+// 两种负载都限制在途任务数，提交方不会把队列灌满而触发丢弃
+// 用法：bench_thread_pool [每轮任务数=200000] [每个任务的计算量=200]
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 替换前的实现（只保留一个调度类，不设容量上限）：所有线程在同一把锁上取任务，每次入队都可能唤醒一个线程
+class LegacyPool {
+public:
+    explicit LegacyPool(size_t workerCount) {
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] {
+                for (;;) {
+                    Job job;
+                    {
+                        std::unique_lock<std::mutex> lock(queueMutex);
+                        condition.wait(lock, [this] { return stop || !jobs.empty(); });
+                        if (stop && jobs.empty()) return;
+                        job = std::move(jobs.front());
+                        jobs.pop_front();
+                    }
+                    uint64_t waited = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - job.enqueued).count());
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                    waitUs.fetch_add(waited, std::memory_order_relaxed);
+                    job.task();
+                }
+            });
+        }
+    }
+    ~LegacyPool() { shutdown(); }
+
+    bool enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            jobs.push_back(Job{std::move(task), std::chrono::steady_clock::now()});
+        }
+        condition.notify_one();
+        return true;
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto &w : workers)
+            if (w.joinable()) w.join();
+    }
+
+private:
+    struct Job {
+        std::function<void()> task;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    bool stop = false;
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> waitUs{0};
+};
+
+constexpr uint64_t WINDOW = 4096;  // 在途任务上限，小于注入队列大小
+constexpr unsigned FANOUT = 7;     // fan-out 负载中每个外部任务派生的后续任务数
+
+std::atomic<uint64_t> checksum{0};
+
+// 模拟处理一个请求的计算，结果参与比较以免被优化掉
+void work(uint64_t seed, unsigned units) {
+    uint64_t x = seed | 1;
+    for (unsigned i = 0; i < units; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    }
+    if (x == 0) checksum.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct Context {
+    std::atomic<uint64_t> done{0};
+    unsigned units;
+};
+
+// 新线程池用 Task 提交，与服务端的热路径相同
+template <typename F>
+void submit(ThreadPool &pool, F &&f) { pool.enqueue(Task(std::forward<F>(f))); }
+template <typename F>
+void submit(LegacyPool &pool, F &&f) { pool.enqueue(std::function<void()>(std::forward<F>(f))); }
+
+template <typename Pool>
+void spawnChildren(Pool &pool, Context &ctx, uint64_t seed) {
+    for (unsigned c = 1; c <= FANOUT; ++c)
+        submit(pool, [&ctx, seed, c] {
+            work(seed * 31 + c, ctx.units);
+            ctx.done.fetch_add(1, std::memory_order_relaxed);
+        });
+}
+
+// 返回每秒完成的任务数（百万）
+template <typename Pool>
+double run(size_t workerCount, bool fanout, uint64_t tasks, unsigned units) {
+    Context ctx;
+    ctx.units = units;
+    Pool pool(workerCount);
+    uint64_t perRoot = fanout ? FANOUT + 1 : 1;
+    uint64_t roots = tasks / perRoot;
+    uint64_t total = roots * perRoot;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < roots; ++i) {
+        while ((i + 1) * perRoot - ctx.done.load(std::memory_order_relaxed) > WINDOW) std::this_thread::yield();
+        if (fanout) {
+            submit(pool, [&pool, &ctx, i] {
+                spawnChildren(pool, ctx, i);
+                work(i, ctx.units);
+                ctx.done.fetch_add(1, std::memory_order_relaxed);
+            });
+        } else {
+            submit(pool, [&ctx, i] {
+                work(i, ctx.units);
+                ctx.done.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    }
+    while (ctx.done.load(std::memory_order_relaxed) < total) std::this_thread::yield();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pool.shutdown();
+    return total / secs / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint64_t tasks = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    unsigned units = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : 200;
+    if (tasks < FANOUT + 1) tasks = FANOUT + 1;
+
+    printf("%llu tasks per run, %u work units per task, hardware threads: %u\n",
+           static_cast<unsigned long long>(tasks), units, std::thread::hardware_concurrency());
+    printf("%8s %14s %14s %7s %14s %14s %7s\n", "workers", "inject new", "inject old", "", "fan-out new",
+           "fan-out old", "");
+    for (size_t workers : {1, 2, 4, 8, 16, 32, 64}) {
+        double a = run<ThreadPool>(workers, false, tasks, units);
+        double b = run<LegacyPool>(workers, false, tasks, units);
+        double c = run<ThreadPool>(workers, true, tasks, units);
+        double d = run<LegacyPool>(workers, true, tasks, units);
+        printf("%8zu %8.2f Mt/s %8.2f Mt/s %6.2fx %8.2f Mt/s %8.2f Mt/s %6.2fx\n", workers, a, b, a / b, c, d, c / d);
+    }
+    return 0;
+}
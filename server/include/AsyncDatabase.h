@@ -0,0 +1,111 @@
+// AsyncDatabase.h
+// 异步数据库接口：DatabaseManager 只在一个专用的存储线程上使用，其他线程提交操作后立即返回
+// SQLite 连接本身串行，多个线程访问只会在锁上排队；改由一个线程独占连接，工作线程不再因数据库锁与磁盘 I/O 睡眠
+// 存储线程每轮取出队列中已积压的操作（至多 maxBatch 个），在同一事务中依次执行后提交一次（group commit），
+// 写入越密集每次提交摊到的操作越多；操作按提交顺序执行，同一用户的请求自然保持顺序
+// 各操作的完成回调在本轮事务提交之后才执行，回复发出时对应的写入已经落盘
+// 合并的事务提交失败时整批回滚，再把其中的操作逐个在各自的事务中重新执行，一个坏操作不会连累同批的其他操作；
+// 因此操作可能执行不止一次，提交之前不应改动内存状态（会话表等），这类改动放到完成回调中；
+// 完成回调只对最后一次执行调用一次，参数为该次执行是否已提交
+// 队列满时提交方阻塞等待，与流水线其他阶段一样把背压传回线程池（见 Stage.h）
+#ifndef ASYNCDATABASE_H
+#define ASYNCDATABASE_H
+
+#include "DatabaseManager.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct StorageStats {
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> blocked{0};        // 队列满而阻塞等待的提交
+    std::atomic<uint64_t> maxDepth{0};
+    std::atomic<uint64_t> transactions{0};
+    std::atomic<uint64_t> maxBatch{0};       // 单个事务执行的最多操作数
+    std::atomic<uint64_t> failedCommits{0};  // 提交失败而回滚的事务数
+    std::atomic<uint64_t> retriedOps{0};     // 因合并的事务失败而逐个重新执行的操作数
+    std::atomic<uint64_t> failedOps{0};      // 单独执行仍提交失败的操作数
+    std::atomic<uint64_t> waitUs{0};         // 各操作累计排队时长
+    std::atomic<uint64_t> runUs{0};          // 各事务累计执行时长（含提交）
+};
+
+class AsyncDatabase {
+public:
+    // 事务结束后执行的回调，可为空；committed 为 false 时操作的写入已回滚
+    using Commit = std::function<void(bool committed)>;
+    // 在存储线程上执行的操作，返回所在事务结束后要执行的回调
+    using Op = std::function<Commit(DatabaseManager &)>;
+
+    // capacity 为队列长度，maxBatch 为一个事务最多合并的操作数（1 表示每个操作单独提交）
+    AsyncDatabase(const std::string &dbFile, size_t capacity, size_t maxBatch);
+    ~AsyncDatabase();
+
+    AsyncDatabase(const AsyncDatabase &) = delete;
+    AsyncDatabase &operator=(const AsyncDatabase &) = delete;
+
+    // 建表，须在提交任何操作之前调用
+    bool init();
+
+    // 停止后提交的操作在调用线程上单独成一个事务执行
+    void post(Op op);
+
+    // fn(DatabaseManager &) 在存储线程上执行，其结果在事务提交后交给 done，提交失败时不调用 done；
+    // done 也在存储线程上执行，应只做内存状态的改动或把结果转交给下游（如编码阶段），不做耗时的工作
+    template <typename Fn, typename Done>
+    void submit(Fn fn, Done done) {
+        post(makeOp(std::move(fn), std::move(done)));
+    }
+
+    // 把 fn 与 done 组合成一个操作，供需要先收集操作再统一提交的调用方使用
+    template <typename Fn, typename Done>
+    static Op makeOp(Fn fn, Done done) {
+        return [fn = std::move(fn), done = std::move(done)](DatabaseManager &db) mutable -> Commit {
+            using Result = std::decay_t<std::invoke_result_t<Fn &, DatabaseManager &>>;
+            Result result = fn(db);
+            return [done, result = std::move(result)](bool committed) mutable {
+                if (committed) done(result);
+            };
+        };
+    }
+
+    // 执行完已排队的操作后退出存储线程，可重复调用
+    void shutdown();
+
+    size_t capacity() const { return queueCapacity; }
+    size_t maxBatch() const { return batchLimit; }
+    size_t depth() const { return queued.load(std::memory_order_relaxed); }
+    const StorageStats &stats() const { return storageStats; }
+
+private:
+    struct Item {
+        Op op;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void run();
+    // 在单独的事务中执行一个操作并调用其回调，返回是否提交成功
+    bool runAlone(Op &op);
+
+    DatabaseManager db;
+    size_t queueCapacity;
+    size_t batchLimit;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Item> queue;
+    std::atomic<size_t> queued;
+    bool stop = false;
+    StorageStats storageStats;
+    std::thread thread;  // 最后构造：线程启动时其余成员均已就绪
+};
+
+#endif // ASYNCDATABASE_H
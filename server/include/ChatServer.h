@@ -2,64 +2,173 @@
 #define CHATSERVER_H
 
 #include "ThreadPool.h"
-#include "DatabaseManager.h"
+#include "LaneExecutor.h"
+#include "Stage.h"
+#include "AsyncDatabase.h"
 #include "Protocol.h"
+#include "Listener.h"
+#include "EgressQueue.h"
+#include "FragmentSender.h"
+#include "PacketBuffer.h"
+#include "SessionTable.h"
+#include "RateLimiter.h"
+#include "TimingWheel.h"
+#include "SingleFlight.h"
+#include "ResponseCache.h"
+#include "Compression.h"
+#include "MultiReply.h"
+#include "Config.h"
 #include <netinet/in.h>
-#include <unordered_map>
-#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string_view>
 #include <vector>
 
-struct ClientInfo {
-    int userId;
+// 服务器运行参数，默认值取自 Config.h
+struct ServerOptions {
+    size_t recvBatchSize = RECV_BATCH_SIZE;
+    size_t recvRingSlots = RECV_RING_SLOTS;
+    size_t egressBatchSize = EGRESS_BATCH_SIZE;
+    unsigned egressFlushUs = EGRESS_FLUSH_US;
+    size_t listenerCount = LISTENER_COUNT;   // >1 时启用 SO_REUSEPORT 多监听器
+    bool pinListeners = PIN_LISTENERS;
+    int transport = TRANSPORT_BACKEND;       // 0 = epoll，1 = io_uring
+    bool hugePages = POOL_HUGE_PAGES;        // 缓冲池 slab 优先使用大页
+    size_t workerCount = WORKER_THREADS;
+    size_t queueCapacity = QUEUE_CAPACITY;   // 线程池任务队列容量，0 表示不限制
+    OverflowPolicy overloadPolicy = static_cast<OverflowPolicy>(OVERLOAD_POLICY);
+    bool rateLimit = RATE_LIMIT_ENABLED;     // 按来源地址与 userId 限速
+    bool compression = COMPRESSION_ENABLED;  // 同意客户端协商的负载压缩
+    bool priorityScheduling = PRIORITY_SCHEDULING;  // 按请求类型分类调度（见 Dispatch.h）
+    bool userLanes = USER_LANES;             // 同一用户的请求串行执行（见 LaneExecutor.h）
+    size_t encodeThreads = ENCODE_THREADS;    // 流水线编码阶段的线程数（见 Stage.h）
+    size_t dbBatch = DB_BATCH_MAX;            // 存储阶段一个事务最多合并的操作数（见 AsyncDatabase.h）
+};
+
+// 一个入站请求：header 为解析出的协议头，body 是指向接收缓冲区的只读视图，
+// packet 持有该缓冲区的引用，处理函数可复制它以延长缓冲区生命周期（如原样转发负载）
+// MULTI_REQ 的子请求共享外层数据报的缓冲区，multi 非空时响应交给它汇总，subIndex 为子请求下标
+// key 为请求的串行键（见 requestKey），决定请求在流水线各阶段由哪个线程处理；子请求沿用外层的 key
+// storeBatch 非空时存储阶段的操作先收集到这里，由 handleMulti 合并成一个操作，保证在同一事务中执行
+struct Request {
     sockaddr_in addr;
+    PacketHeader header;
+    ByteView body;
+    PacketRef packet;
+    std::shared_ptr<MultiReply> multi;
+    uint16_t subIndex = 0;
+    uint64_t key = 0;
+    std::vector<AsyncDatabase::Op> *storeBatch = nullptr;
 };
 
+// start() 在主线程运行控制事件循环，收到 SIGINT/SIGTERM 后排空在途任务再返回；
+// 调用方须在构造 ChatServer（创建任何线程）之前用 blockSignals 屏蔽这两个信号
 class ChatServer {
 public:
-    ChatServer(int port, const std::string &dbFile);
+    ChatServer(int port, const std::string &dbFile, const ServerOptions &opts = ServerOptions());
     ~ChatServer();
 
     bool init();
     bool start();
 
 private:
-    void receiveLoop();
-    void handlePacket(const sockaddr_in &addr, const std::vector<uint8_t> &data);
+    void onReadable(Listener &listener);
+    void requestShutdown();
+    // 一批数据报作为一个任务交给线程池；队列满被丢弃时由 shedPackets 统计并按策略回复
+    // 从收包到进入处理函数的整条路径不分配内存：批次是缓冲区串成的链表，任务闭包内联存放在线程池的队列槽位中
+    struct PacketTask;
+    void dispatch(Listener &listener, PacketChain &&packets);
+    void shedPackets(Listener &listener, const PacketChain &packets);
+    void replyBusy(const PacketChain &packets);
+    void handlePackets(PacketChain &packets, std::chrono::steady_clock::time_point enqueued);
+    void handleQueued(PacketRef &&packet, std::chrono::steady_clock::duration waited);
+    bool setupUring();
+    void handlePacket(PacketRef &&packet);
+    void handleRequest(const Request &req);
+    void logStats();
+    uint32_t presenceTick() const;  // 启动以来经过的心跳 tick 数
+    void expireIdleSessions();
 
     // 账户相关
-    void handleRegister(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleLogin(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleLogout(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleUpdateUser(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleDeleteUser(const sockaddr_in &addr, const std::vector<uint8_t> &body);
+    void handleRegister(const Request &req);
+    void handleLogin(const Request &req);
+    void handleLogout(const Request &req);
+    void handleUpdateUser(const Request &req);
+    void handleDeleteUser(const Request &req);
+    void handleHeartbeat(const Request &req);
 
     // 好友相关
-    void handleFriendRequest(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleFriendRequestList(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleFriendRequestAction(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleDeleteFriend(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleFriendList(const sockaddr_in &addr, const std::vector<uint8_t> &body);
+    void handleFriendRequest(const Request &req);
+    void handleFriendRequestList(const Request &req);
+    void handleFriendRequestAction(const Request &req);
+    void handleDeleteFriend(const Request &req);
+    void handleFriendList(const Request &req);
 
     // 黑名单相关
-    void handleBlockUser(const sockaddr_in &addr, const std::vector<uint8_t> &body);
-    void handleUnblockUser(const sockaddr_in &addr, const std::vector<uint8_t> &body);
+    void handleBlockUser(const Request &req);
+    void handleUnblockUser(const Request &req);
 
     // 群组相关
-    void handleCreateGroup(const sockaddr_in &addr, const std::vector<uint8_t> &body);  // 创建群组
-    void handleJoinGroup(const sockaddr_in &addr, const std::vector<uint8_t> &body);    // 加入群组
-    void sendGroupMessage(const sockaddr_in &addr, int groupId, const std::string &message);  // 发送群组消息
+    void handleCreateGroup(const Request &req);  // 创建群组
+    void handleJoinGroup(const Request &req);    // 加入群组
 
     // 私聊相关
-    void handlePrivateMessage(const sockaddr_in &addr, const std::vector<uint8_t> &body); // 处理私聊消息
-    void handleChatHistory(const sockaddr_in &addr, const std::vector<uint8_t> &body);
+    void handlePrivateMessage(const Request &req); // 处理私聊消息
+    void handleChatHistory(const Request &req);
+    void handleChatHistoryPage(const Request &req);  // 按游标分页，结果分块流式发送
+
+    // 批量请求：子请求在同一任务内依次解码，数据库调用合并为存储阶段的一个操作，落在同一次事务提交中
+    void handleMulti(const Request &req);
+
+    // 流水线（见 Stage.h）：处理函数在解码阶段（线程池）解析请求，store(db) 在存储线程上访问数据库，
+    // 所在事务提交后结果交给编码阶段的 respond(req, result) 编码负载并发送；不访问数据库的回复直接交给编码阶段
+    // store 可能因合并的事务失败而重新执行，不能改动内存状态；会话表等改动放在 apply(result) 中，
+    // 它在事务提交后、交给编码阶段之前在存储线程上按提交顺序执行，可以修改结果
+    template <typename Store, typename Respond>
+    void pipeline(const Request &req, Store store, Respond respond);
+    template <typename Store, typename Apply, typename Respond>
+    void pipeline(const Request &req, Store store, Apply apply, Respond respond);
+    void toStorage(const Request &req, AsyncDatabase::Op op);
+    void toEncoder(const Request &req, Stage::Job job);
+
+    // 只读查询：在存储阶段先查响应缓存，未命中时经请求合并执行 fetch(db)，
+    // 编码阶段用 encode 编码结果、写回缓存并交给所有合并的请求
+    template <typename Fetch, typename Encode>
+    void serveRead(const ResponseCache::Key &key, const Request &req, Fetch fetch, Encode encode);
+    // 写路径提交后调用，使对应的缓存项与在途查询失效
+    void invalidateRead(const ResponseCache::Key &key);
 
-    int sockfd;
     sockaddr_in serverAddr;
-    ThreadPool pool;
-    DatabaseManager db;
+    ServerOptions options;
+    BufferPool bufferPool;  // 须先于监听器与发送队列构造、晚于它们析构
+    std::vector<std::unique_ptr<Listener>> listeners;
+    EventLoop mainLoop;  // 信号、定时任务等控制事件
+    EgressQueue egress;
+    FragmentSender fragments;  // 大响应经此分片发送
+    ThreadPool pool;      // 解码阶段
+    AsyncDatabase database;  // 存储阶段：独占数据库连接，合并提交
+    Stage encoder;        // 编码阶段：编码、压缩负载并交给发送队列
+    std::unique_ptr<LaneExecutor> lanes;  // 为空时按批次分类入队
+
+    SessionTable sessions;  // 在线用户 -> 地址
+    std::unique_ptr<RateLimiter> limiter;  // 入队前限速，所有收包线程共用；为空表示不限速
+
+    // 只读查询的响应缓存与请求合并：相同查询正在执行时共享其查询结果与编码后的负载
+    using Payload = ResponseCache::Payload;
+    ResponseCache responseCache;
+    using ReadFlight = SingleFlight<ResponseCache::Key, Payload, ResponseCache::KeyHash>;
+    ReadFlight readFlight;
 
-    std::mutex clientsMutex;
-    std::unordered_map<int, ClientInfo> onlineClients;
+    // 心跳超时检测：每个会话在时间轮中只有一个条目，到期时若期间收到过心跳则按最近心跳时刻重新调度
+    std::chrono::steady_clock::time_point startTime;
+    std::mutex presenceMutex;
+    TimingWheel presence;
+    std::atomic<uint64_t> expiredSessions{0};
+    std::atomic<uint64_t> staleRequests{0};  // 排队超过预算被丢弃的请求数
+    std::atomic<uint64_t> multiRequests{0};     // 处理的 MULTI_REQ 数
+    std::atomic<uint64_t> multiSubRequests{0};  // 其中执行的子请求数
+    CompressionStats compressionStats;
 };
 
 #endif // CHATSERVER_H
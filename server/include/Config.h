@@ -8,4 +8,130 @@
 // SQLite 数据库文件路径
 #define DB_FILE_PATH "chat_system.db"
 
+// 单个数据报接收缓冲区大小
+#define RECV_BUFFER_SIZE 2048
+// 每次 recvmmsg 最多读取的数据报数量（可通过 --recv-batch 覆盖）
+#define RECV_BATCH_SIZE 32
+// 收包缓冲环的批次槽位数量；收满的批次移交缓冲区引用后立即归还槽位
+#define RECV_RING_SLOTS 8
+// 缓冲池中每个缓冲区的数据区大小：单个数据报 + io_uring 收包元数据 + 结尾 NUL
+#define POOL_BUFFER_SIZE (RECV_BUFFER_SIZE + 64)
+// 缓冲池每次扩容分配的缓冲区数量（一个 slab）
+#define POOL_SLAB_BUFFERS 512
+// 缓冲池最多分配的 slab 数量，达到上限后新到的数据报被丢弃
+#define POOL_MAX_SLABS 64
+// slab 是否优先使用 2MB 大页（需预留 vm.nr_hugepages，失败时自动退回普通页，可通过 --huge-pages 开启）
+#define POOL_HUGE_PAGES 0
+// 监听套接字数量；大于 1 时以 SO_REUSEPORT 打开多个套接字，每个配一个收包线程
+#define LISTENER_COUNT 1
+// 多监听器模式下是否把收包线程绑定到不同 CPU
+#define PIN_LISTENERS 1
+// 收发后端：0 = epoll + recvmmsg/sendmmsg，1 = io_uring（可通过 --transport 覆盖）
+#define TRANSPORT_BACKEND 0
+// io_uring 提交队列深度
+#define URING_ENTRIES 256
+// 每个监听器提供给内核的接收缓冲区数量（须为 2 的幂）
+#define URING_RECV_BUFFERS 1024
+// 不小于该字节数的报文使用零拷贝 sendmsg，0 表示禁用
+#define URING_ZEROCOPY_THRESHOLD 1024
+
+// 线程池工作线程数（可通过 --workers 覆盖）
+#define WORKER_THREADS 4
+// 线程池任务队列容量（按收包批次计），0 表示不限制（可通过 --queue-capacity 覆盖）
+#define QUEUE_CAPACITY 1024
+// 队列满时的溢出策略：0 = 丢弃新批次，1 = 丢弃最旧批次，2 = 回复 SERVER_BUSY（可通过 --overload 覆盖）
+#define OVERLOAD_POLICY 2
+// SERVER_BUSY 回复中建议客户端等待的重试间隔（毫秒）
+#define BUSY_RETRY_AFTER_MS 200
+// 是否按请求类型的调度类分别排队（可通过 --no-priority 关闭，所有请求共用一个 FIFO）：
+// 交互类（私聊、心跳等）严格优先，普通类与批量类按权重分享其余处理时间，各类的归属见 Dispatch.cpp
+#define PRIORITY_SCHEDULING 1
+#define SCHED_WEIGHT_NORMAL 4
+#define SCHED_WEIGHT_BULK 1
+// 只执行交互类请求的工作线程数：任务不可抢占，其余线程都在处理长任务时交互类请求仍能立即开始
+#define SCHED_RESERVED_WORKERS 1
+// 是否按用户串行执行请求（可通过 --no-lanes 关闭，改为每批数据报按调度类各作为一个任务）：
+// 同一用户的请求按 userId 哈希到同一串行通道，按到达顺序逐个执行，见 LaneExecutor.h
+#define USER_LANES 1
+#define LANE_COUNT 256
+// 单个通道最多积压的请求数，超过时按溢出策略回复
+#define LANE_MAX_DEPTH 64
+// 排空任务连续处理的请求数上限，处理满后重新入队，让其他通道的请求有机会执行
+#define LANE_QUANTUM 16
+// 编码阶段的线程数（解码阶段即上面的线程池，可通过 --encode-threads 覆盖）：编码、压缩负载并交给发送队列
+#define ENCODE_THREADS 2
+// 编码阶段每个线程的队列容量，满时上游阶段阻塞等待，背压传回线程池，由其容量与溢出策略在入口丢弃请求
+#define STAGE_QUEUE_CAPACITY 256
+// 存储阶段只有一个线程独占数据库连接（见 AsyncDatabase.h），队列容量含义同上
+#define DB_QUEUE_CAPACITY 512
+// 一个事务最多合并的排队操作数，1 表示每个操作单独提交（可通过 --db-batch 覆盖）
+#define DB_BATCH_MAX 64
+
+// 请求在队列中等待超过预算即丢弃，不再访问数据库（0 表示不限制）：
+// 查询类请求（好友列表、聊天记录等），客户端超时后结果已无人接收
+#define QUEUE_BUDGET_QUERY_MS 500
+// 修改类请求（注册登录、好友操作、发消息等），超过客户端等待时间后客户端已视为失败
+#define QUEUE_BUDGET_UPDATE_MS 1000
+
+// 是否启用入站限速（可通过 --no-rate-limit 关闭）
+#define RATE_LIMIT_ENABLED 1
+// 限速表项数（所有监听器共用，每项 16 字节，按需分配物理页），应大于同时活跃的来源数 + 用户数
+#define RATE_LIMIT_TABLE_SIZE (1 << 22)
+// 每个来源 IP 每秒补充的令牌数与桶容量（同一 IP 的所有端口共用）
+#define RATE_SOURCE_PER_SEC 20
+#define RATE_SOURCE_BURST 40
+// 每个 userId 每秒补充的令牌数与桶容量（负载以 userId 开头、且来自该用户登录地址的请求同时计入）
+#define RATE_USER_PER_SEC 20
+#define RATE_USER_BURST 40
+// 各类请求消耗的令牌数：查询类（好友列表、聊天记录等）与登录注册要做完整的 SQLite 查询或密码校验
+#define RATE_COST_QUERY 4
+#define RATE_COST_DEFAULT 1
+// MULTI_REQ 按子请求个数计费，每个子请求的令牌数：合并后省去了逐包的收发与加锁提交，按单独查询的一半计
+#define RATE_COST_MULTI_ITEM 2
+
+// MULTI_REQ 最多携带的子请求数，超出的请求整体丢弃；满额批量的令牌数应不超过桶容量
+#define MULTI_MAX_REQUESTS 16
+
+// 分页聊天记录：请求未指定页大小时的默认值与允许的最大值
+#define HISTORY_PAGE_DEFAULT 50
+#define HISTORY_PAGE_MAX 200
+
+// 响应缓存（好友列表、好友请求列表、聊天记录的编码结果）最多保存的条目数
+#define RESPONSE_CACHE_ENTRIES 65536
+
+// 是否同意客户端在登录时请求的负载压缩（离线消息列表、聊天记录）
+#define COMPRESSION_ENABLED 1
+// 负载不短于该字节数时尝试压缩，更短的负载压缩收益不足以抵消开销
+#define COMPRESS_THRESHOLD 512
+// zlib 压缩级别（1 最快，9 压缩率最高）
+#define COMPRESS_LEVEL 1
+
+// 统计信息的输出周期（毫秒），由主事件循环的 timerfd 驱动
+#define STATS_INTERVAL_MS 10000
+
+// 每次 sendmmsg 最多发送的数据报数量
+#define EGRESS_BATCH_SIZE 32
+// 发送队列未攒满一批时的最长等待时间（微秒），即单个回复的额外延迟上界
+#define EGRESS_FLUSH_US 200
+// 发送缓冲区满时等待可写的单次超时（毫秒），超时后重试发送
+#define EGRESS_POLL_TIMEOUT_MS 100
+// 网卡发送队列满（ENOBUFS）时重发前的退避时间（微秒）
+#define EGRESS_NOBUFS_BACKOFF_US 200
+// 是否为每个发出的数据报打印 [SEND] 日志（高负载下应关闭）
+#define ENABLE_SEND_LOG 0
+
+// 负载超过该字节数的响应分片发送（分片大小见 common/include/Fragment.h）
+#define FRAGMENT_THRESHOLD 1400
+// 分片传输无确认进展时的重传超时（毫秒），也是主循环检查重传的周期
+#define FRAGMENT_RTO_MS 200
+// 放弃一个分片传输前的最大重传轮数
+#define FRAGMENT_MAX_RETRIES 5
+// 同时跟踪重传状态的分片传输上限
+#define FRAGMENT_MAX_TRANSFERS 4096
+
+// 在线状态时间轮的 tick 长度（毫秒），也是主循环检查心跳超时的周期
+#define HEARTBEAT_TICK_MS 1000
+// 超过该时长（毫秒）未收到心跳的会话视为掉线，之后发给该用户的消息转为离线存储
+#define HEARTBEAT_TIMEOUT_MS 90000
+
 #endif // CONFIG_H
\ No newline at end of file
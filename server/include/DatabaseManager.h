@@ -4,6 +4,7 @@
 #include <sqlite3.h>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // 好友记录结构体
@@ -60,6 +61,25 @@ public:
     // 数据库初始化
     bool init();
 
+    // 批量执行：构造时取得数据库锁并开始事务，析构时提交（失败则回滚）
+    // 期间同一线程的各个调用重入这把锁，写入合并为一次提交；其他线程的调用等待批量结束
+    // 各调用仍各自返回成败，批量不是原子操作，只用来摊薄加锁与提交的开销
+    class Batch {
+    public:
+        explicit Batch(DatabaseManager &db);
+        ~Batch();
+        Batch(const Batch &) = delete;
+        Batch &operator=(const Batch &) = delete;
+
+        // 提前提交并返回是否成功（失败时已回滚），之后析构不再提交
+        bool commit();
+
+    private:
+        DatabaseManager &db;
+        std::lock_guard<std::recursive_mutex> lock;
+        bool inTransaction;
+    };
+
     // 用户注册与验证
     bool registerUser(const std::string &u, const std::string &p);
     bool verifyUser(const std::string &u, const std::string &p, int &userId);
@@ -73,7 +93,8 @@ public:
     bool isFriendRequestExists(int userId, int friendId);
     bool sendFriendRequest(int userId, int friendId);
     std::vector<FriendRequestRecord> getFriendRequests(int userId);
-    bool respondFriendRequest(int requestId, bool accept);
+    // fromUser/toUser 非空时返回该请求的发起方与接收方（请求不存在时为 -1）
+    bool respondFriendRequest(int requestId, bool accept, int *fromUser = nullptr, int *toUser = nullptr);
     bool addFriend(int userId, int friendId);
     bool deleteFriend(int userId, int friendId);
     bool blockFriend(int userId, int friendId);
@@ -82,10 +103,11 @@ public:
     bool getPendingFriendRequests(int userId, std::vector<std::pair<int, int>>& requests);
 
     // 消息管理
-    bool storeMessage(int senderId, int receiverId, const std::string &content, int groupId = -1);
+    bool storeMessage(int senderId, int receiverId, std::string_view content, int groupId = -1);
     std::vector<MessageRecord> loadOffline(int receiverId, int groupId = -1);
     bool markDelivered(int msgId);
-    std::vector<MessageRecord> getChatHistory(int userId, int friendId, int limit = 50);
+    // 两人之间的私聊记录，按 msg_id 从新到旧；beforeMsgId > 0 时只取比它更早的（分页游标）
+    std::vector<MessageRecord> getChatHistory(int userId, int friendId, int limit = 50, int beforeMsgId = 0);
 
     // 群组管理
     bool createGroup(const std::string &groupName);  // 创建群组
@@ -105,7 +127,7 @@ public:
 
 private:
     sqlite3 *db;  // SQLite数据库指针
-    std::mutex mtx;  // 互斥锁用于线程同步
+    std::recursive_mutex mtx;  // 互斥锁用于线程同步；可重入，供 Batch 与相互调用的方法在同一线程内重复加锁
 
     // 执行SQL语句（无参数）
     bool execute(const std::string &sql);
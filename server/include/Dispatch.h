@@ -0,0 +1,39 @@
+// Dispatch.h
+// 每种请求的调度属性登记在一张表里：所属调度类、相对处理代价、排队预算以及是否按用户串行
+// 收包线程按调度类把一批数据报拆开分别入队，线程池按类的优先级与权重选择下一个任务（见 ThreadPool.h）
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "PacketBuffer.h"
+#include "Protocol.h"
+#include <chrono>
+#include <cstdint>
+
+// 按优先级从高到低排列，下标即线程池中的调度类
+enum SchedClass : uint8_t {
+    SCHED_INTERACTIVE,  // 私聊、心跳、退出登录、分片确认：只改内存状态或单条写入，延迟直接影响聊天体验
+    SCHED_NORMAL,       // 好友与群组操作、登录、列表查询（多数命中响应缓存）
+    SCHED_BULK,         // 注册（密码哈希）、聊天记录、批量请求等重查询
+    SCHED_CLASS_COUNT
+};
+
+struct OpcodeTraits {
+    SchedClass cls;
+    uint8_t cost;       // 相对处理代价，线程池按权重轮询时据此扣除额度
+    uint16_t budgetMs;  // 允许在队列中等待的时长，0 表示不限制
+    bool userKeyed;     // 负载以发起请求的 userId 开头，按用户分配串行通道（见 LaneExecutor.h），否则按来源地址
+};
+
+// 未登记的类型按普通类、代价 1 处理（handleRequest 中丢弃）
+const OpcodeTraits &opcodeTraits(uint8_t type);
+
+inline std::chrono::milliseconds queueBudget(uint8_t type) {
+    return std::chrono::milliseconds(opcodeTraits(type).budgetMs);
+}
+
+// 请求的串行键：userKeyed 的请求取负载开头的 userId，其余取来源地址；hdr 为已校验的协议头
+// 同一用户的请求得到相同的键，串行通道与流水线各阶段据此把它们交给同一执行者，保持到达顺序
+// 返回值已充分混合，可直接取模或按掩码取低位
+uint64_t requestKey(const PacketBuffer &pkt, const PacketHeader &hdr);
+
+#endif // DISPATCH_H
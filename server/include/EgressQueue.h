@@ -0,0 +1,94 @@
+// EgressQueue.h
+// 发送队列：工作线程只负责入队，由独立写线程用 sendmmsg 批量发出
+#ifndef EGRESSQUEUE_H
+#define EGRESSQUEUE_H
+
+#include "PacketBuffer.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 待发送的数据报：目标地址 + 报文（协议头 + 负载）
+// 转发、分片等场景下 bytes 只含头部，负载以视图形式引用入站缓冲区或共享的响应数据，
+// 发送时作为第二个 iovec
+struct OutDatagram {
+    sockaddr_in addr;
+    std::vector<uint8_t> bytes;
+    PacketRef payloadRef;  // 保证 payload 指向的缓冲区在发出前有效（二者至多其一非空）
+    std::shared_ptr<const std::vector<uint8_t>> payloadBlock;
+    ByteView payload;
+
+    size_t size() const { return bytes.size() + payload.size(); }
+    // 填充 iov（至少 2 个），返回使用的个数
+    size_t fillIov(iovec *iov) {
+        iov[0].iov_base = bytes.data();
+        iov[0].iov_len = bytes.size();
+        if (payload.empty()) return 1;
+        iov[1].iov_base = const_cast<uint8_t*>(payload.data());
+        iov[1].iov_len = payload.size();
+        return 2;
+    }
+};
+
+struct EgressStats {
+    std::atomic<uint64_t> datagrams{0};
+    std::atomic<uint64_t> syscalls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> stalls{0};  // 发送缓冲区或网卡队列满而等待的次数
+};
+
+class EgressQueue {
+public:
+    // batchSize: 单次 sendmmsg 的最大数据报数量
+    // flushDeadline: 队列未攒满时，首个数据报最多等待的时间
+    EgressQueue(size_t batchSize, std::chrono::microseconds flushDeadline);
+    ~EgressQueue();
+
+    void start(int fd);
+    // 不启动写线程，由外部（如 io_uring 传输层）调用 drain 取走数据报自行发送；
+    // 队列由空变非空时调用 notify 唤醒外部排空方
+    void startExternal(int fd, std::function<void()> notify);
+    void stop();  // 发出队列中剩余的数据报后退出写线程
+
+    void drain(std::vector<OutDatagram> &out);
+
+    void push(const sockaddr_in &addr, std::vector<uint8_t> &&bytes);
+    void push(OutDatagram &&datagram);
+    void push(std::vector<OutDatagram> &&datagrams);  // 群发等场景一次入队多个
+
+    const EgressStats &stats() const { return egressStats; }
+
+private:
+    void writerLoop();
+    void flush(std::vector<OutDatagram> &out);
+    void waitWritable(bool queueFull);  // 发送被拒（EAGAIN/ENOBUFS）后等到可以重发
+    void notifyWriter(bool becameNonEmpty);
+
+    int sockfd;
+    size_t batchSize;
+    std::chrono::microseconds flushDeadline;
+
+    std::vector<OutDatagram> pending;
+    std::chrono::steady_clock::time_point firstPending;
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    bool stopping;
+    std::thread writer;
+    std::function<void()> externalNotify;
+
+    // 仅由写线程使用的 sendmmsg 参数数组
+    std::vector<mmsghdr> msgs;
+    std::vector<iovec> iovs;  // 每个数据报 2 个
+
+    EgressStats egressStats;
+};
+
+#endif // EGRESSQUEUE_H
@@ -0,0 +1,54 @@
+// EventLoop.h
+// 基于 epoll 的事件循环：统一管理套接字、定时器(timerfd)、信号(signalfd)与跨线程唤醒(eventfd)
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+
+class EventLoop {
+public:
+    using Callback = std::function<void(uint32_t events)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    bool init();
+
+    // 注册文件描述符及其就绪回调（电平触发）
+    bool addFd(int fd, uint32_t events, Callback cb);
+    void removeFd(int fd);
+
+    // 周期定时器，返回 timerfd，失败返回 -1
+    int addTimer(std::chrono::milliseconds interval, std::function<void()> cb);
+
+    // 通过 signalfd 在循环中处理信号；调用前这些信号须已在所有线程中屏蔽
+    bool watchSignals(std::initializer_list<int> signals, std::function<void(int)> cb);
+
+    void run();   // 阻塞运行，直到 stop() 被调用
+    void stop();  // 线程安全，可从任意线程或回调中调用
+
+private:
+    struct Handler {
+        int fd;
+        bool owned;  // 由循环创建的 fd（定时器、信号、唤醒）在析构时关闭
+        Callback cb;
+    };
+
+    bool addHandler(int fd, uint32_t events, bool owned, Callback cb);
+
+    int epfd;
+    int wakeFd;
+    std::atomic<bool> stopped;
+    std::unordered_map<int, std::unique_ptr<Handler>> handlers;
+};
+
+// 在当前线程屏蔽指定信号；须在创建任何线程之前调用，子线程会继承该屏蔽字
+bool blockSignals(std::initializer_list<int> signals);
+
+#endif // EVENTLOOP_H
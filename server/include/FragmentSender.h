@@ -0,0 +1,78 @@
+// FragmentSender.h
+// 大响应的分片发送：超过阈值的负载切成编号分片一次性入队，
+// 根据客户端的 SACK 确认只重传缺失分片，超时未确认时由主循环定时重传
+#ifndef FRAGMENTSENDER_H
+#define FRAGMENTSENDER_H
+
+#include "EgressQueue.h"
+#include "Fragment.h"
+#include "PacketBuffer.h"
+#include "Protocol.h"
+#include <netinet/in.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct FragmentStats {
+    std::atomic<uint64_t> transfers{0};    // 分片发送的响应数
+    std::atomic<uint64_t> fragments{0};    // 首次发出的分片数
+    std::atomic<uint64_t> retransmits{0};  // 重传的分片数
+    std::atomic<uint64_t> completed{0};    // 收到完整确认的传输数
+    std::atomic<uint64_t> failed{0};       // 重传次数用尽或未能登记而放弃跟踪的传输数
+    std::atomic<uint64_t> oversized{0};    // 分片数超过上限而丢弃的响应数
+};
+
+class FragmentSender {
+public:
+    // threshold: 负载超过该字节数时分片发送
+    // rto: 无确认进展时的重传超时；maxRetries: 放弃前的最大重传轮数
+    // maxTransfers: 同时跟踪的传输上限，超出时只发送一次不再重传
+    FragmentSender(EgressQueue &egress, size_t threshold, std::chrono::milliseconds rto,
+                   unsigned maxRetries, size_t maxTransfers);
+
+    // requestId、flags 与 version 写入完整响应或每个分片的协议头，客户端据此匹配请求、识别负载编码
+    void send(const sockaddr_in &addr, MessageType type, uint32_t requestId, std::vector<uint8_t> &&payload,
+              uint16_t flags = 0, uint8_t version = PROTOCOL_VERSION);
+    // 共享负载版本：多个接收方发送同一份编码结果时不复制负载
+    void send(const sockaddr_in &addr, MessageType type, uint32_t requestId,
+              std::shared_ptr<const std::vector<uint8_t>> payload, uint16_t flags = 0,
+              uint8_t version = PROTOCOL_VERSION);
+    void onAck(const sockaddr_in &addr, ByteView body);
+    void onTimer();  // 由主事件循环的定时器周期调用
+
+    const FragmentStats &stats() const { return fragmentStats; }
+
+private:
+    struct Transfer {
+        sockaddr_in addr;
+        uint8_t type;
+        uint32_t requestId;
+        uint16_t flags;
+        uint8_t version;
+        std::shared_ptr<const std::vector<uint8_t>> payload;
+        SackBitmap acked;
+        std::chrono::steady_clock::time_point lastActivity;
+        unsigned retries;
+    };
+
+    OutDatagram makeFragment(uint32_t id, const Transfer &t, uint16_t index) const;
+    // 重传确认窗口内缺失的分片；末尾分片未确认时一并重发，以便触发客户端的确认
+    void resendMissing(uint32_t id, const Transfer &t, std::vector<OutDatagram> &out) const;
+
+    EgressQueue &egress;
+    size_t threshold;
+    std::chrono::milliseconds rto;
+    unsigned maxRetries;
+    size_t maxTransfers;
+
+    std::mutex transfersMutex;
+    std::unordered_map<uint32_t, Transfer> transfers;
+    std::atomic<uint32_t> nextId;
+    FragmentStats fragmentStats;
+};
+
+#endif // FRAGMENTSENDER_H
@@ -0,0 +1,80 @@
+// LaneExecutor.h
+// 按用户串行执行：请求按 userId（负载中没有 userId 的按来源地址，见 requestKey）哈希到固定数量的串行通道，
+// 同一通道同一时刻只有一个工作线程在处理，同一用户的请求按到达顺序执行，不同用户的请求仍然并行
+// 通道不是线程：有待处理请求时向线程池提交一个排空任务，按队首请求的调度类排队；
+// 排空任务连续处理同一调度类的请求，遇到其他类的请求或处理满一个时间片后重新入队，保持顺序的同时保留优先级调度
+#ifndef LANEEXECUTOR_H
+#define LANEEXECUTOR_H
+
+#include "PacketBuffer.h"
+#include "Protocol.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+struct LaneStats {
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> drains{0};    // 提交给线程池的排空任务（含重新入队）
+    std::atomic<uint64_t> yields{0};    // 因调度类变化或时间片用完而重新入队
+    std::atomic<uint64_t> overflow{0};  // 通道积压超过上限而丢弃的请求
+    std::atomic<uint64_t> shed{0};      // 排空任务被线程池丢弃而连带丢弃的请求
+    std::atomic<uint64_t> maxDepth{0};  // 观察到的最大通道积压
+};
+
+class LaneExecutor {
+public:
+    using Handler = std::function<void(PacketRef &&packet)>;
+    // 被丢弃的请求（通道积压超限或排空任务被线程池丢弃），在丢弃发生的线程上调用
+    using ShedHandler = std::function<void(const PacketChain &packets)>;
+
+    // laneCount 向上取 2 的幂；priority 为假时所有请求使用调度类 0（对应 --no-priority）
+    LaneExecutor(ThreadPool &pool, size_t laneCount, size_t maxDepth, unsigned quantum, bool priority,
+                 Handler handler, ShedHandler onShed);
+
+    LaneExecutor(const LaneExecutor &) = delete;
+    LaneExecutor &operator=(const LaneExecutor &) = delete;
+
+    // hdr 为已校验的协议头；积压超限时请求交给 onShed 并返回 false
+    bool submit(PacketRef &&packet, const PacketHeader &hdr, std::chrono::steady_clock::time_point now);
+
+    size_t laneCount() const { return mask + 1; }
+    const LaneStats &stats() const { return laneStats; }
+
+private:
+    struct alignas(64) Lane {
+        std::mutex mutex;
+        PacketChain pending;
+        bool scheduled = false;  // 线程池中已有该通道的排空任务（排队或正在执行）
+    };
+
+    // 线程池任务：执行时排空通道，被丢弃时连带丢弃通道中积压的请求
+    struct Drain {
+        LaneExecutor *exec;
+        Lane *lane;
+        uint32_t cls;
+
+        void operator()() { exec->drain(*lane, cls); }
+        void shed() { exec->shedLane(*lane); }
+    };
+
+    void drain(Lane &lane, size_t cls);
+    void shedLane(Lane &lane);
+    void schedule(Lane &lane, const PacketBuffer &head, bool fromWorker);
+    size_t classOf(const PacketBuffer &pkt) const;
+
+    ThreadPool &pool;
+    size_t mask;
+    std::unique_ptr<Lane[]> lanes;
+    size_t maxDepth;
+    unsigned quantum;
+    bool priority;
+    Handler handler;
+    ShedHandler onShed;
+    LaneStats laneStats;
+};
+
+#endif // LANEEXECUTOR_H
@@ -0,0 +1,33 @@
+// Listener.h
+// 监听器：一个 UDP 套接字 + 专属收包线程 + 收包缓冲环
+// 多监听器模式下各套接字以 SO_REUSEPORT 绑定同一端口，由内核按四元组哈希分流
+#ifndef LISTENER_H
+#define LISTENER_H
+
+#include "RecvBatch.h"
+#include "EventLoop.h"
+#include "UringTransport.h"
+#include <netinet/in.h>
+#include <memory>
+#include <thread>
+
+struct Listener {
+    Listener(int index, BufferPool &pool, size_t ringSlots, size_t batchSize, size_t bufSize)
+        : index(index), ring(pool, ringSlots, batchSize, bufSize) {}
+
+    int index;
+    int fd = -1;
+    int cpu = -1;  // 收包线程绑定的 CPU，-1 表示不绑定
+    RecvRing ring;
+    IngressStats stats;
+    EventLoop loop;  // 收包线程自己的 epoll 循环，stop() 即可让线程退出
+    std::unique_ptr<UringTransport> uring;  // 非空时改用 io_uring 后端收包
+    std::thread thread;
+};
+
+// 创建并绑定非阻塞 UDP 套接字，失败返回 -1
+int openListenerSocket(const sockaddr_in &addr, bool reusePort);
+// 将线程绑定到指定 CPU
+bool pinThreadToCpu(std::thread &t, int cpu);
+
+#endif // LISTENER_H
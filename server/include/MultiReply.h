@@ -0,0 +1,44 @@
+// MultiReply.h
+// MULTI_REQ 的响应汇总：各子请求的处理函数把编码好的负载交给它，而不是各自发包
+// 子响应可能在别的线程稍后到达（请求合并中由执行查询的线程回调），所以由 shared_ptr 共享，
+// 最后一个持有者释放时按子请求下标排序，编码成一个 MULTI_RESP 发出
+#ifndef MULTIREPLY_H
+#define MULTIREPLY_H
+
+#include "FragmentSender.h"
+#include "Protocol.h"
+#include <netinet/in.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class MultiReply {
+public:
+    // requestId 与 version 取自外层 MULTI_REQ 的协议头
+    MultiReply(FragmentSender &out, const sockaddr_in &addr, uint32_t requestId, uint8_t version);
+    ~MultiReply();
+
+    MultiReply(const MultiReply &) = delete;
+    MultiReply &operator=(const MultiReply &) = delete;
+
+    using Payload = std::shared_ptr<const std::vector<uint8_t>>;
+    void add(uint16_t index, MessageType type, uint16_t flags, Payload payload);
+
+private:
+    struct Entry {
+        uint16_t index;
+        MessageType type;
+        uint16_t flags;
+        Payload payload;
+    };
+
+    FragmentSender &out;
+    sockaddr_in addr;
+    uint32_t requestId;
+    uint8_t version;
+    std::mutex mutex;
+    std::vector<Entry> entries;
+};
+
+#endif // MULTIREPLY_H
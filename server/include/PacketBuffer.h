@@ -0,0 +1,167 @@
+// PacketBuffer.h
+// 引用计数的报文缓冲区与固定大小的缓冲池：数据报从套接字读入后，
+// 处理函数与发送队列都只持有引用或只读视图，整个链路不再复制报文内容
+#ifndef PACKETBUFFER_H
+#define PACKETBUFFER_H
+
+#include <netinet/in.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class BufferPool;
+
+// 缓冲区头部与数据区位于同一块内存中，头部按缓存行对齐
+struct alignas(64) PacketBuffer {
+    std::atomic<uint32_t> refs;
+    uint32_t offset;  // 报文在数据区中的起始偏移（io_uring 会在报文前放置元数据）
+    uint32_t length;  // 报文长度
+    bool truncated;
+    sockaddr_in addr; // 来源地址
+    BufferPool *pool;
+    PacketBuffer *next;  // 所在 PacketChain 中的下一个缓冲区
+    std::chrono::steady_clock::time_point queuedAt;  // 进入串行通道的时刻，用于排队预算
+
+    uint8_t *raw() { return reinterpret_cast<uint8_t*>(this + 1); }
+    const uint8_t *data() const { return reinterpret_cast<const uint8_t*>(this + 1) + offset; }
+};
+
+// 非拥有的只读字节视图
+struct ByteView {
+    const uint8_t *ptr = nullptr;
+    size_t len = 0;
+
+    const uint8_t *data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    uint8_t operator[](size_t i) const { return ptr[i]; }
+    ByteView sub(size_t pos) const { return pos >= len ? ByteView{ptr + len, 0} : ByteView{ptr + pos, len - pos}; }
+    std::string_view str() const { return std::string_view(reinterpret_cast<const char*>(ptr), len); }
+};
+
+// 缓冲区的侵入式引用，复制即增加引用计数，最后一个引用释放时归还缓冲池
+class PacketRef {
+public:
+    PacketRef() : buf(nullptr) {}
+    explicit PacketRef(PacketBuffer *b) : buf(b) {}  // 接管一个已有的引用
+    PacketRef(const PacketRef &o) : buf(o.buf) { retain(); }
+    PacketRef(PacketRef &&o) noexcept : buf(o.buf) { o.buf = nullptr; }
+    PacketRef &operator=(PacketRef o) noexcept { std::swap(buf, o.buf); return *this; }
+    ~PacketRef() { reset(); }
+
+    void reset();
+    PacketBuffer *release() { PacketBuffer *b = buf; buf = nullptr; return b; }  // 交出引用，不减计数
+    PacketBuffer *get() const { return buf; }
+    PacketBuffer *operator->() const { return buf; }
+    explicit operator bool() const { return buf != nullptr; }
+
+    ByteView view() const { return buf ? ByteView{buf->data(), buf->length} : ByteView{}; }
+
+private:
+    void retain() { if (buf) buf->refs.fetch_add(1, std::memory_order_relaxed); }
+    PacketBuffer *buf;
+};
+
+// 侵入式报文链表：经由缓冲区头部的 next 指针串起一批引用，批次在线程间移交、按调度类拆分都不分配内存
+// 链表持有其中每个缓冲区的一个引用；同一缓冲区同一时刻只能位于一个链表中
+class PacketChain {
+public:
+    PacketChain() = default;
+    PacketChain(PacketChain &&o) noexcept : head(o.head), tail(o.tail), count(o.count) {
+        o.head = o.tail = nullptr;
+        o.count = 0;
+    }
+    PacketChain &operator=(PacketChain &&o) noexcept {
+        std::swap(head, o.head);
+        std::swap(tail, o.tail);
+        std::swap(count, o.count);
+        return *this;
+    }
+    PacketChain(const PacketChain &) = delete;
+    PacketChain &operator=(const PacketChain &) = delete;
+    ~PacketChain() { clear(); }
+
+    void push(PacketRef &&ref) {
+        PacketBuffer *b = ref.release();
+        if (!b) return;
+        b->next = nullptr;
+        if (tail) tail->next = b;
+        else head = b;
+        tail = b;
+        ++count;
+    }
+
+    PacketRef pop() {  // 链表为空时返回空引用
+        PacketBuffer *b = head;
+        if (!b) return PacketRef();
+        head = b->next;
+        if (!head) tail = nullptr;
+        --count;
+        return PacketRef(b);
+    }
+
+    void clear() { while (pop()) {} }
+
+    template <typename F>
+    void forEach(F &&f) const {
+        for (const PacketBuffer *b = head; b; b = b->next) f(*b);
+    }
+
+    const PacketBuffer *front() const { return head; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    PacketBuffer *head = nullptr;
+    PacketBuffer *tail = nullptr;
+    size_t count = 0;
+};
+
+struct BufferPoolStats {
+    std::atomic<uint64_t> slabs{0};
+    std::atomic<uint64_t> hugePageSlabs{0};
+    std::atomic<uint64_t> exhausted{0};  // 达到上限无法分配的次数
+};
+
+class BufferPool {
+public:
+    // capacity: 每个缓冲区的数据区大小；maxSlabs 为 0 表示不限制
+    BufferPool(size_t capacity, size_t buffersPerSlab, size_t maxSlabs, bool hugePages);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    PacketRef acquire();  // 池耗尽时返回空引用
+    size_t capacity() const { return bufCapacity; }
+    const BufferPoolStats &stats() const { return poolStats; }
+
+private:
+    friend class PacketRef;
+    void recycle(PacketBuffer *buf);
+    bool grow();  // 调用方须持有 poolMutex
+
+    size_t bufCapacity;
+    size_t stride;
+    size_t buffersPerSlab;
+    size_t maxSlabs;
+    bool hugePages;
+
+    std::mutex poolMutex;
+    std::vector<PacketBuffer*> freeList;
+    std::vector<std::pair<void*, size_t>> slabs;
+    BufferPoolStats poolStats;
+};
+
+inline void PacketRef::reset() {
+    if (buf && buf->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        buf->pool->recycle(buf);
+    buf = nullptr;
+}
+
+#endif // PACKETBUFFER_H
@@ -0,0 +1,76 @@
+// RateLimiter.h
+// 入站令牌桶限速：按来源 IP 和 userId 各设一个桶，不同消息类型消耗不同数量的令牌
+// 桶存放在固定容量的开放寻址表中（每项 16 字节），没有定时器：访问时按流逝时间惰性补充令牌
+// 所有监听器的收包线程共用一份，否则同一来源或用户分散到 N 个套接字上就能得到 N 倍速率；
+// 表按 key 的哈希分成若干分片，各有一把锁，收包线程只在访问同一分片时互相等待
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <netinet/in.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class SessionTable;
+
+struct RateLimitStats {
+    std::atomic<uint64_t> limited{0};    // 因令牌不足被丢弃的数据报
+    std::atomic<uint64_t> evictions{0};  // 表满时淘汰的桶
+};
+
+class RateLimiter {
+public:
+    // capacity: 表项数（向上取 2 的幂）；rate 为每秒补充的令牌数，burst 为桶容量
+    // sessions 非空时，只有来源地址与该用户登录地址一致的请求才计入用户的桶，
+    // 否则任何主机都能冒用他人的 userId 耗尽其令牌
+    RateLimiter(size_t capacity, uint32_t sourceRate, uint32_t sourceBurst,
+                uint32_t userRate, uint32_t userBurst, const SessionTable *sessions = nullptr);
+    ~RateLimiter();
+
+    RateLimiter(const RateLimiter &) = delete;
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    // cost 为 0 表示该类型不限速；userKeyed 表示负载以 userId 开头，同时计入该用户的桶
+    // 须在开始调用 allow 之前设置
+    void setCost(uint8_t type, uint8_t cost, bool userKeyed);
+
+    // 检查并扣除令牌，nowMs 为单调时钟毫秒数（允许回绕）；units 为该数据报折合的请求个数（批量请求按子请求数计）
+    bool allow(const sockaddr_in &src, uint8_t type, const uint8_t *body, size_t len, uint32_t nowMs,
+               uint32_t units = 1);
+
+    const RateLimitStats &stats() const { return limitStats; }
+
+private:
+    struct Entry {
+        uint64_t key;     // 0 表示空槽
+        uint32_t stamp;   // 上次补充令牌的时刻
+        uint32_t tokens;  // 剩余令牌，单位为千分之一个
+    };
+    static constexpr size_t PROBE_LIMIT = 8;  // 最多探测 8 项（两个缓存行），超出则淘汰其中最久未访问的
+    static constexpr size_t SHARD_COUNT = 64;
+    struct alignas(64) Shard {
+        std::mutex mutex;
+    };
+
+    // 每个分片占表中连续的一段，探测不跨出本分片
+    size_t shardOf(uint64_t key) const;
+    // 查找或新建 key 的桶，调用方须持有其分片的锁；需要淘汰时不会选中 keep
+    Entry *find(uint64_t key, uint32_t burst, uint32_t nowMs, const Entry *keep = nullptr);
+    static void refill(Entry *e, uint32_t rate, uint32_t burst, uint32_t nowMs);
+    bool sessionMatches(uint32_t userId, const sockaddr_in &src) const;
+
+    Entry *entries;
+    size_t shardMask;  // 每个分片的表项数 - 1
+    size_t bytes;
+    std::unique_ptr<Shard[]> shards;
+    const SessionTable *sessions;
+    uint32_t sourceRate, sourceBurst;
+    uint32_t userRate, userBurst;
+    uint8_t costs[256];
+    bool userKeyed[256];
+    RateLimitStats limitStats;
+};
+
+#endif // RATELIMITER_H
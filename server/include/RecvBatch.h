@@ -0,0 +1,55 @@
+// RecvBatch.h
+// 基于 recvmmsg 的批量收包：一次系统调用把多个数据报直接读入缓冲池中的缓冲区
+#ifndef RECVBATCH_H
+#define RECVBATCH_H
+
+#include "PacketBuffer.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 一个批次槽位：batchSize 个池缓冲区引用及对应的 mmsghdr/iovec
+// 工作线程把收到的缓冲区引用移走后即可归还槽位，下次收包前再从缓冲池补齐
+struct RecvBatch {
+    std::vector<PacketRef> packets;
+    std::vector<mmsghdr> msgs;
+    std::vector<iovec> iovs;
+    unsigned count = 0;  // 本批次实际收到的数据报数量
+};
+
+// 收包统计：平均批次填充量 = packets / batches
+struct IngressStats {
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> dropped{0};    // 缓冲池耗尽或任务队列满时丢弃的数据报
+    std::atomic<uint64_t> malformed{0};  // 被截断或协议头校验失败而丢弃的数据报
+};
+
+// 批次槽位环：收包线程取出空闲槽位填充，工作线程处理完后归还
+class RecvRing {
+public:
+    // bufSize: 单个数据报的最大长度，须小于缓冲池的缓冲区容量（结尾预留一个 NUL）
+    RecvRing(BufferPool &pool, size_t slots, size_t batchSize, size_t bufSize);
+
+    RecvBatch *acquire();            // 无空闲槽位时阻塞，形成对收包线程的背压
+    void release(RecvBatch *batch);
+    // 非阻塞套接字上无数据时返回 -1 (EAGAIN)；缓冲池耗尽时丢弃一个数据报并返回 0
+    int receive(int fd, RecvBatch *batch);
+
+    size_t batchSize() const { return batchSz; }
+
+private:
+    BufferPool &pool;
+    std::vector<RecvBatch> batches;
+    std::vector<RecvBatch*> freeList;
+    std::mutex freeMutex;
+    std::condition_variable freeCond;
+    size_t batchSz;
+    size_t bufSize;
+};
+
+#endif // RECVBATCH_H
@@ -0,0 +1,74 @@
+// ResponseCache.h
+// 只读请求的响应缓存：按 (响应类型, userId, peerId) 缓存编码好的负载，命中时直接交给发送路径，不访问数据库
+// 由对应的写路径显式失效。读者查询前取票据，写入缓存时若期间该 key 发生过失效则放弃，
+// 避免把失效前读到的旧结果放回缓存；版本号按 key 的哈希分槽记录，其他 key 的失效不影响本次填充
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include "Protocol.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct ResponseCacheStats {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> invalidations{0};
+    std::atomic<uint64_t> staleFills{0};  // 因查询期间发生失效而未写入的结果
+};
+
+class ResponseCache {
+public:
+    using Payload = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Key {
+        uint8_t type;
+        int userId;
+        int peerId;  // 不需要时为 0
+        // 负载编码（FLAG_COMPRESSED 或 0）：同一查询的压缩与未压缩结果分别缓存
+        uint16_t flags = 0;
+        // 负载格式所属的协议版本，只有随版本变化的响应才会取 PROTOCOL_MIN_VERSION 以外的值
+        uint8_t version = PROTOCOL_MIN_VERSION;
+        bool operator==(const Key &o) const {
+            return type == o.type && userId == o.userId && peerId == o.peerId && flags == o.flags &&
+                   version == o.version;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const;
+    };
+
+    explicit ResponseCache(size_t maxEntries);
+
+    Payload get(const Key &key);                          // 未命中返回空指针
+    uint64_t ticket(const Key &key);                      // 查询数据库之前调用
+    void put(const Key &key, uint64_t ticket, Payload payload);
+    void invalidate(const Key &key);                      // 数据库写入提交之后调用
+
+    const ResponseCacheStats &stats() const { return cacheStats; }
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    // 每个分片的版本槽数：写入合并提交时一批失效会落在各个分片，
+    // 只有哈希到同一槽位的 key 才会连带丢弃在途填充（一次提交 64 个写入时约 1% 的概率）
+    static constexpr size_t VERSION_SLOTS = 1024;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        uint64_t versions[VERSION_SLOTS] = {};  // 哈希到该槽位的 key 每次失效加一
+        std::unordered_map<Key, Payload, KeyHash> entries;
+    };
+
+    Shard &shardFor(const Key &key);
+    static size_t versionSlot(const Key &key);
+
+    size_t maxPerShard;
+    std::unique_ptr<Shard[]> shards;
+    ResponseCacheStats cacheStats;
+};
+
+#endif // RESPONSECACHE_H
@@ -0,0 +1,75 @@
+// SessionTable.h
+// 在线会话表：按 userId 分片的开放寻址哈希表
+// 查找（消息推送路径）不加锁、步数有上界；登录/退出只锁对应分片
+#ifndef SESSIONTABLE_H
+#define SESSIONTABLE_H
+
+#include <netinet/in.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class SessionTable {
+public:
+    // initialCapacity: 每个分片的初始槽位数（向上取 2 的幂）
+    explicit SessionTable(size_t initialCapacity = 64);
+    ~SessionTable();
+
+    SessionTable(const SessionTable &) = delete;
+    SessionTable &operator=(const SessionTable &) = delete;
+
+    // 用户已在线时返回 false；now 为最近活跃时刻，epoch 返回本次登录的版本号，
+    // features 为登录时协商的特性（协议头 flags 中的 FLAG_ACCEPT_* 位）
+    bool insert(int userId, const sockaddr_in &addr, uint32_t now = 0, uint32_t *epoch = nullptr,
+                uint16_t features = 0);
+    bool erase(int userId);                            // 用户不在线时返回 false
+    bool lookup(int userId, sockaddr_in &addr) const;  // 无锁、无等待
+    bool contains(int userId) const;
+    // 心跳：更新最近活跃时刻，无锁；用户不在线或来源地址与登录地址不符时返回 false
+    bool touch(int userId, const sockaddr_in &addr, uint32_t now);
+    // 会话协商的特性，无锁；用户不在线或来源地址与登录地址不符时返回 0
+    uint16_t features(int userId, const sockaddr_in &addr) const;
+
+    enum class IdleCheck { Gone, Alive, Expired };
+    // 超时检查：会话已下线或已重新登录（epoch 不符）返回 Gone；
+    // 最近活跃时刻早于 idleBefore 则下线并返回 Expired，否则返回 Alive 并给出 lastSeen
+    IdleCheck expireIfIdle(int userId, uint32_t epoch, uint32_t idleBefore, uint32_t &lastSeen);
+    size_t size() const { return online.load(std::memory_order_relaxed); }
+
+private:
+    // key 一经写入不再清除，退出登录只清空 value，同一用户再次登录时复用该槽位
+    struct Slot {
+        std::atomic<int32_t> key;
+        std::atomic<uint64_t> value;  // 在线标志 | IPv4 地址 | 端口，0 表示不在线
+        std::atomic<uint32_t> lastSeen;
+        std::atomic<uint32_t> epoch;  // 每次登录加一
+        std::atomic<uint16_t> features;
+    };
+    struct Table {
+        explicit Table(size_t capacity);
+        size_t mask;
+        size_t used;  // 已占用 key 的槽位数，仅由持锁的写者访问
+        std::unique_ptr<Slot[]> slots;
+    };
+    struct alignas(64) Shard {
+        std::atomic<Table*> table{nullptr};
+        std::mutex writeMutex;
+        // 扩容后的旧表不立即释放：读者可能仍在其上探测。容量按 2 倍增长，旧表总和不超过当前表
+        std::vector<std::unique_ptr<Table>> generations;
+    };
+
+    static constexpr size_t SHARD_COUNT = 64;
+
+    static size_t hash(int userId);
+    Shard &shardFor(int userId) const;
+    static const Slot *find(const Table *t, int userId);
+    Slot *findOrClaim(Shard &shard, int userId);  // 调用方须持有分片写锁
+
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<size_t> online{0};
+};
+
+#endif // SESSIONTABLE_H
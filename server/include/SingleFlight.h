@@ -0,0 +1,86 @@
+// SingleFlight.h
+// 相同请求合并：同一 key 的查询正在执行时，后到的调用不再重复执行，只登记回调，
+// 由执行者完成后把同一份结果交给所有等待者。等待者不阻塞工作线程
+// 执行者可以把查询交给流水线的后续阶段（join / finish），结果在完成查询的线程上交付
+#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct SingleFlightStats {
+    std::atomic<uint64_t> calls{0};       // 调用总数
+    std::atomic<uint64_t> executions{0};  // 实际执行的次数，calls - executions 即被合并的调用
+};
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class SingleFlight {
+public:
+    using Deliver = std::function<void(const Value &)>;
+
+    // 一次正在执行的调用：执行者自己的 deliver 与后到的等待者
+    struct Flight {
+        Deliver leader;
+        std::vector<Deliver> waiters;
+    };
+    using Handle = std::shared_ptr<Flight>;
+
+    // 没有同 key 的调用在执行时由当前线程执行 fn，否则把 deliver 挂到正在执行的调用上后立即返回
+    template <typename Fn>
+    void run(const Key &key, Fn &&fn, Deliver deliver) {
+        if (Handle flight = join(key, std::move(deliver))) finish(key, flight, fn());
+    }
+
+    // 分阶段执行的版本：返回非空时调用方成为执行者，查询可以交给其他线程，完成后调用 finish；
+    // 返回空时 deliver 已挂到正在执行的调用上
+    Handle join(const Key &key, Deliver deliver) {
+        flightStats.calls.fetch_add(1, std::memory_order_relaxed);
+        auto flight = std::make_shared<Flight>();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = inflight.find(key);
+            if (it != inflight.end()) {
+                it->second->waiters.push_back(std::move(deliver));
+                return nullptr;
+            }
+            inflight.emplace(key, flight);
+        }
+        flightStats.executions.fetch_add(1, std::memory_order_relaxed);
+        flight->leader = std::move(deliver);
+        return flight;
+    }
+
+    // 把结果交给执行者与所有等待者，在调用线程上执行各个 deliver
+    void finish(const Key &key, const Handle &flight, const Value &value) {
+        std::vector<Deliver> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = inflight.find(key);
+            if (it != inflight.end() && it->second == flight) inflight.erase(it);
+            waiters = std::move(flight->waiters);
+        }
+        flight->leader(value);
+        for (auto &w : waiters) w(value);
+    }
+
+    // 数据被修改后调用：正在执行的查询可能读到旧数据，此后的调用不再合并到它上面
+    void forget(const Key &key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        inflight.erase(key);
+    }
+
+    const SingleFlightStats &stats() const { return flightStats; }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<Key, std::shared_ptr<Flight>, Hash> inflight;
+    SingleFlightStats flightStats;
+};
+
+#endif // SINGLEFLIGHT_H
@@ -0,0 +1,77 @@
+// Stage.h
+// 流水线阶段（SEDA）：一组专用线程，每个线程一个有界队列
+// 请求处理拆成解码、存储、编码发送几个阶段，各阶段线程分开：数据库延迟只占用存储阶段的线程（见 AsyncDatabase.h），
+// 不会拖住解析请求与编码响应这些 CPU 密集的工作
+// 任务按 key 固定交给其中一个线程，同一 key（同一用户）的任务按提交顺序执行，不同 key 分散到各线程并行
+// 队列满时提交方阻塞等待，背压逐级传回上游，最终在入口由线程池的容量与溢出策略丢弃请求；
+// 阶段之间只能单向提交（解码 -> 存储 -> 编码），阶段内的任务也不能向本阶段提交，阻塞等待才不会成环
+// 跨阶段传递的闭包通常带着整个请求，超出 Task 的内联存储，这里用 std::function
+#ifndef STAGE_H
+#define STAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct StageStats {
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> blocked{0};   // 队列满而阻塞等待的提交
+    std::atomic<uint64_t> maxDepth{0};  // 观察到的最大排队任务数（各线程合计）
+    std::atomic<uint64_t> waitUs{0};    // 累计排队时长
+    std::atomic<uint64_t> runUs{0};     // 累计执行时长
+};
+
+class Stage {
+public:
+    using Job = std::function<void()>;
+
+    // capacity 为每个线程的队列长度
+    Stage(const char *name, size_t threads, size_t capacity);
+    ~Stage();
+
+    Stage(const Stage &) = delete;
+    Stage &operator=(const Stage &) = delete;
+
+    // 停止后提交的任务在调用线程上直接执行
+    void submit(uint64_t key, Job job);
+    // 执行完已排队的任务后退出各线程，可重复调用
+    void shutdown();
+
+    const char *name() const { return stageName; }
+    size_t threadCount() const { return workers.size(); }
+    size_t capacity() const { return perThread * workers.size(); }
+    size_t depth() const { return queued.load(std::memory_order_relaxed); }
+    const StageStats &stats() const { return stageStats; }
+
+private:
+    struct Item {
+        Job job;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<Item> queue;
+        bool stop = false;
+        std::thread thread;
+    };
+
+    void run(Worker &w);
+
+    const char *stageName;
+    size_t perThread;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> queued;
+    StageStats stageStats;
+};
+
+#endif // STAGE_H
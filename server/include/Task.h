@@ -0,0 +1,97 @@
+// Task.h
+// 线程池任务：只可移动的类型擦除可调用对象，闭包直接存放在对象内部的固定缓冲区中，
+// 构造、入队、出队与执行都不分配内存（std::function 超过两个指针大小的闭包会放到堆上）
+// 闭包可以另外提供 shed() 成员：任务被线程池丢弃而不执行时调用它，执行与丢弃两条路径共用同一份捕获的状态
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class Task {
+public:
+    static constexpr size_t CAPACITY = 64;  // 足够放下收包批次的处理闭包（见 ChatServer::PacketTask）
+
+    Task() noexcept : ops(nullptr) {}
+
+    // explicit：避免与接受 std::function 的重载产生歧义
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    explicit Task(F &&f) : ops(&OpsFor<std::decay_t<F>>::table) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= CAPACITY, "闭包超出 Task 的内联存储，请减少捕获或增大 CAPACITY");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "闭包对齐要求超出 Task 的内联存储");
+        static_assert(std::is_nothrow_move_constructible<Fn>::value, "闭包须可无异常移动");
+        new (storage) Fn(std::forward<F>(f));
+    }
+
+    Task(Task &&o) noexcept : ops(o.ops) {
+        if (ops) {
+            ops->move(storage, o.storage);
+            o.ops = nullptr;
+        }
+    }
+
+    Task &operator=(Task &&o) noexcept {
+        if (this != &o) {
+            reset();
+            if (o.ops) {
+                o.ops->move(storage, o.storage);
+                ops = o.ops;
+                o.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task() { reset(); }
+
+    explicit operator bool() const { return ops != nullptr; }
+
+    void operator()() { ops->run(storage); }
+    // 任务被丢弃时调用闭包的 shed()，没有该成员时什么也不做
+    void shed() { if (ops) ops->shed(storage); }
+
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*run)(void *);
+        void (*shed)(void *);
+        void (*move)(void *dst, void *src);  // 移动构造到 dst 并析构 src
+        void (*destroy)(void *);
+    };
+
+    template <typename Fn, typename = void>
+    struct HasShed : std::false_type {};
+    template <typename Fn>
+    struct HasShed<Fn, std::void_t<decltype(std::declval<Fn&>().shed())>> : std::true_type {};
+
+    template <typename Fn>
+    struct OpsFor {
+        static void run(void *p) { (*static_cast<Fn*>(p))(); }
+        static void shed(void *p) {
+            if constexpr (HasShed<Fn>::value) static_cast<Fn*>(p)->shed();
+            else (void)p;
+        }
+        static void move(void *dst, void *src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void *p) { static_cast<Fn*>(p)->~Fn(); }
+        static constexpr Ops table{run, shed, move, destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char storage[CAPACITY];
+    const Ops *ops;
+};
+
+#endif // TASK_H
@@ -1,29 +1,149 @@
 // ThreadPool.h
-// 简单线程池声明，用于并发任务处理
+// 工作窃取线程池，用于并发任务处理
+// 外部线程（收包线程）提交的任务进入各调度类的无锁注入队列；工作线程自己提交的后续任务压入私有双端队列，
+// 空闲的工作线程从其他线程的双端队列窃取。取不到任务时先自旋，再让出 CPU，最后才休眠，
+// 提交方只在确有线程休眠时才唤醒，队列忙时入队与出队都不经过互斥锁与系统调用
+// 注入队列有容量上限，队列满时按溢出策略丢弃任务并调用其 shed()，防止过载时内存与排队延迟无限增长
+// 任务分属若干调度类：严格优先的类只要有任务就先执行；
+// 其余各类按权重做差额轮询（DRR），每个任务按入队时给出的代价扣除额度，重任务多的类不会挤占其他类。
+// 额度由每个工作线程各自记账，整体比例近似等于权重
+// 任务不可抢占，可以预留若干工作线程只执行严格优先的任务，长任务占满其余线程时高优先级任务仍能立即开始
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
+#include "Task.h"
+#include "WorkQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <thread>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 
+// 队列满时的处理方式
+enum class OverflowPolicy {
+    DropNewest,  // 丢弃新任务
+    DropOldest,  // 丢弃队首（排队最久的）任务，接纳新任务
+    RejectBusy   // 拒绝新任务，由任务的 shed() 通知请求方稍后重试
+};
+
+// 各项准入决策的计数
+struct ThreadPoolStats {
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> droppedNewest{0};
+    std::atomic<uint64_t> droppedOldest{0};
+    std::atomic<uint64_t> rejectedBusy{0};
+    std::atomic<uint64_t> preempted{0};  // 队列满时为高优先级任务让位而丢弃的低优先级任务
+    std::atomic<uint64_t> maxDepth{0};  // 观察到的最大队列长度
+    std::atomic<uint64_t> steals{0};    // 从其他工作线程窃取的任务
+    std::atomic<uint64_t> parks{0};     // 工作线程自旋后仍无任务而休眠的次数
+};
+
+// 每个调度类的排队延迟（入队到开始执行）
+struct SchedClassStats {
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> waitUs{0};     // 累计排队时长
+    std::atomic<uint64_t> maxWaitUs{0};
+};
+
 class ThreadPool {
 public:
-    ThreadPool(size_t workerCount);
+    // 调度类按优先级从高到低排列；strict 为真时严格优先，否则按 weight 分享严格类之外的处理时间
+    struct ClassConfig {
+        const char *name;
+        bool strict;
+        unsigned weight;
+    };
+
+    // capacity 为 0 表示不限制队列长度（各类合计，实际受注入队列大小 UNBOUNDED_RING 限制）；classes 为空时只有一个类
+    // reserved 为只执行严格优先任务的工作线程数，至少留一个线程给其他类
+    ThreadPool(size_t workerCount, size_t capacity = 0, OverflowPolicy policy = OverflowPolicy::DropNewest,
+               std::vector<ClassConfig> classes = {}, size_t reserved = 0);
     ~ThreadPool();
 
-    void enqueue(std::function<void()> task);
+    // 返回新任务是否被接纳；被丢弃的任务（新任务或被挤出的旧任务）在调用线程上执行其 shed()
+    // cls 为调度类下标，cost 为任务的相对代价（按权重轮询时扣除的额度）
+    // 队列满时先挤出优先级更低的类中排队最久的任务，没有更低的类时才按溢出策略处理
+    // 在本池的工作线程上提交的非严格类任务视为已接纳任务的后续，压入该线程的双端队列，不受容量限制
+    // 注入队列与双端队列的槽位都内联存放 Task，无论从哪个线程提交，整个入队与执行过程都不分配内存
+    // local 为 false 时工作线程提交的任务也进入注入队列，排在已等待的同类任务之后（用于让出执行权的后续任务）
+    bool enqueue(Task task, size_t cls = 0, uint32_t cost = 1, bool local = true);
+    // 便捷重载：onShed 在任务被丢弃时调用；std::function 可能分配内存，热路径请直接构造 Task
+    bool enqueue(std::function<void()> task, std::function<void()> onShed = nullptr,
+                 size_t cls = 0, uint32_t cost = 1);
     void shutdown();
 
+    size_t capacity() const { return maxTasks; }
+    size_t depth() const { return queued.load(std::memory_order_relaxed); }  // 注入队列中当前排队的任务数
+    OverflowPolicy policy() const { return overflow; }
+    const ThreadPoolStats &stats() const { return poolStats; }
+    size_t workerCount() const { return workers.size(); }
+    size_t classCount() const { return classes.size(); }
+    const char *className(size_t cls) const { return classes[cls].config.name; }
+    const SchedClassStats &classStats(size_t cls) const { return perClass[cls]; }
+
+    static constexpr size_t UNBOUNDED_RING = 1 << 14;  // capacity 为 0 时每个注入队列的大小
+    static constexpr size_t LOCAL_DEQUE = 1024;        // 每个工作线程双端队列的容量，满时改入注入队列
+    static constexpr unsigned SPIN_ROUNDS = 64;        // 休眠前忙等检查的轮数
+    static constexpr unsigned YIELD_ROUNDS = 4;        // 忙等之后让出 CPU 再检查的轮数
+
 private:
+    struct Job {
+        Task task;
+        uint32_t cost = 1;
+        uint32_t cls = 0;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct SchedClass {
+        ClassConfig config;
+        std::unique_ptr<MpmcRing<Job>> inject;
+    };
+
+    // 休眠的工作线程按能执行的任务分成两组：预留线程只等严格优先的任务
+    struct ParkingLot {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<size_t> sleepers{0};
+        size_t permits = 0;
+    };
+
+    struct alignas(64) Worker {
+        explicit Worker(bool reserved) : reserved(reserved), local(LOCAL_DEQUE) {}
+        bool reserved;
+        ChaseLevDeque<Job> local;
+        std::vector<int64_t> deficit;  // 本线程的差额轮询额度
+        size_t cursor = 0;
+        uint32_t rng;                  // 选择窃取对象
+    };
+
+    void workerLoop(size_t index);
+    bool next(Worker &w, size_t index, Job &job);  // 按优先级取下一个任务
+    bool popWeighted(Worker &w, Job &job);
+    bool steal(Worker &w, size_t index, Job &job);
+    bool hasWork(const Worker &w) const;
+    bool park(Worker &w);  // 返回是否被唤醒的共享线程（已计入 searching）
+    void wake(size_t cls);
+    void wake(ParkingLot &lot);
+    void run(Job &job);
+    bool evictFrom(size_t lowest, Job &shed);  // 从优先级不高于 lowest 的最低类中挤出排队最久的任务
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    bool stop;
+    std::vector<std::unique_ptr<Worker>> state;
+    std::vector<SchedClass> classes;
+    std::unique_ptr<SchedClassStats[]> perClass;
+    std::atomic<size_t> queued;  // 注入队列中的任务数（近似值，用于准入）
+    std::atomic<unsigned> searching;  // 正在找任务（忙等或刚被唤醒）的共享线程数
+    ParkingLot sharedLot;
+    ParkingLot reservedLot;
+    std::atomic<bool> stop;
+    size_t maxTasks;
+    OverflowPolicy overflow;
+    const unsigned spinRounds;  // 单核机器上忙等只会抢占收包线程，为 0 时直接休眠
+    ThreadPoolStats poolStats;
 };
 
-#endif // THREADPOOL_H
\ No newline at end of file
+#endif // THREADPOOL_H
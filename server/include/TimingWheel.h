@@ -0,0 +1,43 @@
+// TimingWheel.h
+// 分层时间轮：4 层 × 64 槽，以 tick 为单位调度到期事件
+// 插入 O(1)，每个 tick 只处理当前槽位；高层槽位到点时整体下沉到低层（每个条目最多下沉 3 次）
+// 非线程安全，由调用方加锁
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class TimingWheel {
+public:
+    struct Entry {
+        int id;
+        uint32_t epoch;   // 调用方自定义的版本号，用于识别已失效的条目
+        uint64_t expire;  // 到期 tick
+    };
+
+    explicit TimingWheel(uint64_t startTick = 0);
+
+    void schedule(const Entry &e);
+    // 推进到 nowTick，依次回调所有到期条目
+    void advance(uint64_t nowTick, const std::function<void(const Entry &)> &onExpire);
+
+    uint64_t now() const { return current; }
+    size_t size() const { return count; }
+
+private:
+    static constexpr unsigned LEVELS = 4;
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+
+    void place(const Entry &e);  // 要求 e.expire >= current
+
+    uint64_t current;
+    size_t count;
+    std::vector<Entry> slots[LEVELS][SLOTS];
+    std::vector<Entry> overdue;  // 调度时已过期的条目，下一次推进时回调
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,117 @@
+// UringTransport.h
+// io_uring 收发后端：多次触发(multishot) recvmsg + 内核提供缓冲环收包，
+// 发送队列中的数据报每轮循环批量提交为 sendmsg，大报文可走零拷贝 sendmsg
+// 直接使用系统调用与内核头文件，不依赖 liburing
+#ifndef URINGTRANSPORT_H
+#define URINGTRANSPORT_H
+
+#include "EgressQueue.h"
+#include "PacketBuffer.h"
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct UringStats {
+    std::atomic<uint64_t> enterCalls{0};
+    std::atomic<uint64_t> sendSubmitted{0};
+    std::atomic<uint64_t> zeroCopySends{0};
+    std::atomic<uint64_t> sendErrors{0};
+    std::atomic<uint64_t> recvRearms{0};  // 多次触发 recvmsg 被内核终止（如缓冲耗尽）后重新提交的次数
+    std::atomic<uint64_t> poolRetries{0}; // 缓冲池耗尽、等待重试补充接收缓冲区的次数
+};
+
+class UringTransport {
+public:
+    // 收到的数据报就是内核填充的池缓冲区，最后一个引用释放时自动归还缓冲池
+    using BatchHandler = std::function<void(PacketChain &&packets)>;
+
+    // bufSize: 单个数据报的最大长度；提供给内核的缓冲区取自 pool
+    UringTransport(int fd, BufferPool &pool, unsigned entries, unsigned bufCount, size_t bufSize,
+                   size_t zeroCopyThreshold);
+    ~UringTransport();
+
+    bool init();
+    // 由本实例负责排空发送队列（仅应有一个实例挂接）
+    void attachEgress(EgressQueue *queue);
+
+    void run(const BatchHandler &onBatch);  // 在收包线程中运行，直到 stop()
+    void stop();
+    void wake();
+
+    const UringStats &stats() const { return uringStats; }
+
+private:
+    // 一轮循环中提交的发送批次，完成前须保持数据与 msghdr 有效
+    struct SendSlot {
+        std::vector<OutDatagram> datagrams;
+        std::vector<msghdr> hdrs;
+        std::vector<iovec> iovs;
+        unsigned remaining = 0;
+    };
+
+    io_uring_sqe *getSqe();
+    int submit(unsigned waitFor);
+    void armRecv();
+    void armWake();
+    void armRetryTimer();
+    bool refill(uint16_t bid);
+    void replenish();
+    void submitSends();
+    void onSendCompletion(uint32_t slot, const io_uring_cqe &cqe, bool zeroCopy);
+    void reap(PacketChain &packets);
+
+    int sockfd;
+    int ringFd;
+    int wakeFd;
+    unsigned entries;
+    unsigned bufCount;
+    size_t bufSize;
+    size_t zeroCopyThreshold;
+
+    // 提交队列 / 完成队列映射
+    void *sqRingPtr;
+    void *cqRingPtr;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    io_uring_cqe *cqes;
+    unsigned sqeTail;
+    unsigned toSubmit;
+
+    // 内核提供缓冲环，bid 对应的池缓冲区在收包完成后交给上层，随即换入新的缓冲区
+    BufferPool &pool;
+    io_uring_buf_ring *bufRing;
+    size_t bufRingSize;
+    std::vector<PacketRef> bufSlots;
+    std::vector<uint16_t> emptyBids;  // 缓冲池耗尽时暂未补上的 bid
+    unsigned bufTail;
+    msghdr recvMsg;
+    bool recvArmed;
+    bool recvFailed;          // 收包出现无法恢复的错误后不再重复提交
+    unsigned bufsAvailable;   // 已提供给内核但尚未被占用的缓冲区数量
+    bool retryArmed;
+    __kernel_timespec retryTs;
+
+    EgressQueue *egress;
+    std::vector<std::unique_ptr<SendSlot>> sendSlots;
+    std::vector<uint32_t> freeSendSlots;
+    size_t inflightSends;
+
+    std::atomic<bool> stopping;
+    UringStats uringStats;
+};
+
+#endif // URINGTRANSPORT_H
@@ -0,0 +1,179 @@
+// WorkQueue.h
+// 线程池使用的两种无锁队列：
+//   MpmcRing      有界多生产者多消费者环形队列（Vyukov），收包线程向线程池注入任务
+//   ChaseLevDeque 工作线程私有的双端队列，所有者在底端压入弹出，空闲线程从顶端窃取
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 每个槽位带序号：序号等于写位置时可写，等于写位置 + 1 时可读，生产者与消费者各自只竞争一个下标
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity) : mask(roundUp(capacity) - 1), cells(new Cell[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    MpmcRing(const MpmcRing &) = delete;
+    MpmcRing &operator=(const MpmcRing &) = delete;
+
+    // 队列满时返回 false，value 保持不变
+    bool push(T &&value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似判断，只用于决定是否休眠
+    bool empty() const {
+        return head.load(std::memory_order_acquire) >= tail.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t roundUp(size_t v) {
+        size_t p = 2;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+// 固定容量，元素按值存放在槽位中，入队出队都不分配内存；所有者线程之外只能调用 steal 与 empty
+// 内存序按 Lê 等人《Correct and Efficient Work-Stealing for Weak Memory Models》的 C11 版本
+// 原算法中窃取者在 CAS 之前读出元素，元素只能是指针；这里窃取者先以 CAS 取得位置再移出元素，
+// 槽位另带序号：位置 p 的元素被窃取者移出后序号才变为 p + 容量，所有者绕回到该槽位时据此确认窃取者已读完
+template <typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(size_t capacity) : mask(roundUp(capacity) - 1), slots(new Slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) slots[i].seq.store(static_cast<int64_t>(i), std::memory_order_relaxed);
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque &) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+    // 满（或绕回的槽位仍在被窃取者读取）时返回 false，value 保持不变，由调用方改放其他队列
+    bool push(T &&value) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > static_cast<int64_t>(mask)) return false;
+        Slot &slot = slots[b & mask];
+        if (slot.seq.load(std::memory_order_acquire) != b) return false;
+        slot.value = std::move(value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(T &out) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        Slot &slot = slots[b & mask];
+        if (t < b) {
+            // 位置 b 仍归所有者，之后的 push 会再次写入同一位置，序号不变
+            out = std::move(slot.value);
+            return true;
+        }
+        // 只剩最后一个元素，与窃取者竞争；取得后位置 b 与 top 一起前移，槽位下次在 b + 容量处使用
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        if (!won) return false;
+        out = std::move(slot.value);
+        slot.seq.store(b + static_cast<int64_t>(mask) + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool steal(T &out) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+        Slot &slot = slots[t & mask];
+        out = std::move(slot.value);
+        slot.seq.store(t + static_cast<int64_t>(mask) + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Slot {
+        std::atomic<int64_t> seq;  // 等于位置时所有者可写入
+        T value;
+    };
+
+    static size_t roundUp(size_t v) {
+        size_t p = 2;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+};
+
+#endif // WORKQUEUE_H
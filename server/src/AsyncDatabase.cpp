@@ -0,0 +1,117 @@
+#include "AsyncDatabase.h"
+#include <algorithm>
+#include <iostream>
+
+AsyncDatabase::AsyncDatabase(const std::string &dbFile, size_t capacity, size_t maxBatch)
+    : db(dbFile), queueCapacity(capacity ? capacity : 1), batchLimit(maxBatch ? maxBatch : 1), queued(0),
+      thread([this] { run(); }) {}
+
+AsyncDatabase::~AsyncDatabase() {
+    shutdown();
+}
+
+bool AsyncDatabase::init() {
+    return db.init();
+}
+
+void AsyncDatabase::post(Op op) {
+    auto now = std::chrono::steady_clock::now();
+    size_t depth;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (queue.size() >= queueCapacity && !stop) {
+            storageStats.blocked.fetch_add(1, std::memory_order_relaxed);
+            notFull.wait(lock, [&] { return queue.size() < queueCapacity || stop; });
+        }
+        if (stop) {
+            lock.unlock();
+            runAlone(op);
+            return;
+        }
+        queue.push_back(Item{std::move(op), now});
+        depth = queued.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    storageStats.submitted.fetch_add(1, std::memory_order_relaxed);
+    if (depth > storageStats.maxDepth.load(std::memory_order_relaxed))
+        storageStats.maxDepth.store(depth, std::memory_order_relaxed);
+    notEmpty.notify_one();
+}
+
+void AsyncDatabase::run() {
+    std::vector<Item> batch;
+    std::vector<Commit> done;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [&] { return !queue.empty() || stop; });
+            if (queue.empty()) return;  // 已停止且排空
+            size_t n = std::min(queue.size(), batchLimit);
+            for (size_t i = 0; i < n; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            queued.fetch_sub(n, std::memory_order_relaxed);
+        }
+        notFull.notify_all();
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t waited = 0;
+        bool committed;
+        {
+            DatabaseManager::Batch txn(db);
+            for (auto &item : batch) {
+                waited += static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(start - item.enqueued).count());
+                if (Commit c = item.op(db)) done.push_back(std::move(c));
+            }
+            committed = txn.commit();
+        }
+        if (!committed) {
+            // 整批已回滚，本次执行得到的回调作废；逐个重新执行，各自提交后再回调
+            storageStats.failedCommits.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[ERROR] 存储事务提交失败，已回滚，逐个重试 " << batch.size() << " 个操作" << std::endl;
+            done.clear();
+            storageStats.retriedOps.fetch_add(batch.size(), std::memory_order_relaxed);
+            for (auto &item : batch) runAlone(item.op);
+        }
+        auto end = std::chrono::steady_clock::now();
+        storageStats.transactions.fetch_add(1, std::memory_order_relaxed);
+        if (batch.size() > storageStats.maxBatch.load(std::memory_order_relaxed))
+            storageStats.maxBatch.store(batch.size(), std::memory_order_relaxed);
+        storageStats.waitUs.fetch_add(waited, std::memory_order_relaxed);
+        storageStats.runUs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()),
+            std::memory_order_relaxed);
+
+        // 提交之后再通知各操作的提交方；回调可能因下游队列满而阻塞，这时存储线程不持有任何锁
+        for (auto &c : done) c(true);
+        done.clear();
+        batch.clear();
+    }
+}
+
+bool AsyncDatabase::runAlone(Op &op) {
+    Commit done;
+    bool committed;
+    {
+        DatabaseManager::Batch txn(db);
+        done = op(db);
+        committed = txn.commit();
+    }
+    if (!committed) {
+        storageStats.failedOps.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[ERROR] 存储操作提交失败，已回滚" << std::endl;
+    }
+    if (done) done(committed);
+    return committed;
+}
+
+void AsyncDatabase::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+    if (thread.joinable()) thread.join();
+}
@@ -1,418 +1,1094 @@
 #include "ChatServer.h"
 #include "Config.h"
+#include "Dispatch.h"
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <iostream>
 #include <cstring>
+#include <csignal>
+#include <algorithm>
 
 namespace {
-void sendPacket(int sockfd, const sockaddr_in &addr, MessageType type, const std::vector<uint8_t> &payload) {
-    PacketHeader hdr{ type, static_cast<uint32_t>(payload.size()) };
-    std::vector<uint8_t> packet(sizeof(hdr) + payload.size());
-    memcpy(packet.data(), &hdr, sizeof(hdr));
-    memcpy(packet.data() + sizeof(hdr), payload.data(), payload.size());
-    sendto(sockfd, packet.data(), packet.size(), 0,
-           reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+// 线程池的调度类，下标与 SchedClass 一致；关闭优先级调度时所有请求共用一个 FIFO
+std::vector<ThreadPool::ClassConfig> schedClasses(bool enabled) {
+    if (!enabled) return {{"fifo", false, 1}};
+    return {{"interactive", true, 0},
+            {"normal", false, SCHED_WEIGHT_NORMAL},
+            {"bulk", false, SCHED_WEIGHT_BULK}};
+}
+
+// 按 Config.h 的速率创建限速器，并为每种请求设置令牌消耗；用户的桶只计入来自其登录地址的请求
+std::unique_ptr<RateLimiter> makeRateLimiter(const SessionTable &sessions) {
+    auto limiter = std::make_unique<RateLimiter>(RATE_LIMIT_TABLE_SIZE, RATE_SOURCE_PER_SEC, RATE_SOURCE_BURST,
+                                                 RATE_USER_PER_SEC, RATE_USER_BURST, &sessions);
+    for (uint8_t type : {REGISTER_REQ, LOGIN_REQ})
+        limiter->setCost(type, RATE_COST_QUERY, false);
+    for (uint8_t type : {FRIEND_LIST_REQ, FRIEND_REQUEST_LIST_REQ, CHAT_HISTORY_REQ, CHAT_HISTORY_PAGE_REQ})
+        limiter->setCost(type, RATE_COST_QUERY, true);
+    for (uint8_t type : {UPDATE_USER_REQ, DELETE_USER_REQ, FRIEND_REQUEST_REQ, DELETE_FRIEND_REQ,
+                         BLOCK_USER_REQ, UNBLOCK_USER_REQ, JOIN_GROUP_REQ, PRIVATE_MSG_REQ})
+        limiter->setCost(type, RATE_COST_DEFAULT, true);
+    // 批量请求按子请求个数计费（见 dispatch）
+    limiter->setCost(MULTI_REQ, RATE_COST_MULTI_ITEM, false);
+    // 退出登录、心跳与分片确认不限速，否则被限速的客户端无法正常下线或收完响应
+    for (uint8_t type : {LOGOUT_REQ, HEARTBEAT_REQ, FRAGMENT_ACK})
+        limiter->setCost(type, 0, false);
+    return limiter;
+}
+
+// 可能较大的响应：超过 FRAGMENT_THRESHOLD 时由 FragmentSender 分片发送
+// version 为请求使用的协议版本，响应头原样带回
+void sendPacket(FragmentSender &out, const sockaddr_in &addr, uint32_t requestId, uint8_t version, MessageType type,
+                std::vector<uint8_t> &&payload, uint16_t flags = 0) {
+#if ENABLE_SEND_LOG
     std::cout << "[SEND] Type: " << static_cast<int>(type) << ", Payload: " << payload.size() << std::endl;
+#endif
+    out.send(addr, type, requestId, std::move(payload), flags, version);
+}
+
+void sendPacket(FragmentSender &out, const sockaddr_in &addr, uint32_t requestId, uint8_t version, MessageType type,
+                std::shared_ptr<const std::vector<uint8_t>> payload, uint16_t flags = 0) {
+#if ENABLE_SEND_LOG
+    std::cout << "[SEND] Type: " << static_cast<int>(type) << ", Payload: " << payload->size() << std::endl;
+#endif
+    out.send(addr, type, requestId, std::move(payload), flags, version);
+}
+
+// 响应交给请求方：MULTI_REQ 的子请求汇总到 multi，否则直接发送
+void reply(FragmentSender &out, const std::shared_ptr<MultiReply> &multi, uint16_t index, const sockaddr_in &addr,
+           uint32_t requestId, uint8_t version, MessageType type,
+           std::shared_ptr<const std::vector<uint8_t>> payload, uint16_t flags = 0) {
+    if (multi) multi->add(index, type, flags, std::move(payload));
+    else sendPacket(out, addr, requestId, version, type, std::move(payload), flags);
+}
+
+// 可放进 MULTI_REQ 的子请求：登录要协商会话特性并推送离线消息，心跳与分片确认没有响应，
+// 分页聊天记录本身就分多个数据报发送，批量请求不嵌套
+bool batchable(uint8_t type) {
+    return type != LOGIN_REQ && type != HEARTBEAT_REQ && type != FRAGMENT_ACK &&
+           type != CHAT_HISTORY_PAGE_REQ && type != MULTI_REQ;
+}
+
+// 批量文本类响应：对协商了压缩的会话以压缩封装发送（见 Compression.h）
+bool compressible(uint8_t type) {
+    return type == OFFLINE_MSG_LIST_RESP || type == CHAT_HISTORY_RESP;
+}
+
+// 好友与好友请求列表的负载格式随协议版本变化：版本 2 起使用紧凑列表编码
+uint8_t listVersion(const Request &req) {
+    return req.header.version >= VERSION_COMPACT_LISTS ? VERSION_COMPACT_LISTS : PROTOCOL_MIN_VERSION;
 }
 
-void sendSimpleResponseWithLog(int sockfd, const sockaddr_in &addr, MessageType type, bool ok, const std::string &msg) {
-    PacketHeader resp{ type, 1 };
-    uint8_t buf[sizeof(resp) + 1];
-    memcpy(buf, &resp, sizeof(resp));
-    buf[sizeof(resp)] = ok ? 1 : 0;
-    sendto(sockfd, buf, sizeof(buf), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+void sendSimpleResponseWithLog(EgressQueue &egress, const Request &req, MessageType type, bool ok, const std::string &msg) {
+    if (req.multi)
+        req.multi->add(req.subIndex, type, 0, std::make_shared<const std::vector<uint8_t>>(encodeMessage(StatusResp{ok})));
+    else
+        egress.push(req.addr, buildMessage(type, req.header.requestId, StatusResp{ok}, 0, req.header.version));
     std::cout << "[RESP] " << msg << (ok ? " Success" : " Fail") << std::endl;
 }
+
+// 只回复成败的请求：存储阶段给出结果与日志文字，编码阶段据此回复 StatusResp
+struct Status {
+    bool ok;
+    const char *what;
+};
+
+auto statusReply(EgressQueue &egress, MessageType type) {
+    return [&egress, type](const Request &req, const Status &s) {
+        sendSimpleResponseWithLog(egress, req, type, s.ok, s.what);
+    };
 }
 
-ChatServer::ChatServer(int port, const std::string &dbFile)
-    : sockfd(-1), serverAddr{}, pool(4), db(dbFile) {
+// 登录在存储阶段的结果：校验与登记会话之后顺带取出离线消息
+struct LoginResult {
+    bool ok;
+    int userId;
+    std::vector<MessageRecord> offline;
+};
+
+// 私聊在存储阶段的结果：接收方在线时由编码阶段推送，否则已存为离线消息
+struct DeliveryResult {
+    bool isFriend;
+    bool online;
+    sockaddr_in receiverAddr;
+};
+
+// 解码请求负载，格式错误时记录日志并返回 false，调用方直接丢弃该请求
+template <typename T>
+bool parseBody(const Request &req, T &msg) {
+    if (decodeMessage(req.body.data(), req.body.size(), msg)) return true;
+    std::cerr << "[WARN] 请求格式错误, type: " << static_cast<int>(req.header.type)
+              << ", from: " << inet_ntoa(req.addr.sin_addr) << ":" << ntohs(req.addr.sin_port) << std::endl;
+    return false;
+}
+}
+
+ChatServer::ChatServer(int port, const std::string &dbFile, const ServerOptions &opts)
+    : serverAddr{}, options(opts),
+      bufferPool(POOL_BUFFER_SIZE, POOL_SLAB_BUFFERS, POOL_MAX_SLABS, opts.hugePages),
+      egress(opts.egressBatchSize, std::chrono::microseconds(opts.egressFlushUs)),
+      fragments(egress, FRAGMENT_THRESHOLD, std::chrono::milliseconds(FRAGMENT_RTO_MS),
+                FRAGMENT_MAX_RETRIES, FRAGMENT_MAX_TRANSFERS),
+      pool(opts.workerCount, opts.queueCapacity, opts.overloadPolicy, schedClasses(opts.priorityScheduling),
+           opts.priorityScheduling ? SCHED_RESERVED_WORKERS : 0),
+      database(dbFile, DB_QUEUE_CAPACITY, opts.dbBatch),
+      encoder("encode", opts.encodeThreads, STAGE_QUEUE_CAPACITY), responseCache(RESPONSE_CACHE_ENTRIES),
+      startTime(std::chrono::steady_clock::now()) {
     serverAddr.sin_family = AF_INET;
     serverAddr.sin_port = htons(port);
     serverAddr.sin_addr.s_addr = INADDR_ANY;
+    if (opts.userLanes) {
+        lanes = std::make_unique<LaneExecutor>(
+            pool, LANE_COUNT, LANE_MAX_DEPTH, LANE_QUANTUM, opts.priorityScheduling,
+            [this](PacketRef &&pkt) {
+                auto waited = std::chrono::steady_clock::now() - pkt->queuedAt;
+                handleQueued(std::move(pkt), waited);
+            },
+            [this](const PacketChain &packets) { replyBusy(packets); });
+    }
 }
 
 ChatServer::~ChatServer() {
-    if (sockfd >= 0) close(sockfd);
+    // 正常退出时 start() 已完成以下步骤，这里均为幂等操作，兜底处理启动失败的情况
+    for (auto &l : listeners) {
+        if (l->uring) l->uring->stop();
+        l->loop.stop();
+        if (l->thread.joinable()) l->thread.join();
+    }
     pool.shutdown();
+    database.shutdown();
+    encoder.shutdown();
+    egress.stop();
+    for (auto &l : listeners)
+        if (l->fd >= 0) close(l->fd);
 }
 
 bool ChatServer::init() {
-    return db.init();
+    return database.init();
 }
 
 bool ChatServer::start() {
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) { perror("socket"); return false; }
-    if (bind(sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-        perror("bind"); close(sockfd); return false;
+    size_t count = options.listenerCount ? options.listenerCount : 1;
+    bool reusePort = count > 1;
+    // 所有监听器共用一个限速器：SO_REUSEPORT 按四元组分流，同一来源或用户的请求可能落在任一套接字上
+    if (options.rateLimit) limiter = makeRateLimiter(sessions);
+    for (size_t i = 0; i < count; ++i) {
+        auto l = std::make_unique<Listener>(static_cast<int>(i), bufferPool, options.recvRingSlots,
+                                            options.recvBatchSize, RECV_BUFFER_SIZE);
+        l->fd = openListenerSocket(serverAddr, reusePort);
+        if (l->fd < 0) return false;
+        listeners.push_back(std::move(l));
+    }
+    // 回复统一从第一个套接字发出，源端口与监听端口一致；
+    // io_uring 后端下由第一个监听器的环在每轮循环中排空发送队列
+    bool useUring = options.transport == 1 && setupUring();
+    if (useUring) {
+        UringTransport *u = listeners[0]->uring.get();
+        u->attachEgress(&egress);
+        egress.startExternal(listeners[0]->fd, [u]{ u->wake(); });
+    } else {
+        egress.start(listeners[0]->fd);
+    }
+    std::cout << "[INFO] Server listening on port " << ntohs(serverAddr.sin_port)
+              << ", listeners = " << count << ", transport = " << (useUring ? "io_uring" : "epoll")
+              << ", recv batch = " << options.recvBatchSize << std::endl;
+
+    if (!mainLoop.init()) return false;
+    mainLoop.watchSignals({SIGINT, SIGTERM}, [this](int sig) {
+        std::cout << "[INFO] 收到信号 " << sig << "，开始关闭服务器" << std::endl;
+        requestShutdown();
+    });
+    // 周期性任务与信号处理共用主循环，无需额外线程
+    mainLoop.addTimer(std::chrono::milliseconds(STATS_INTERVAL_MS), [this]{ logStats(); });
+    mainLoop.addTimer(std::chrono::milliseconds(FRAGMENT_RTO_MS), [this]{ fragments.onTimer(); });
+    mainLoop.addTimer(std::chrono::milliseconds(HEARTBEAT_TICK_MS), [this]{ expireIdleSessions(); });
+
+    unsigned cpus = std::thread::hardware_concurrency();
+    for (auto &l : listeners) {
+        Listener *lp = l.get();
+        if (lp->uring) {
+            l->thread = std::thread([this, lp]{
+                lp->uring->run([this, lp](PacketChain &&packets) {
+                    lp->stats.batches.fetch_add(1, std::memory_order_relaxed);
+                    lp->stats.packets.fetch_add(packets.size(), std::memory_order_relaxed);
+                    dispatch(*lp, std::move(packets));
+                });
+            });
+        } else {
+            if (!l->loop.init() ||
+                !l->loop.addFd(l->fd, EPOLLIN, [this, lp](uint32_t){ onReadable(*lp); }))
+                return false;
+            l->thread = std::thread([lp]{ lp->loop.run(); });
+        }
+        if (reusePort && options.pinListeners && cpus > 0) {
+            l->cpu = static_cast<int>(l->index % cpus);
+            pinThreadToCpu(l->thread, l->cpu);
+        }
+    }
+
+    mainLoop.run();
+
+    // 先停止收包，再按流水线顺序排空各阶段的在途任务（上游排空时仍可向下游提交），最后发出剩余回复
+    for (auto &l : listeners) {
+        if (l->uring) l->uring->stop();
+        else l->loop.stop();
+    }
+    for (auto &l : listeners)
+        if (l->thread.joinable()) l->thread.join();
+    pool.shutdown();
+    database.shutdown();
+    encoder.shutdown();
+    egress.stop();
+    logStats();
+    std::cout << "[INFO] 服务器已关闭" << std::endl;
+    return true;
+}
+
+bool ChatServer::setupUring() {
+    for (auto &l : listeners) {
+        l->uring = std::make_unique<UringTransport>(l->fd, bufferPool, URING_ENTRIES, URING_RECV_BUFFERS,
+                                                    RECV_BUFFER_SIZE, URING_ZEROCOPY_THRESHOLD);
+        if (!l->uring->init()) {
+            std::cerr << "[WARN] io_uring 初始化失败，回退到 epoll 后端" << std::endl;
+            for (auto &r : listeners) r->uring.reset();
+            return false;
+        }
     }
-    std::cout << "[INFO] Server listening on port " << ntohs(serverAddr.sin_port) << std::endl;
-    receiveLoop();
     return true;
 }
 
-void ChatServer::receiveLoop() {
-    while (true) {
-        sockaddr_in clientAddr;
-        socklen_t len = sizeof(clientAddr);
-        uint8_t buf[2048];
-        ssize_t n = recvfrom(sockfd, buf, sizeof(buf), 0,
-                             (struct sockaddr*)&clientAddr, &len);
-        if (n <= static_cast<ssize_t>(sizeof(PacketHeader))) continue;
-        std::vector<uint8_t> data(buf, buf + n);
-        pool.enqueue([this, clientAddr, data](){ handlePacket(clientAddr, data); });
+void ChatServer::requestShutdown() {
+    mainLoop.stop();
+}
+
+void ChatServer::onReadable(Listener &listener) {
+    // 尽量读空套接字；批次未填满说明暂时没有更多数据，交回 epoll 等待
+    for (;;) {
+        RecvBatch *batch = listener.ring.acquire();
+        int n = listener.ring.receive(listener.fd, batch);
+        if (n <= 0) {
+            // 返回 0 表示缓冲池耗尽，已丢弃一个数据报
+            if (n == 0) listener.stats.dropped.fetch_add(1, std::memory_order_relaxed);
+            listener.ring.release(batch);
+            return;
+        }
+        bool full = batch->count == listener.ring.batchSize();
+        listener.stats.batches.fetch_add(1, std::memory_order_relaxed);
+        listener.stats.packets.fetch_add(batch->count, std::memory_order_relaxed);
+
+        // 把缓冲区引用移出槽位后立即归还槽位，积压由线程池队列的容量上限约束
+        PacketChain packets;
+        for (unsigned i = 0; i < batch->count; ++i) packets.push(std::move(batch->packets[i]));
+        listener.ring.release(batch);
+        dispatch(listener, std::move(packets));
+        if (!full) return;
+    }
+}
+
+// 一个调度类的收包批次：执行时交给 handlePackets，被线程池丢弃时交给 shedPackets
+struct ChatServer::PacketTask {
+    ChatServer *server;
+    Listener *listener;
+    PacketChain packets;
+    std::chrono::steady_clock::time_point enqueued;
+
+    void operator()() { server->handlePackets(packets, enqueued); }
+    void shed() { server->shedPackets(*listener, packets); }
+};
+
+void ChatServer::dispatch(Listener &listener, PacketChain &&packets) {
+    // 协议头只在收包线程校验一次：魔数、版本或长度不符的数据报直接丢弃，
+    // 之后的限速、排队与处理都可以按固定偏移读取类型与负载
+    // 入队前限速：超出速率的请求在收包线程直接丢弃，不占用队列与数据库
+    auto now = std::chrono::steady_clock::now();
+    uint32_t nowMs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
+    // 启用串行通道时逐个请求交给所属用户的通道；否则按调度类拆分，每类一个任务，代价为其中各请求代价之和
+    PacketChain groups[SCHED_CLASS_COUNT];
+    uint32_t costs[SCHED_CLASS_COUNT] = {};
+    while (PacketRef pkt = packets.pop()) {
+        PacketHeader hdr;
+        if (pkt->truncated || !decodeHeader(pkt->data(), pkt->length, hdr)) {
+            listener.stats.malformed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // 批量请求按负载开头的子请求个数计费，超出上限的在 handleMulti 中整体丢弃，这里按上限计
+        uint32_t units = 1;
+        if (hdr.type == MULTI_REQ && hdr.length >= sizeof(uint32_t))
+            units = std::max<uint32_t>(1, std::min<uint32_t>(wire::load32(pkt->data() + PACKET_HEADER_SIZE),
+                                                             MULTI_MAX_REQUESTS));
+        if (limiter && !limiter->allow(pkt->addr, hdr.type, pkt->data() + PACKET_HEADER_SIZE, hdr.length, nowMs,
+                                       units))
+            continue;
+        if (lanes) {
+            // 通道积压超限的请求已在 submit 中按溢出策略回复，这里只计入丢弃数
+            if (!lanes->submit(std::move(pkt), hdr, now))
+                listener.stats.dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        const OpcodeTraits &traits = opcodeTraits(hdr.type);
+        size_t cls = options.priorityScheduling ? traits.cls : 0;
+        costs[cls] += traits.cost * units;
+        groups[cls].push(std::move(pkt));
     }
+    for (size_t cls = 0; cls < SCHED_CLASS_COUNT; ++cls) {
+        if (groups[cls].empty()) continue;
+        pool.enqueue(Task(PacketTask{this, &listener, std::move(groups[cls]), now}), cls, costs[cls]);
+    }
+}
+
+void ChatServer::shedPackets(Listener &listener, const PacketChain &packets) {
+    listener.stats.dropped.fetch_add(packets.size(), std::memory_order_relaxed);
+    replyBusy(packets);
+}
+
+void ChatServer::replyBusy(const PacketChain &packets) {
+    if (pool.policy() != OverflowPolicy::RejectBusy) return;
+
+    // 只给需要回复的请求发送 SERVER_BUSY，客户端按建议间隔重试
+    packets.forEach([this](const PacketBuffer &pkt) {
+        PacketHeader hdr;
+        decodeHeader(pkt.data(), pkt.length, hdr);
+        if (hdr.type == HEARTBEAT_REQ || hdr.type == FRAGMENT_ACK) return;
+        egress.push(pkt.addr, buildMessage(SERVER_BUSY, hdr.requestId, ServerBusy{hdr.type, BUSY_RETRY_AFTER_MS},
+                                           0, hdr.version));
+    });
 }
 
-void ChatServer::handlePacket(const sockaddr_in &addr, const std::vector<uint8_t> &data) {
-    PacketHeader hdr;
-    memcpy(&hdr, data.data(), sizeof(hdr));
-    std::vector<uint8_t> body(data.begin() + sizeof(hdr), data.end());
-    std::cout << "[RECV] Packet type: " << static_cast<int>(hdr.type)
-              << ", from: " << inet_ntoa(addr.sin_addr) << ":" << ntohs(addr.sin_port) << std::endl;
+void ChatServer::handlePackets(PacketChain &packets, std::chrono::steady_clock::time_point enqueued) {
+    auto waited = std::chrono::steady_clock::now() - enqueued;
+    while (PacketRef pkt = packets.pop()) handleQueued(std::move(pkt), waited);
+}
+
+void ChatServer::handleQueued(PacketRef &&packet, std::chrono::steady_clock::duration waited) {
+    // 排队超过该类请求的预算：请求方已放弃等待，直接丢弃，不再占用数据库
+    auto budget = queueBudget(packet->data()[PACKET_TYPE_OFFSET]);
+    if (budget.count() > 0 && waited > budget) {
+        staleRequests.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    handlePacket(std::move(packet));
+}
+
+void ChatServer::logStats() {
+    for (auto &l : listeners) {
+        uint64_t batches = l->stats.batches.load(std::memory_order_relaxed);
+        uint64_t packets = l->stats.packets.load(std::memory_order_relaxed);
+        double avgFill = batches ? static_cast<double>(packets) / batches : 0.0;
+        std::cout << "[STATS] Listener " << l->index << " (cpu " << l->cpu << ")"
+                  << " batches: " << batches << ", packets: " << packets
+                  << ", avg fill: " << avgFill << "/" << l->ring.batchSize()
+                  << ", dropped: " << l->stats.dropped.load(std::memory_order_relaxed)
+                  << ", malformed: " << l->stats.malformed.load(std::memory_order_relaxed) << std::endl;
+    }
+    if (!listeners.empty() && listeners[0]->uring) {
+        const UringStats &us = listeners[0]->uring->stats();
+        std::cout << "[STATS] io_uring enter calls: " << us.enterCalls.load(std::memory_order_relaxed)
+                  << ", sends: " << us.sendSubmitted.load(std::memory_order_relaxed)
+                  << " (zero-copy " << us.zeroCopySends.load(std::memory_order_relaxed) << ")"
+                  << ", send errors: " << us.sendErrors.load(std::memory_order_relaxed)
+                  << ", recv rearms: " << us.recvRearms.load(std::memory_order_relaxed) << std::endl;
+    }
+    const ThreadPoolStats &ts = pool.stats();
+    std::cout << "[STATS] Task queue workers: " << pool.workerCount() << ", depth: " << pool.depth()
+              << ", admitted: " << ts.admitted.load(std::memory_order_relaxed)
+              << ", max depth: " << ts.maxDepth.load(std::memory_order_relaxed) << "/"
+              << (pool.capacity() ? std::to_string(pool.capacity()) : std::string("unbounded"))
+              << ", dropped newest: " << ts.droppedNewest.load(std::memory_order_relaxed)
+              << ", dropped oldest: " << ts.droppedOldest.load(std::memory_order_relaxed)
+              << ", rejected busy: " << ts.rejectedBusy.load(std::memory_order_relaxed)
+              << ", preempted: " << ts.preempted.load(std::memory_order_relaxed)
+              << ", steals: " << ts.steals.load(std::memory_order_relaxed)
+              << ", parks: " << ts.parks.load(std::memory_order_relaxed)
+              << ", stale requests: " << staleRequests.load(std::memory_order_relaxed) << std::endl;
+    for (size_t cls = 0; cls < pool.classCount(); ++cls) {
+        const SchedClassStats &sc = pool.classStats(cls);
+        uint64_t executed = sc.executed.load(std::memory_order_relaxed);
+        std::cout << "[STATS] Class " << pool.className(cls) << " tasks: " << executed
+                  << ", avg queue delay: " << (executed ? sc.waitUs.load(std::memory_order_relaxed) / executed : 0)
+                  << " us, max: " << sc.maxWaitUs.load(std::memory_order_relaxed) << " us" << std::endl;
+    }
+    const StorageStats &ds = database.stats();
+    uint64_t ops = ds.submitted.load(std::memory_order_relaxed);
+    uint64_t txns = ds.transactions.load(std::memory_order_relaxed);
+    std::cout << "[STATS] Storage depth: " << database.depth()
+              << ", max depth: " << ds.maxDepth.load(std::memory_order_relaxed) << "/" << database.capacity()
+              << ", ops: " << ops << ", blocked: " << ds.blocked.load(std::memory_order_relaxed)
+              << ", transactions: " << txns
+              << ", avg batch: " << (txns ? static_cast<double>(ops) / txns : 0.0)
+              << ", max batch: " << ds.maxBatch.load(std::memory_order_relaxed) << "/" << database.maxBatch()
+              << ", failed commits: " << ds.failedCommits.load(std::memory_order_relaxed)
+              << ", retried ops: " << ds.retriedOps.load(std::memory_order_relaxed)
+              << ", failed ops: " << ds.failedOps.load(std::memory_order_relaxed)
+              << ", avg queue delay: " << (ops ? ds.waitUs.load(std::memory_order_relaxed) / ops : 0)
+              << " us, avg transaction: " << (txns ? ds.runUs.load(std::memory_order_relaxed) / txns : 0)
+              << " us" << std::endl;
+    const StageStats &ss = encoder.stats();
+    uint64_t tasks = ss.submitted.load(std::memory_order_relaxed);
+    std::cout << "[STATS] Stage " << encoder.name() << " threads: " << encoder.threadCount()
+              << ", depth: " << encoder.depth()
+              << ", max depth: " << ss.maxDepth.load(std::memory_order_relaxed) << "/" << encoder.capacity()
+              << ", tasks: " << tasks << ", blocked: " << ss.blocked.load(std::memory_order_relaxed)
+              << ", avg queue delay: " << (tasks ? ss.waitUs.load(std::memory_order_relaxed) / tasks : 0)
+              << " us, avg run: " << (tasks ? ss.runUs.load(std::memory_order_relaxed) / tasks : 0)
+              << " us" << std::endl;
+    uint64_t multis = multiRequests.load(std::memory_order_relaxed);
+    uint64_t subs = multiSubRequests.load(std::memory_order_relaxed);
+    if (lanes) {
+        const LaneStats &ls = lanes->stats();
+        std::cout << "[STATS] User lanes: " << lanes->laneCount()
+                  << ", requests: " << ls.submitted.load(std::memory_order_relaxed)
+                  << ", drains: " << ls.drains.load(std::memory_order_relaxed)
+                  << ", yields: " << ls.yields.load(std::memory_order_relaxed)
+                  << ", max depth: " << ls.maxDepth.load(std::memory_order_relaxed)
+                  << ", overflow: " << ls.overflow.load(std::memory_order_relaxed)
+                  << ", shed: " << ls.shed.load(std::memory_order_relaxed) << std::endl;
+    }
+    std::cout << "[STATS] Multi requests: " << multis << ", sub-requests: " << subs
+              << ", avg batch: " << (multis ? static_cast<double>(subs) / multis : 0.0) << std::endl;
+    uint64_t limited = limiter ? limiter->stats().limited.load(std::memory_order_relaxed) : 0;
+    uint64_t evictions = limiter ? limiter->stats().evictions.load(std::memory_order_relaxed) : 0;
+    std::cout << "[STATS] Rate limited: " << limited << ", bucket evictions: " << evictions << std::endl;
+    const ResponseCacheStats &cs = responseCache.stats();
+    const SingleFlightStats &sf = readFlight.stats();
+    uint64_t readCalls = sf.calls.load(std::memory_order_relaxed);
+    uint64_t readQueries = sf.executions.load(std::memory_order_relaxed);
+    std::cout << "[STATS] Response cache hits: " << cs.hits.load(std::memory_order_relaxed)
+              << ", misses: " << cs.misses.load(std::memory_order_relaxed)
+              << ", invalidations: " << cs.invalidations.load(std::memory_order_relaxed)
+              << ", stale fills: " << cs.staleFills.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "[STATS] Read queries requested: " << readCalls << ", executed: " << readQueries
+              << ", coalescing ratio: " << (readCalls ? 1.0 - static_cast<double>(readQueries) / readCalls : 0.0)
+              << std::endl;
+    uint64_t packed = compressionStats.compressed.load(std::memory_order_relaxed);
+    uint64_t stored = compressionStats.stored.load(std::memory_order_relaxed);
+    uint64_t rawBytes = compressionStats.rawBytes.load(std::memory_order_relaxed);
+    std::cout << "[STATS] Compressed payloads: " << packed << ", stored: " << stored
+              << ", ratio: " << (rawBytes ? static_cast<double>(compressionStats.wireBytes.load(std::memory_order_relaxed)) / rawBytes : 1.0)
+              << ", avg cpu: " << (packed + stored ? compressionStats.nanos.load(std::memory_order_relaxed) / (packed + stored) : 0)
+              << " ns" << std::endl;
+    const BufferPoolStats &ps = bufferPool.stats();
+    std::cout << "[STATS] Buffer pool slabs: " << ps.slabs.load(std::memory_order_relaxed)
+              << " (huge pages " << ps.hugePageSlabs.load(std::memory_order_relaxed) << ")"
+              << ", exhausted: " << ps.exhausted.load(std::memory_order_relaxed) << std::endl;
+    size_t tracked;
+    {
+        std::lock_guard<std::mutex> lock(presenceMutex);
+        tracked = presence.size();
+    }
+    std::cout << "[STATS] Online sessions: " << sessions.size() << ", presence timers: " << tracked
+              << ", heartbeat expired: " << expiredSessions.load(std::memory_order_relaxed) << std::endl;
+    const FragmentStats &fs = fragments.stats();
+    std::cout << "[STATS] Fragmented responses: " << fs.transfers.load(std::memory_order_relaxed)
+              << ", fragments: " << fs.fragments.load(std::memory_order_relaxed)
+              << ", retransmits: " << fs.retransmits.load(std::memory_order_relaxed)
+              << ", completed: " << fs.completed.load(std::memory_order_relaxed)
+              << ", failed: " << fs.failed.load(std::memory_order_relaxed)
+              << ", oversized: " << fs.oversized.load(std::memory_order_relaxed) << std::endl;
+    const EgressStats &es = egress.stats();
+    uint64_t sent = es.datagrams.load(std::memory_order_relaxed);
+    uint64_t calls = es.syscalls.load(std::memory_order_relaxed);
+    std::cout << "[STATS] Egress datagrams: " << sent << ", sendmmsg calls: " << calls
+              << ", avg batch: " << (calls ? static_cast<double>(sent) / calls : 0.0)
+              << ", errors: " << es.errors.load(std::memory_order_relaxed)
+              << ", stalls: " << es.stalls.load(std::memory_order_relaxed) << std::endl;
+}
+
+void ChatServer::handlePacket(PacketRef &&packet) {
+    Request req;
+    req.addr = packet->addr;
+    decodeHeader(packet->data(), packet->length, req.header);  // 已在 dispatch 中校验
+    req.body = packet.view().sub(PACKET_HEADER_SIZE);
+    req.key = requestKey(*packet.get(), req.header);
+    req.packet = std::move(packet);
+    std::cout << "[RECV] Packet type: " << static_cast<int>(req.header.type)
+              << ", from: " << inet_ntoa(req.addr.sin_addr) << ":" << ntohs(req.addr.sin_port) << std::endl;
+    handleRequest(req);
+}
+
+void ChatServer::handleRequest(const Request &req) {
+    const PacketHeader &hdr = req.header;
     switch (hdr.type) {
-        case REGISTER_REQ:               handleRegister(addr, body);                break;
-        case LOGIN_REQ:                  handleLogin(addr, body);                   break;
-        case LOGOUT_REQ:                 handleLogout(addr, body);                  break;
-        case DELETE_USER_REQ:            handleDeleteUser(addr, body);              break;
-        case CREATE_GROUP_REQ:           handleCreateGroup(addr, body);             break;  // 创建群组请求
-        case JOIN_GROUP_REQ:             handleJoinGroup(addr, body);               break;  // 加入群组请求
-        case PRIVATE_MSG_REQ:            handlePrivateMessage(addr, body);          break;
-        case FRIEND_REQUEST_REQ:         handleFriendRequest(addr, body);           break;
-        case FRIEND_REQUEST_LIST_REQ:    handleFriendRequestList(addr, body);       break;
-        case FRIEND_REQUEST_ACTION_REQ:  handleFriendRequestAction(addr, body);     break;
-        case DELETE_FRIEND_REQ:          handleDeleteFriend(addr, body);            break;
-        case FRIEND_LIST_REQ:            handleFriendList(addr, body);              break;
-        case BLOCK_USER_REQ:             handleBlockUser(addr, body);               break;
-        case UNBLOCK_USER_REQ:           handleUnblockUser(addr, body);             break;
-        case UPDATE_USER_REQ:            handleUpdateUser(addr, body);              break;
-        case CHAT_HISTORY_REQ:           handleChatHistory(addr, body);             break;
+        case REGISTER_REQ:               handleRegister(req);                       break;
+        case LOGIN_REQ:                  handleLogin(req);                          break;
+        case LOGOUT_REQ:                 handleLogout(req);                         break;
+        case DELETE_USER_REQ:            handleDeleteUser(req);                     break;
+        case CREATE_GROUP_REQ:           handleCreateGroup(req);                    break;  // 创建群组请求
+        case JOIN_GROUP_REQ:             handleJoinGroup(req);                      break;  // 加入群组请求
+        case PRIVATE_MSG_REQ:            handlePrivateMessage(req);                 break;
+        case FRIEND_REQUEST_REQ:         handleFriendRequest(req);                  break;
+        case FRIEND_REQUEST_LIST_REQ:    handleFriendRequestList(req);              break;
+        case FRIEND_REQUEST_ACTION_REQ:  handleFriendRequestAction(req);            break;
+        case DELETE_FRIEND_REQ:          handleDeleteFriend(req);                   break;
+        case FRIEND_LIST_REQ:            handleFriendList(req);                     break;
+        case BLOCK_USER_REQ:             handleBlockUser(req);                      break;
+        case UNBLOCK_USER_REQ:           handleUnblockUser(req);                    break;
+        case UPDATE_USER_REQ:            handleUpdateUser(req);                     break;
+        case CHAT_HISTORY_REQ:           handleChatHistory(req);                    break;
+        case CHAT_HISTORY_PAGE_REQ:      handleChatHistoryPage(req);                break;
+        case HEARTBEAT_REQ:              handleHeartbeat(req);                      break;
+        case FRAGMENT_ACK:               fragments.onAck(req.addr, req.body);       break;
+        case MULTI_REQ:                  handleMulti(req);                          break;
         default:
             std::cerr << "[WARN] Unknown packet type: " << static_cast<int>(hdr.type) << std::endl;
             break;
     }
 }
+void ChatServer::toStorage(const Request &req, AsyncDatabase::Op op) {
+    if (req.storeBatch) req.storeBatch->push_back(std::move(op));
+    else database.post(std::move(op));
+}
 
+void ChatServer::toEncoder(const Request &req, Stage::Job job) {
+    encoder.submit(req.key, std::move(job));
+}
 
-void ChatServer::handleRegister(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    const char *p = reinterpret_cast<const char*>(body.data());
-    bool ok = db.registerUser(p, p + strlen(p) + 1);
-    sendSimpleResponseWithLog(sockfd, addr, REGISTER_RESP, ok, "Register");
+template <typename Store, typename Respond>
+void ChatServer::pipeline(const Request &req, Store store, Respond respond) {
+    pipeline(req, std::move(store), [](auto &) {}, std::move(respond));
 }
 
-void ChatServer::handleLogin(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    const char *p = reinterpret_cast<const char*>(body.data());
-    int userId = -1;
-    bool ok = db.verifyUser(p, p + strlen(p) + 1, userId);
+template <typename Store, typename Apply, typename Respond>
+void ChatServer::pipeline(const Request &req, Store store, Apply apply, Respond respond) {
+    // 后续阶段持有请求的副本，负载中的视图引用的接收缓冲区随之保持有效
+    Request held = req;
+    held.storeBatch = nullptr;
+    toStorage(req, AsyncDatabase::makeOp(std::move(store),
+        [this, held = std::move(held), apply = std::move(apply), respond = std::move(respond)](auto &result) mutable {
+            apply(result);
+            toEncoder(held, [held, result = std::move(result), respond]() mutable {
+                respond(held, result);
+            });
+        }));
+}
 
-    std::cout << "[DEBUG] Login attempt by userId: " << userId << std::endl;
+void ChatServer::handleRegister(const Request &req) {
+    CredentialsReq msg;
+    if (!parseBody(req, msg)) return;
+    pipeline(req, [msg](DatabaseManager &db) {
+        return Status{db.registerUser(std::string(msg.username), std::string(msg.password)), "Register"};
+    }, statusReply(egress, REGISTER_RESP));
+}
 
-    if (ok) {
-        std::lock_guard<std::mutex> lk(clientsMutex);
-        if (onlineClients.count(userId)) {
-            ok = false;
-            std::cout << "[INFO] 用户 " << userId << " 已在线，无法重新登录" << std::endl;
-        } else {
-            onlineClients[userId] = ClientInfo{userId, addr};
-            std::cout << "[INFO] 用户 " << userId << " 成功登录" << std::endl;
+void ChatServer::handleLogin(const Request &req) {
+    CredentialsReq msg;
+    if (!parseBody(req, msg)) return;
+    // 客户端请求压缩且服务端启用时，记入会话并在 LOGIN_RESP 中回显
+    uint16_t features = options.compression ? req.header.flags & FLAG_ACCEPT_COMPRESSION : 0;
+    sockaddr_in addr = req.addr;
+
+    pipeline(req, [this, msg](DatabaseManager &db) {
+        LoginResult r{false, -1, {}};
+        r.ok = db.verifyUser(std::string(msg.username), std::string(msg.password), r.userId);
+        std::cout << "[DEBUG] Login attempt by userId: " << r.userId << std::endl;
+        if (!r.ok) return r;
+
+        sockaddr_in current;
+        if (sessions.lookup(r.userId, current)) {
+            r.ok = false;
+            std::cout << "[INFO] 用户 " << r.userId << " 已在线，无法重新登录" << std::endl;
+            return r;
         }
-    }
 
-    std::vector<uint8_t> payload(1 + sizeof(int));
-    payload[0] = ok;
-    int netUserId = htonl(userId);
-    memcpy(payload.data() + 1, &netUserId, sizeof(int));
-    sendPacket(sockfd, addr, LOGIN_RESP, payload);
-    std::cout << "[RESP] Login " << (ok ? "Success" : "Fail") << std::endl;
-
-    // === 主动推送离线消息 ===
-    if (ok) {
-        auto messages = db.loadOffline(userId, -1);
-        std::vector<uint8_t> payload;
-        payload.push_back(1); // 成功标志
-
-        for (const auto& msg : messages) {
-            int netSender = htonl(msg.sender);
-            uint32_t len = msg.content.size();
-            uint32_t netLen = htonl(len);
-            payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netSender), reinterpret_cast<uint8_t*>(&netSender) + sizeof(int));
-            payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netLen), reinterpret_cast<uint8_t*>(&netLen) + sizeof(uint32_t));
-            payload.insert(payload.end(), msg.content.begin(), msg.content.end());
-
-            db.markDelivered(msg.msgId);
+        // 离线消息在同一事务中取出并标记已投递，由编码阶段紧跟在 LOGIN_RESP 之后推送
+        r.offline = db.loadOffline(r.userId, -1);
+        for (const auto &m : r.offline) db.markDelivered(m.msgId);
+        return r;
+    }, [this, features, addr](LoginResult &r) {
+        // 事务提交后才登记会话：回滚的登录不会让用户留在在线列表中
+        if (!r.ok) return;
+        uint32_t now = presenceTick();
+        uint32_t epoch = 0;
+        if (!sessions.insert(r.userId, addr, now, &epoch, features)) {
+            // 会话只在存储线程上登记，到这里仍冲突只可能是同一事务中更早的一次登录，离线消息已由它取走
+            r.ok = false;
+            std::cout << "[INFO] 用户 " << r.userId << " 已在线，无法重新登录" << std::endl;
+            return;
         }
-
-        sendPacket(sockfd, addr, OFFLINE_MSG_LIST_RESP, payload);
-        std::cout << "[RESP] OfflineMsgList, count = " << messages.size() << std::endl;
-    }
+        {
+            std::lock_guard<std::mutex> lock(presenceMutex);
+            presence.schedule({r.userId, epoch, uint64_t(now) + HEARTBEAT_TIMEOUT_MS / HEARTBEAT_TICK_MS});
+        }
+        std::cout << "[INFO] 用户 " << r.userId << " 成功登录" << std::endl;
+    }, [this, features](const Request &req, const LoginResult &r) {
+        sendPacket(fragments, req.addr, req.header.requestId, req.header.version, LOGIN_RESP,
+                   encodeMessage(LoginResp{r.ok, r.userId}), r.ok ? features : 0);
+        std::cout << "[RESP] Login " << (r.ok ? "Success" : "Fail") << std::endl;
+        if (!r.ok) return;
+
+        // === 主动推送离线消息 ===
+        OfflineMsgListResp resp{true, {}};
+        resp.messages.reserve(r.offline.size());
+        for (const auto &m : r.offline) resp.messages.push_back({m.sender, m.content});
+
+        std::vector<uint8_t> payload = encodeMessage(resp);
+        uint16_t flags = 0;
+        if (features & FLAG_ACCEPT_COMPRESSION) {
+            payload = packPayload(payload.data(), payload.size(), COMPRESS_THRESHOLD, COMPRESS_LEVEL, &compressionStats);
+            flags = FLAG_COMPRESSED;
+        }
+        sendPacket(fragments, req.addr, req.header.requestId, req.header.version, OFFLINE_MSG_LIST_RESP,
+                   std::move(payload), flags);
+        std::cout << "[RESP] OfflineMsgList, count = " << r.offline.size() << std::endl;
+    });
 }
 
 
 
-void ChatServer::handleLogout(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId;
-    memcpy(&userId, body.data(), sizeof(userId));
+void ChatServer::handleLogout(const Request &req) {
+    UserReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId;
 
-    // 确保用户从在线用户列表中移除
-    {
-        std::lock_guard<std::mutex> lk(clientsMutex);
-        if (onlineClients.count(userId)) {
-            onlineClients.erase(userId);  // 清理在线状态
+    // 不访问数据库，但与登录一样在存储阶段按顺序下线：登录请求按来源分派、退出请求按用户分派，
+    // 两者可能在不同通道上并行解码，直接删除会话可能先于已排队的登录生效，使用户一直留在在线列表中
+    pipeline(req, [](DatabaseManager &) {
+        return Status{true, "Logout"};
+    }, [this, userId](const Status &) {
+        if (sessions.erase(userId)) {
             std::cout << "[INFO] 用户 " << userId << " 已成功退出登录" << std::endl;
         } else {
             std::cout << "[INFO] 用户 " << userId << " 不在在线状态" << std::endl;
         }
-    }
-
-    // 响应客户端，确认退出
-    sendSimpleResponseWithLog(sockfd, addr, LOGOUT_RESP, true, "Logout");
+    }, statusReply(egress, LOGOUT_RESP));
 }
 
 
-void ChatServer::handleUpdateUser(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId; memcpy(&userId, body.data(), sizeof(userId));
-    const char *p = reinterpret_cast<const char*>(body.data() + sizeof(userId));
-    bool ok = db.updateUser(userId, p, p + strlen(p) + 1);
-    sendSimpleResponseWithLog(sockfd, addr, UPDATE_USER_RESP, ok, "UpdateUser");
+void ChatServer::handleHeartbeat(const Request &req) {
+    UserReq msg;
+    if (!parseBody(req, msg)) return;
+    // 只接受登录地址发来的心跳；会话已超时下线的客户端须重新登录
+    sessions.touch(msg.userId, req.addr, presenceTick());
 }
 
-void ChatServer::handleDeleteUser(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId; memcpy(&userId, body.data(), sizeof(userId));
-    bool ok = db.deleteUser(userId);
-    sendSimpleResponseWithLog(sockfd, addr, DELETE_USER_RESP, ok, "DeleteUser");
-    if (ok) {
-        std::lock_guard<std::mutex> lk(clientsMutex);
-        onlineClients.erase(userId);
+uint32_t ChatServer::presenceTick() const {
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    return static_cast<uint32_t>(elapsed / std::chrono::milliseconds(HEARTBEAT_TICK_MS));
+}
+
+void ChatServer::expireIdleSessions() {
+    const uint32_t timeout = HEARTBEAT_TIMEOUT_MS / HEARTBEAT_TICK_MS;
+    uint32_t now = presenceTick();
+    std::vector<TimingWheel::Entry> due;
+    {
+        std::lock_guard<std::mutex> lock(presenceMutex);
+        presence.advance(now, [&due](const TimingWheel::Entry &e){ due.push_back(e); });
+    }
+    if (due.empty()) return;
+
+    std::vector<TimingWheel::Entry> renew;
+    for (const auto &e : due) {
+        uint32_t lastSeen = 0;
+        uint32_t idleBefore = now >= timeout ? now - timeout : 0;
+        switch (sessions.expireIfIdle(e.id, e.epoch, idleBefore, lastSeen)) {
+            case SessionTable::IdleCheck::Gone:
+                break;  // 已退出登录或已重新登录，新会话另有条目
+            case SessionTable::IdleCheck::Alive:
+                renew.push_back({e.id, e.epoch, uint64_t(lastSeen) + timeout});
+                break;
+            case SessionTable::IdleCheck::Expired:
+                expiredSessions.fetch_add(1, std::memory_order_relaxed);
+                std::cout << "[INFO] 用户 " << e.id << " 心跳超时，已下线" << std::endl;
+                break;
+        }
     }
+    if (renew.empty()) return;
+    std::lock_guard<std::mutex> lock(presenceMutex);
+    for (const auto &e : renew) presence.schedule(e);
+}
+
+void ChatServer::handleUpdateUser(const Request &req) {
+    UpdateUserReq msg;
+    if (!parseBody(req, msg)) return;
+    pipeline(req, [msg](DatabaseManager &db) {
+        return Status{db.updateUser(msg.userId, std::string(msg.newName), std::string(msg.newPassword)), "UpdateUser"};
+    }, statusReply(egress, UPDATE_USER_RESP));
+}
+
+void ChatServer::handleDeleteUser(const Request &req) {
+    UserReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId;
+    pipeline(req, [userId](DatabaseManager &db) {
+        return Status{db.deleteUser(userId), "DeleteUser"};
+    }, [this, userId](const Status &st) {
+        if (st.ok) sessions.erase(userId);
+    }, statusReply(egress, DELETE_USER_RESP));
 }
 
-void ChatServer::handleFriendRequest(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int u, f;
-    memcpy(&u, body.data(), sizeof(u));
-    memcpy(&f, body.data() + sizeof(u), sizeof(f));
+void ChatServer::handleFriendRequest(const Request &req) {
+    UserPairReq msg;
+    if (!parseBody(req, msg)) return;
+    int u = msg.userId, f = msg.targetId;
 
     std::cout << "[DEBUG] 收到好友请求: " << u << " -> " << f << std::endl;
 
     if (u == f) {
         std::cerr << "[ERROR] 用户尝试添加自己为好友" << std::endl;
-        sendSimpleResponseWithLog(sockfd, addr, FRIEND_REQUEST_RESP, false, "FriendRequest - 用户尝试添加自己");
+        toEncoder(req, [this, req] {
+            sendSimpleResponseWithLog(egress, req, FRIEND_REQUEST_RESP, false, "FriendRequest - 用户尝试添加自己");
+        });
         return;
     }
 
-    // 检查是否已经发送过好友请求（包括双向请求）
-    bool alreadyRequested = db.isFriendRequestExists(u, f) || db.isFriendRequestExists(f, u);
-    std::cout << "[DEBUG] 检查是否已经发送过好友请求" << std::endl;
-    if (alreadyRequested) {
-        std::cout << "[INFO] 用户 " << u << " 和用户 " << f << " 之间已经有待确认的好友请求" << std::endl;
-        sendSimpleResponseWithLog(sockfd, addr, FRIEND_REQUEST_RESP, false, "FriendRequest - 已有待确认请求");
-        return;
-    }
+    pipeline(req, [this, u, f](DatabaseManager &db) {
+        // 检查是否已经发送过好友请求（包括双向请求）
+        bool alreadyRequested = db.isFriendRequestExists(u, f) || db.isFriendRequestExists(f, u);
+        std::cout << "[DEBUG] 检查是否已经发送过好友请求" << std::endl;
+        if (alreadyRequested) {
+            std::cout << "[INFO] 用户 " << u << " 和用户 " << f << " 之间已经有待确认的好友请求" << std::endl;
+            return Status{false, "FriendRequest - 已有待确认请求"};
+        }
 
-    // 如果没有重复请求，则继续发送好友请求
-    bool ok = db.sendFriendRequest(u, f);
-    std::cout << "[DEBUG] 插入好友请求结果: " << ok << std::endl;
-    sendSimpleResponseWithLog(sockfd, addr, FRIEND_REQUEST_RESP, ok, "FriendRequest");
+        // 如果没有重复请求，则继续发送好友请求
+        bool ok = db.sendFriendRequest(u, f);
+        std::cout << "[DEBUG] 插入好友请求结果: " << ok << std::endl;
+        if (ok) invalidateRead({FRIEND_REQUEST_LIST_RESP, f, 0});
+        return Status{ok, "FriendRequest"};
+    }, statusReply(egress, FRIEND_REQUEST_RESP));
 }
 
 
-void ChatServer::handleFriendRequestAction(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int requestId;
-    memcpy(&requestId, body.data(), sizeof(requestId));
-    bool accept = body[sizeof(requestId)] != 0;
+void ChatServer::handleFriendRequestAction(const Request &req) {
+    FriendRequestActionReq msg;
+    if (!parseBody(req, msg)) return;
+    int requestId = msg.requestId;
+    bool accept = msg.accept;
 
     std::cout << "[DEBUG] handleFriendRequestAction called, id=" << requestId
               << ", accept=" << accept << std::endl;
 
-    bool ok = db.respondFriendRequest(requestId, accept);
+    pipeline(req, [this, requestId, accept](DatabaseManager &db) {
+        int from = -1, to = -1;
+        bool ok = db.respondFriendRequest(requestId, accept, &from, &to);
 
-    std::cout << "[DEBUG] respondFriendRequest returned: " << ok << std::endl;
+        std::cout << "[DEBUG] respondFriendRequest returned: " << ok << std::endl;
 
-    sendSimpleResponseWithLog(sockfd, addr, FRIEND_REQUEST_ACTION_RESP, ok, "FriendRequestAction");
+        // 接受时即使部分写入失败也可能已改动好友表，只要请求存在就一并失效
+        if (to >= 0) {
+            invalidateRead({FRIEND_REQUEST_LIST_RESP, to, 0});
+            if (accept) {
+                invalidateRead({FRIEND_LIST_RESP, from, 0});
+                invalidateRead({FRIEND_LIST_RESP, to, 0});
+            }
+        }
+        return Status{ok, "FriendRequestAction"};
+    }, statusReply(egress, FRIEND_REQUEST_ACTION_RESP));
 }
 
 
-void ChatServer::handleDeleteFriend(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId, friendId;
-    memcpy(&userId, body.data(), sizeof(userId));
-    memcpy(&friendId, body.data() + sizeof(userId), sizeof(friendId));
-    bool ok = db.deleteFriend(userId, friendId);
-    sendSimpleResponseWithLog(sockfd, addr, DELETE_FRIEND_RESP, ok, "DeleteFriend");
+void ChatServer::handleDeleteFriend(const Request &req) {
+    UserPairReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId, friendId = msg.targetId;
+    pipeline(req, [this, userId, friendId](DatabaseManager &db) {
+        bool ok = db.deleteFriend(userId, friendId);
+        if (ok) {
+            invalidateRead({FRIEND_LIST_RESP, userId, 0});
+            invalidateRead({FRIEND_LIST_RESP, friendId, 0});
+        }
+        return Status{ok, "DeleteFriend"};
+    }, statusReply(egress, DELETE_FRIEND_RESP));
 }
 
-void ChatServer::handleFriendList(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId;
-    memcpy(&userId, body.data(), sizeof(userId));
-
-    auto friends = db.getFriends(userId);
-
-    std::vector<uint8_t> payload;
-    payload.push_back(1);  // 成功标志
-
-    for (const auto &f : friends) {
-        // 将好友ID转换为网络字节序并插入到 payload
-        int netId = htonl(f.friendId);
-        payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netId), reinterpret_cast<uint8_t*>(&netId) + sizeof(int));
-
-        // 将 isBlocked 状态添加为 1 字节
-        payload.push_back(f.isBlocked ? 1 : 0);
-    }
-
-    // 发送响应包
-    sendPacket(sockfd, addr, FRIEND_LIST_RESP, payload);
-    std::cout << "[RESP] FriendList, count = " << friends.size() << std::endl;
+void ChatServer::handleFriendList(const Request &req) {
+    UserReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId;
+
+    uint8_t version = listVersion(req);
+    serveRead({FRIEND_LIST_RESP, userId, 0, 0, version}, req, [userId](DatabaseManager &db) {
+        return db.getFriends(userId);
+    }, [version](const std::vector<FriendRecord> &friends) {
+        FriendListResp resp{true, {}};
+        resp.friends.reserve(friends.size());
+        for (const auto &f : friends) resp.friends.push_back({f.friendId, f.isBlocked});
+        std::cout << "[RESP] FriendList, count = " << friends.size() << std::endl;
+        return version >= VERSION_COMPACT_LISTS ? encodeCompact(std::move(resp)) : encodeMessage(resp);
+    });
 }
 
-void ChatServer::handleFriendRequestList(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId; memcpy(&userId, body.data(), sizeof(userId));
-    auto requests = db.getFriendRequests(userId);
-
-    std::vector<uint8_t> payload;
-    payload.push_back(1);
-
-    for (auto &r : requests) {
-        int netReqId = htonl(r.requestId);
-        int netUserId = htonl(r.userId);
-        payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netReqId), reinterpret_cast<uint8_t*>(&netReqId) + sizeof(int));
-        payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netUserId), reinterpret_cast<uint8_t*>(&netUserId) + sizeof(int));
-    }
-
-    sendPacket(sockfd, addr, FRIEND_REQUEST_LIST_RESP, payload);
-    std::cout << "[RESP] FriendRequestList Success, count = " << requests.size() << std::endl;
+void ChatServer::handleFriendRequestList(const Request &req) {
+    UserReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId;
+    uint8_t version = listVersion(req);
+    serveRead({FRIEND_REQUEST_LIST_RESP, userId, 0, 0, version}, req, [userId](DatabaseManager &db) {
+        return db.getFriendRequests(userId);
+    }, [version](const std::vector<FriendRequestRecord> &requests) {
+        FriendRequestListResp resp{true, {}};
+        resp.requests.reserve(requests.size());
+        for (auto &r : requests) resp.requests.push_back({r.requestId, r.userId});
+        std::cout << "[RESP] FriendRequestList Success, count = " << requests.size() << std::endl;
+        return version >= VERSION_COMPACT_LISTS ? encodeCompact(std::move(resp)) : encodeMessage(resp);
+    });
 }
 
 
-void ChatServer::handleBlockUser(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId, targetId;
-    memcpy(&userId, body.data(), sizeof(userId));
-    memcpy(&targetId, body.data() + sizeof(userId), sizeof(targetId));
-    bool ok = db.blockFriend(userId, targetId);
-    sendSimpleResponseWithLog(sockfd, addr, BLOCK_USER_RESP, ok, "BlockUser");
+void ChatServer::handleBlockUser(const Request &req) {
+    UserPairReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId, targetId = msg.targetId;
+    pipeline(req, [this, userId, targetId](DatabaseManager &db) {
+        bool ok = db.blockFriend(userId, targetId);
+        if (ok) invalidateRead({FRIEND_LIST_RESP, userId, 0});
+        return Status{ok, "BlockUser"};
+    }, statusReply(egress, BLOCK_USER_RESP));
 }
 
-void ChatServer::handleUnblockUser(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId, targetId;
-    memcpy(&userId, body.data(), sizeof(userId));
-    memcpy(&targetId, body.data() + sizeof(userId), sizeof(targetId));
-    bool ok = db.unblockFriend(userId, targetId);
-    sendSimpleResponseWithLog(sockfd, addr, UNBLOCK_USER_RESP, ok, "UnblockUser");
+void ChatServer::handleUnblockUser(const Request &req) {
+    UserPairReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId, targetId = msg.targetId;
+    pipeline(req, [this, userId, targetId](DatabaseManager &db) {
+        bool ok = db.unblockFriend(userId, targetId);
+        if (ok) invalidateRead({FRIEND_LIST_RESP, userId, 0});
+        return Status{ok, "UnblockUser"};
+    }, statusReply(egress, UNBLOCK_USER_RESP));
 }
 
-void ChatServer::handleCreateGroup(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    const char *groupName = reinterpret_cast<const char*>(body.data());  // 提取群组名称
-    // 检查群组是否已存在
-    int groupId = db.getGroupIdByName(groupName);
-    if (groupId != -1) {
-        sendSimpleResponseWithLog(sockfd, addr, CREATE_GROUP_RESP, false, "Group already exists");
-        return;
-    }
-
-    bool ok = db.createGroup(groupName);  // 调用数据库函数创建群组
-
-    sendSimpleResponseWithLog(sockfd, addr, CREATE_GROUP_RESP, ok, ok ? "CreateGroup" : "CreateGroup - Error");
+void ChatServer::handleCreateGroup(const Request &req) {
+    CreateGroupReq msg;
+    if (!parseBody(req, msg)) return;
+    std::string groupName(msg.groupName);
+    pipeline(req, [groupName](DatabaseManager &db) {
+        // 检查群组是否已存在
+        int groupId = db.getGroupIdByName(groupName);
+        if (groupId != -1) return Status{false, "Group already exists"};
+
+        bool ok = db.createGroup(groupName);  // 调用数据库函数创建群组
+        return Status{ok, ok ? "CreateGroup" : "CreateGroup - Error"};
+    }, statusReply(egress, CREATE_GROUP_RESP));
 }
 
 
-void ChatServer::handleJoinGroup(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId;
-    memcpy(&userId, body.data(), sizeof(userId));  // 提取用户ID
-    std::string groupName(reinterpret_cast<const char*>(body.data() + sizeof(userId)));  // 提取群组名称
+void ChatServer::handleJoinGroup(const Request &req) {
+    JoinGroupReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId;
+    std::string groupName(msg.groupName);
 
-    // 检查用户是否已经是群组成员
-    int groupId = db.getGroupIdByName(groupName);
-    if (groupId == -1) {
-        sendSimpleResponseWithLog(sockfd, addr, JOIN_GROUP_RESP, false, "Group does not exist");
-        return;
-    }
-
-    bool isAlreadyMember = db.isUserInGroup(userId, groupId);  // 判断用户是否已是群组成员
-    if (isAlreadyMember) {
-        sendSimpleResponseWithLog(sockfd, addr, JOIN_GROUP_RESP, false, "Already a member of this group");
-        return;
-    }
+    pipeline(req, [userId, groupName](DatabaseManager &db) {
+        // 检查用户是否已经是群组成员
+        int groupId = db.getGroupIdByName(groupName);
+        if (groupId == -1) return Status{false, "Group does not exist"};
 
-    bool ok = db.addUserToGroup(userId, groupName);  // 调用数据库函数将用户加入群组
+        bool isAlreadyMember = db.isUserInGroup(userId, groupId);  // 判断用户是否已是群组成员
+        if (isAlreadyMember) return Status{false, "Already a member of this group"};
 
-    sendSimpleResponseWithLog(sockfd, addr, JOIN_GROUP_RESP, ok, ok ? "JoinGroup" : "JoinGroup - Error");
+        bool ok = db.addUserToGroup(userId, groupName);  // 调用数据库函数将用户加入群组
+        return Status{ok, ok ? "JoinGroup" : "JoinGroup - Error"};
+    }, statusReply(egress, JOIN_GROUP_RESP));
 }
 
 
-void ChatServer::sendGroupMessage(const sockaddr_in &addr, int groupId, const std::string &message) {
-    // 获取群组成员
-    std::vector<int> groupMembers = db.getGroupMembers(groupId);
+void ChatServer::handlePrivateMessage(const Request &req) {
+    PrivateMsgReq msg;
+    if (!parseBody(req, msg)) return;
+    int senderId = msg.senderId, receiverId = msg.receiverId;
+    // 消息内容是负载剩余部分，全程只引用接收缓冲区
+    ByteView message = req.body.sub(req.body.size() - msg.message.size());
 
-    for (int memberId : groupMembers) {
-        if (onlineClients.count(memberId)) {
-            // 发送消息给在线用户
-            sendPacket(sockfd, onlineClients[memberId].addr, GROUP_MSG, {message.begin(), message.end()});
-        } else {
-            // 存储离线消息，待用户上线后再发送
-            db.storeMessage(0, memberId, message);  // 0表示群组消息的发送者
+    std::cout << "[DEBUG] Handling private message from " << senderId << " to " << receiverId << std::endl;
+
+    pipeline(req, [this, senderId, receiverId, message](DatabaseManager &db) {
+        DeliveryResult r{false, false, {}};
+        // 检查用户是否为好友关系
+        auto friends = db.getFriends(senderId);
+        for (const auto& fr : friends) {
+            if (fr.friendId == receiverId && !fr.isBlocked) {
+                r.isFriend = true;
+                break;
+            }
         }
-    }
+        if (!r.isFriend) {
+            std::cerr << "[ERROR] Users are not friends or are blocked" << std::endl;
+            return r;
+        }
+
+        // 检查接收者是否在线，离线时存储离线消息
+        r.online = sessions.lookup(receiverId, r.receiverAddr);
+        if (!r.online) {
+            db.storeMessage(senderId, receiverId, message.str());  // senderId -> receiverId 的私聊消息
+            invalidateRead({CHAT_HISTORY_RESP, senderId, receiverId});
+            invalidateRead({CHAT_HISTORY_RESP, receiverId, senderId});
+        }
+        return r;
+    }, [this, senderId, message](const Request &req, const DeliveryResult &r) {
+        if (!r.isFriend) {
+            sendSimpleResponseWithLog(egress, req, PRIVATE_MSG_RESP, false, "Not friends or blocked");
+            return;
+        }
+        if (r.online) {
+            // 推送给在线的接收者：只新编码协议头与发送者，消息内容直接引用接收缓冲区
+            PrivateMsgPush push{senderId, {}};
+            std::vector<uint8_t> head(PACKET_HEADER_SIZE + wire::encodedSize(push));
+            WireWriter w(head.data() + PACKET_HEADER_SIZE);
+            wire::encode(w, push);
+            encodeHeader(PacketHeader{ PRIVATE_MSG_PUSH, 0, 0,
+                                       static_cast<uint32_t>(head.size() - PACKET_HEADER_SIZE + message.size()),
+                                       PROTOCOL_MIN_VERSION },
+                         head.data());
+            egress.push(OutDatagram{r.receiverAddr, std::move(head), req.packet, nullptr, message});
+        }
+        sendSimpleResponseWithLog(egress, req, PRIVATE_MSG_RESP, true, "PrivateMessage");
+    });
 }
 
-void ChatServer::handlePrivateMessage(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int senderId, receiverId;
-    memcpy(&senderId, body.data(), sizeof(senderId));
-    memcpy(&receiverId, body.data() + sizeof(senderId), sizeof(receiverId));
-    std::string message(reinterpret_cast<const char*>(body.data() + 2 * sizeof(int)));
+void ChatServer::handleChatHistory(const Request &req) {
+    ChatHistoryReq msg;
+    if (!parseBody(req, msg)) return;
+    int userId = msg.userId, peerId = msg.peerId;
+
+    serveRead({CHAT_HISTORY_RESP, userId, peerId}, req, [userId, peerId](DatabaseManager &db) {
+        return db.getChatHistory(userId, peerId, HISTORY_PAGE_DEFAULT);
+    }, [](const std::vector<MessageRecord> &history) {
+        ChatHistoryResp resp{true, {}};
+        resp.messages.reserve(history.size());
+        for (const auto& m : history) resp.messages.push_back({m.sender, m.content});
+        std::cout << "[RESP] ChatHistory, count = " << history.size() << std::endl;
+        return encodeMessage(resp);
+    });
+}
 
-    std::cout << "[DEBUG] Handling private message from " << senderId << " to " << receiverId << std::endl;
+void ChatServer::handleChatHistoryPage(const Request &req) {
+    ChatHistoryPageReq msg;
+    if (!parseBody(req, msg)) return;
+    int limit = msg.limit == 0 ? HISTORY_PAGE_DEFAULT : std::min<int>(msg.limit, HISTORY_PAGE_MAX);
+
+    // 多取一条判断之前是否还有记录
+    pipeline(req, [msg, limit](DatabaseManager &db) {
+        return db.getChatHistory(msg.userId, msg.peerId, limit + 1, msg.beforeMsgId);
+    }, [this, limit](const Request &req, std::vector<MessageRecord> &history) {
+        bool more = history.size() > static_cast<size_t>(limit);
+        if (more) history.pop_back();
+
+        // 记录攒到一个数据报的负载上限就发出一块，客户端收到第一块即可显示，不必等整页重组
+        ChatHistoryPageResp chunk{true, 0, false, false, {}};
+        const size_t emptySize = wire::encodedSize(chunk);
+        size_t size = emptySize;
+        auto flush = [&](bool last) {
+            chunk.last = last;
+            chunk.more = last && more;
+            sendPacket(fragments, req.addr, req.header.requestId, req.header.version, CHAT_HISTORY_PAGE_RESP,
+                       encodeMessage(chunk));
+            chunk.messages.clear();
+            ++chunk.seq;
+            size = emptySize;
+        };
+        for (const auto &m : history) {
+            HistoryEntry entry{m.msgId, m.sender, m.content};
+            size_t entrySize = wire::encodedSize(entry);
+            if (!chunk.messages.empty() && size + entrySize > FRAGMENT_THRESHOLD) flush(false);
+            chunk.messages.push_back(entry);
+            size += entrySize;
+        }
+        flush(true);
+        std::cout << "[RESP] ChatHistoryPage, count = " << history.size() << ", chunks = " << chunk.seq
+                  << (more ? ", more" : "") << std::endl;
+    });
+}
 
-    // 检查用户是否为好友关系
-    auto friends = db.getFriends(senderId);
-    bool isFriend = false;
-    for (const auto& fr : friends) {
-        if (fr.friendId == receiverId && !fr.isBlocked) {
-            isFriend = true;
-            break;
+template <typename Fetch, typename Encode>
+void ChatServer::serveRead(const ResponseCache::Key &key, const Request &req, Fetch fetch, Encode encode) {
+    MessageType type = static_cast<MessageType>(key.type);
+    // 缓存与合并的都只是负载，协议头（含各自的 requestId）在发送时为每个请求单独生成
+    sockaddr_in addr = req.addr;
+    uint32_t requestId = req.header.requestId;
+    uint8_t version = req.header.version;
+    std::shared_ptr<MultiReply> multi = req.multi;
+    uint16_t index = req.subIndex;
+    // 协商了压缩的会话读取压缩后的变体：缓存与合并按 flags 区分，压缩只在未命中时做一次
+    ResponseCache::Key variant = key;
+    if (compressible(type) && (sessions.features(key.userId, addr) & FLAG_ACCEPT_COMPRESSION))
+        variant.flags = FLAG_COMPRESSED;
+    uint16_t flags = variant.flags;
+    auto deliver = [this, multi, index, addr, requestId, version, type, flags](const Payload &payload) {
+        reply(fragments, multi, index, addr, requestId, version, type, payload, flags);
+    };
+    // 缓存查找也放在存储阶段按顺序进行：同一用户先前提交的写入已经生效并使缓存失效，之后的读取才能看到
+    Request held = req;
+    held.storeBatch = nullptr;
+    // 操作可能因合并的事务失败而重新执行（见 AsyncDatabase.h）：重新执行时沿用第一次的合并结果，不重复登记
+    toStorage(req, [this, held = std::move(held), variant, deliver, fetch = std::move(fetch), encode = std::move(encode),
+                    joined = false, flight = ReadFlight::Handle()](DatabaseManager &db) mutable -> AsyncDatabase::Commit {
+        if (!joined) {
+            if (Payload cached = responseCache.get(variant)) {
+                // 命中时负载已编码好，不访问数据库，直接交给编码阶段组帧发送
+                return [this, held, deliver, cached](bool) { toEncoder(held, [deliver, cached] { deliver(cached); }); };
+            }
+            joined = true;
+            flight = readFlight.join(variant, deliver);
         }
-    }
+        if (!flight) return nullptr;
+        // 票据须在查询前取得：查询期间发生的写入会使这次结果不被缓存
+        uint64_t ticket = responseCache.ticket(variant);
+        auto rows = fetch(db);
+        return [this, held, variant, ticket, flight, encode, rows = std::move(rows)](bool committed) {
+            toEncoder(held, [this, variant, ticket, flight, encode, rows, committed] {
+                std::vector<uint8_t> raw = encode(rows);
+                if (variant.flags & FLAG_COMPRESSED)
+                    raw = packPayload(raw.data(), raw.size(), COMPRESS_THRESHOLD, COMPRESS_LEVEL, &compressionStats);
+                auto payload = std::make_shared<const std::vector<uint8_t>>(std::move(raw));
+                // 单独执行的只读操作提交失败时读到的仍是已提交的数据，照常回复，只是不写入缓存
+                if (committed) responseCache.put(variant, ticket, payload);
+                readFlight.finish(variant, flight, Payload(payload));
+            });
+        };
+    });
+}
 
-    if (!isFriend) {
-        std::cerr << "[ERROR] Users are not friends or are blocked" << std::endl;
-        sendSimpleResponseWithLog(sockfd, addr, PRIVATE_MSG_RESP, false, "Not friends or blocked");
+void ChatServer::handleMulti(const Request &req) {
+    MultiReq msg;
+    if (!parseBody(req, msg)) return;
+    if (msg.requests.size() > MULTI_MAX_REQUESTS) {
+        std::cerr << "[WARN] MULTI_REQ 子请求过多: " << msg.requests.size() << std::endl;
         return;
     }
-
-    // 检查接收者是否在线
-    {
-        std::lock_guard<std::mutex> lk(clientsMutex);
-        if (onlineClients.count(receiverId)) {
-            // 如果在线，直接发送消息
-            sendPacket(sockfd, onlineClients[receiverId].addr, PRIVATE_MSG_RESP, {message.begin(), message.end()});
-        } else {
-            // 如果离线，存储离线消息
-            db.storeMessage(senderId, receiverId, message);  // senderId -> receiverId 的私聊消息
-        }
+    multiRequests.fetch_add(1, std::memory_order_relaxed);
+
+    // 子请求复用外层的地址、requestId、版本与接收缓冲区，只替换类型与负载；
+    // 合并中的查询可能在本函数返回后才完成，汇总对象由最后一个子响应释放并发出 MULTI_RESP
+    Request sub;
+    sub.addr = req.addr;
+    sub.packet = req.packet;
+    sub.key = req.key;
+    sub.multi = std::make_shared<MultiReply>(fragments, req.addr, req.header.requestId, req.header.version);
+    std::vector<AsyncDatabase::Op> stored;
+    sub.storeBatch = &stored;
+    for (size_t i = 0; i < msg.requests.size(); ++i) {
+        const SubRequest &r = msg.requests[i];
+        if (!batchable(r.type)) continue;
+        sub.header = PacketHeader{r.type, 0, req.header.requestId, static_cast<uint32_t>(r.body.size()),
+                                  req.header.version};
+        sub.body = ByteView{reinterpret_cast<const uint8_t*>(r.body.data()), r.body.size()};
+        sub.subIndex = static_cast<uint16_t>(i);
+        handleRequest(sub);
+        multiSubRequests.fetch_add(1, std::memory_order_relaxed);
     }
-
-    sendSimpleResponseWithLog(sockfd, addr, PRIVATE_MSG_RESP, true, "PrivateMessage");
+    if (stored.empty()) return;
+    // 各子请求的存储操作合并为一个操作，保证落在同一事务中；其回调在提交后才执行，之后才可能发出 MULTI_RESP
+    database.post([stored = std::move(stored)](DatabaseManager &db) mutable -> AsyncDatabase::Commit {
+        std::vector<AsyncDatabase::Commit> done;
+        for (auto &op : stored)
+            if (AsyncDatabase::Commit c = op(db)) done.push_back(std::move(c));
+        return [done = std::move(done)](bool committed) {
+            for (const auto &c : done) c(committed);
+        };
+    });
 }
 
-void ChatServer::handleChatHistory(const sockaddr_in &addr, const std::vector<uint8_t> &body) {
-    int userId, peerId;
-    memcpy(&userId, body.data(), sizeof(userId));
-    memcpy(&peerId, body.data() + sizeof(userId), sizeof(peerId));
-
-    auto history = db.getChatHistory(userId, peerId);  // 假设是双向查询
-
-    std::vector<uint8_t> payload;
-    payload.push_back(1); // 成功标志
-
-    for (const auto& msg : history) {
-        int netSender = htonl(msg.sender);
-        uint32_t len = msg.content.size();
-        uint32_t netLen = htonl(len);
-        payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netSender), reinterpret_cast<uint8_t*>(&netSender) + sizeof(int));
-        payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&netLen), reinterpret_cast<uint8_t*>(&netLen) + sizeof(uint32_t));
-        payload.insert(payload.end(), msg.content.begin(), msg.content.end());
+void ChatServer::invalidateRead(const ResponseCache::Key &key) {
+    ResponseCache::Key variant = key;
+    for (uint8_t version : {PROTOCOL_MIN_VERSION, VERSION_COMPACT_LISTS}) {
+        for (uint16_t flags : {uint16_t(0), FLAG_COMPRESSED}) {
+            variant.version = version;
+            variant.flags = flags;
+            responseCache.invalidate(variant);
+            readFlight.forget(variant);
+        }
     }
-
-    sendPacket(sockfd, addr, CHAT_HISTORY_RESP, payload);
-    std::cout << "[RESP] ChatHistory, count = " << history.size() << std::endl;
 }
 
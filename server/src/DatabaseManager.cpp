@@ -4,6 +4,7 @@
 #include <openssl/sha.h>
 #include <sstream>
 #include <iomanip>
+#include <cstdint>
 
 DatabaseManager::DatabaseManager(const std::string &dbFile)
     : db(nullptr) {
@@ -15,7 +16,7 @@ DatabaseManager::~DatabaseManager() {
 }
 
 bool DatabaseManager::init() {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     const char *sqls[] = {
         "CREATE TABLE IF NOT EXISTS Users(user_id INTEGER PRIMARY KEY, username TEXT UNIQUE, password TEXT);",
         "CREATE TABLE IF NOT EXISTS Friends(user_id INTEGER, friend_id INTEGER, is_blocked INTEGER, PRIMARY KEY(user_id,friend_id));",
@@ -28,6 +29,9 @@ bool DatabaseManager::init() {
         "PRIMARY KEY(group_id, user_id));",
 
         "CREATE TABLE IF NOT EXISTS FileTransfers(file_id INTEGER PRIMARY KEY AUTOINCREMENT, sender_id INTEGER, receiver_id INTEGER, file_name TEXT, file_data BLOB, status INTEGER);",  // 文件传输表
+
+        // 聊天记录分页：每个方向的私聊消息按 msg_id 有序，游标之前的一页只需一次索引范围扫描
+        "CREATE INDEX IF NOT EXISTS idx_messages_private ON Messages(sender_id, receiver_id, msg_id) WHERE group_id IS NULL;",
         
         nullptr
     };
@@ -36,6 +40,20 @@ bool DatabaseManager::init() {
     return true;
 }
 
+DatabaseManager::Batch::Batch(DatabaseManager &db) : db(db), lock(db.mtx), inTransaction(db.execute("BEGIN;")) {}
+
+DatabaseManager::Batch::~Batch() {
+    commit();
+}
+
+bool DatabaseManager::Batch::commit() {
+    if (!inTransaction) return true;
+    inTransaction = false;
+    if (db.execute("COMMIT;")) return true;
+    db.execute("ROLLBACK;");
+    return false;
+}
+
 bool DatabaseManager::execute(const std::string &sql) {
     char *errmsg = nullptr;
     int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errmsg);
@@ -48,7 +66,7 @@ bool DatabaseManager::execute(const std::string &sql) {
 }
 
 bool DatabaseManager::registerUser(const std::string &u, const std::string &p) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     const std::string hashed = sha256(p);
     return executePrepared("INSERT INTO Users(username,password) VALUES(?,?);", {
         {u, SQLITE_TEXT}, {hashed, SQLITE_TEXT}
@@ -56,7 +74,7 @@ bool DatabaseManager::registerUser(const std::string &u, const std::string &p) {
 }
 
 bool DatabaseManager::verifyUser(const std::string &u, const std::string &p, int &userId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     std::string hashed = sha256(p);
     sqlite3_prepare_v2(db, "SELECT user_id FROM Users WHERE username=? AND password=?;", -1, &st, nullptr);
@@ -74,7 +92,7 @@ bool DatabaseManager::verifyUser(const std::string &u, const std::string &p, int
 
 
 bool DatabaseManager::updateUser(int id, const std::string &n, const std::string &pw) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     std::string hashed = sha256(pw);
     return executePrepared("UPDATE Users SET username=?,password=? WHERE user_id=?;", {
         {n, SQLITE_TEXT}, {hashed, SQLITE_TEXT}, {std::to_string(id), SQLITE_INTEGER}
@@ -82,14 +100,14 @@ bool DatabaseManager::updateUser(int id, const std::string &n, const std::string
 }
 
 bool DatabaseManager::deleteUser(int id) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("DELETE FROM Users WHERE user_id=?;", {
         {std::to_string(id), SQLITE_INTEGER}
     });
 }
 
 bool DatabaseManager::isFriendRequestExists(int u, int f) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *stmt = nullptr;
     
     // 检查是否已经发送过好友请求（status = 0 表示待确认），并且检查两个方向的请求
@@ -126,7 +144,7 @@ bool DatabaseManager::sendFriendRequest(int u, int f) {
 
 std::vector<FriendRequestRecord> DatabaseManager::getFriendRequests(int userId) {
     std::vector<FriendRequestRecord> list;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     sqlite3_prepare_v2(db, "SELECT request_id,user_id,friend_id,status FROM FriendRequests WHERE friend_id=? AND status=0;", -1, &st, nullptr);
     sqlite3_bind_int(st, 1, userId);
@@ -142,11 +160,11 @@ std::vector<FriendRequestRecord> DatabaseManager::getFriendRequests(int userId)
     return list;
 }
 
-bool DatabaseManager::respondFriendRequest(int requestId, bool accept) {
+bool DatabaseManager::respondFriendRequest(int requestId, bool accept, int *fromUser, int *toUser) {
     int u = -1, f = -1;
 
     {
-        std::lock_guard<std::mutex> l(mtx);
+        std::lock_guard<std::recursive_mutex> l(mtx);
         // 查原始数据
         sqlite3_stmt *q;
         sqlite3_prepare_v2(db, "SELECT user_id,friend_id FROM FriendRequests WHERE request_id=?;", -1, &q, nullptr);
@@ -156,6 +174,8 @@ bool DatabaseManager::respondFriendRequest(int requestId, bool accept) {
             f = sqlite3_column_int(q, 1);
         }
         sqlite3_finalize(q);
+        if (fromUser) *fromUser = u;
+        if (toUser) *toUser = f;
 
         if (u < 0 || f < 0) return false;
 
@@ -178,14 +198,14 @@ bool DatabaseManager::respondFriendRequest(int requestId, bool accept) {
 
 bool DatabaseManager::addFriend(int userId, int friendId) {
     std::cout << "[DEBUG] addFriend(" << userId << ", " << friendId << ")" << std::endl;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("INSERT OR IGNORE INTO Friends(user_id,friend_id,is_blocked) VALUES(?,?,0);", {
         {std::to_string(userId), SQLITE_INTEGER}, {std::to_string(friendId), SQLITE_INTEGER}
     });
 }
 
 bool DatabaseManager::deleteFriend(int userId, int friendId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared(
         "DELETE FROM Friends WHERE (user_id=? AND friend_id=?) OR (user_id=? AND friend_id=?);",
         {
@@ -198,14 +218,14 @@ bool DatabaseManager::deleteFriend(int userId, int friendId) {
 }
 
 bool DatabaseManager::blockFriend(int userId, int friendId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("UPDATE Friends SET is_blocked=1 WHERE user_id=? AND friend_id=?;", {
         {std::to_string(userId), SQLITE_INTEGER}, {std::to_string(friendId), SQLITE_INTEGER}
     });
 }
 
 bool DatabaseManager::unblockFriend(int userId, int friendId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("UPDATE Friends SET is_blocked=0 WHERE user_id=? AND friend_id=?;", {
         {std::to_string(userId), SQLITE_INTEGER}, {std::to_string(friendId), SQLITE_INTEGER}
     });
@@ -213,7 +233,7 @@ bool DatabaseManager::unblockFriend(int userId, int friendId) {
 
 std::vector<FriendRecord> DatabaseManager::getFriends(int userId) {
     std::vector<FriendRecord> list;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     sqlite3_prepare_v2(db, "SELECT friend_id,is_blocked FROM Friends WHERE user_id=?;", -1, &st, nullptr);
     sqlite3_bind_int(st,1,userId);
@@ -228,7 +248,7 @@ std::vector<FriendRecord> DatabaseManager::getFriends(int userId) {
 }
 
 bool DatabaseManager::getPendingFriendRequests(int userId, std::vector<std::pair<int, int>>& requests) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *stmt = nullptr;
 
     const char *sql = "SELECT request_id, user_id FROM FriendRequests WHERE friend_id = ? AND status = 0;";
@@ -247,7 +267,7 @@ bool DatabaseManager::getPendingFriendRequests(int userId, std::vector<std::pair
 
 std::vector<MessageRecord> DatabaseManager::loadOffline(int receiverId, int groupId) {
     std::vector<MessageRecord> msgs;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     
     if (groupId == -1) {
@@ -273,7 +293,7 @@ std::vector<MessageRecord> DatabaseManager::loadOffline(int receiverId, int grou
 }
 
 bool DatabaseManager::markDelivered(int msgId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("UPDATE Messages SET delivered=1 WHERE msg_id=?;", {
         {std::to_string(msgId), SQLITE_INTEGER}
     });
@@ -313,7 +333,7 @@ bool DatabaseManager::executePrepared(const std::string &sql, const std::vector<
 }
 
 bool DatabaseManager::storeFileTransfer(int senderId, int receiverId, const std::string &fileName, const std::vector<uint8_t>& fileData) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     return executePrepared("INSERT INTO FileTransfers(sender_id, receiver_id, file_name, file_data, status) VALUES(?, ?, ?, ?, 0);", {
         {std::to_string(senderId), SQLITE_INTEGER},
         {std::to_string(receiverId), SQLITE_INTEGER},
@@ -324,7 +344,7 @@ bool DatabaseManager::storeFileTransfer(int senderId, int receiverId, const std:
 
 std::vector<FileTransferRecord> DatabaseManager::getFileTransfers(int receiverId) {
     std::vector<FileTransferRecord> files;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *stmt = nullptr;
 
     const char *sql = "SELECT file_id, sender_id, receiver_id, file_name, file_data FROM FileTransfers WHERE receiver_id=? AND status=0;";
@@ -352,7 +372,7 @@ std::vector<FileTransferRecord> DatabaseManager::getFileTransfers(int receiverId
 
 // 创建群组
 bool DatabaseManager::createGroup(const std::string &groupName) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     int groupId = getGroupIdByName(groupName);
     if (groupId != -1) {
         std::cerr << "[ERROR] 群组 " << groupName << " 已经存在！" << std::endl;
@@ -365,7 +385,7 @@ bool DatabaseManager::createGroup(const std::string &groupName) {
 
 // 获取群组ID
 int DatabaseManager::getGroupIdByName(const std::string &groupName) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     sqlite3_prepare_v2(db, "SELECT group_id FROM Groups WHERE group_name=?;", -1, &st, nullptr);
     sqlite3_bind_text(st, 1, groupName.c_str(), -1, SQLITE_TRANSIENT);
@@ -378,7 +398,7 @@ int DatabaseManager::getGroupIdByName(const std::string &groupName) {
 }
 // 加入群组
 bool DatabaseManager::addUserToGroup(int userId, const std::string &groupName) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     int groupId = getGroupIdByName(groupName);
     if (groupId == -1) {
         std::cerr << "[ERROR] 群组 " << groupName << " 不存在" << std::endl;
@@ -391,7 +411,7 @@ bool DatabaseManager::addUserToGroup(int userId, const std::string &groupName) {
 }
 
 bool DatabaseManager::isUserInGroup(int userId, int groupId) {
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *stmt = nullptr;
 
     const char *sql = "SELECT COUNT(*) FROM GroupMembers WHERE group_id = ? AND user_id = ?;";
@@ -413,7 +433,7 @@ bool DatabaseManager::isUserInGroup(int userId, int groupId) {
 
 std::vector<int> DatabaseManager::getGroupMembers(int groupId) {
     std::vector<int> members;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *stmt = nullptr;
 
     const char *sql = "SELECT user_id FROM GroupMembers WHERE group_id = ?;";
@@ -432,29 +452,30 @@ std::vector<int> DatabaseManager::getGroupMembers(int groupId) {
     return members;
 }
 
-bool DatabaseManager::storeMessage(int senderId, int receiverId, const std::string &content, int groupId) {
-    std::lock_guard<std::mutex> l(mtx);
-    if (groupId == -1) {
-        // 私聊消息
-        return executePrepared("INSERT INTO Messages(sender_id, receiver_id, content, delivered) VALUES(?, ?, ?, 0);", {
-            {std::to_string(senderId), SQLITE_INTEGER},
-            {std::to_string(receiverId), SQLITE_INTEGER},
-            {content, SQLITE_TEXT}
-        });
-    } else {
-        // 群组消息
-        return executePrepared("INSERT INTO Messages(sender_id, receiver_id, group_id, content, delivered) VALUES(?, ?, ?, ?, 0);", {
-            {std::to_string(senderId), SQLITE_INTEGER},
-            {std::to_string(receiverId), SQLITE_INTEGER},  // receiverId 可以是群组代表或创建者
-            {std::to_string(groupId), SQLITE_INTEGER},
-            {content, SQLITE_TEXT}
-        });
+bool DatabaseManager::storeMessage(int senderId, int receiverId, std::string_view content, int groupId) {
+    std::lock_guard<std::recursive_mutex> l(mtx);
+    // 消息内容直接绑定调用方的缓冲区（SQLITE_STATIC），sqlite3_step 完成前缓冲区保持有效，无需复制
+    const char *sql = groupId == -1
+        ? "INSERT INTO Messages(sender_id, receiver_id, content, delivered) VALUES(?, ?, ?, 0);"
+        : "INSERT INTO Messages(sender_id, receiver_id, group_id, content, delivered) VALUES(?, ?, ?, ?, 0);";
+    sqlite3_stmt *st;
+    if (sqlite3_prepare_v2(db, sql, -1, &st, nullptr) != SQLITE_OK) {
+        std::cerr << "[ERROR] Prepare failed: " << sqlite3_errmsg(db) << std::endl;
+        return false;
     }
+    int idx = 1;
+    sqlite3_bind_int(st, idx++, senderId);
+    sqlite3_bind_int(st, idx++, receiverId);  // 群组消息中 receiverId 为群成员
+    if (groupId != -1) sqlite3_bind_int(st, idx++, groupId);
+    sqlite3_bind_text(st, idx, content.data(), static_cast<int>(content.size()), SQLITE_STATIC);
+    int rc = sqlite3_step(st);
+    sqlite3_finalize(st);
+    return rc == SQLITE_DONE;
 }
 
 std::vector<MessageRecord> DatabaseManager::getGroupMessages(int groupId) {
     std::vector<MessageRecord> msgs;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     sqlite3_prepare_v2(db, "SELECT msg_id, sender_id, content FROM Messages WHERE group_id=?;", -1, &st, nullptr);
     sqlite3_bind_int(st, 1, groupId);
@@ -472,7 +493,7 @@ std::vector<MessageRecord> DatabaseManager::getGroupMessages(int groupId) {
 
 std::vector<MessageRecord> DatabaseManager::getPrivateMessages(int userId) {
     std::vector<MessageRecord> msgs;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
     sqlite3_prepare_v2(db, "SELECT msg_id, sender_id, receiver_id, content FROM Messages WHERE (sender_id=? OR receiver_id=?) AND delivered=0;", -1, &st, nullptr);
     sqlite3_bind_int(st, 1, userId);
@@ -502,28 +523,39 @@ void DatabaseManager::sendGroupMessage(int senderId, const std::string &content,
     }
 }
 
-std::vector<MessageRecord> DatabaseManager::getChatHistory(int userId, int friendId, int limit) {
+std::vector<MessageRecord> DatabaseManager::getChatHistory(int userId, int friendId, int limit, int beforeMsgId) {
     std::vector<MessageRecord> msgs;
-    std::lock_guard<std::mutex> l(mtx);
+    std::lock_guard<std::recursive_mutex> l(mtx);
     sqlite3_stmt *st;
 
+    // 两个方向分别在 idx_messages_private 上从游标倒序取至多 limit 条，再合并取前 limit 条：
+    // 每页的代价只与页大小有关，与历史总量和翻到第几页无关（OR 条件加 ORDER BY 会退化为全表扫描后排序）
     const char *sql =
-        "SELECT msg_id, sender_id, receiver_id, content, timestamp "
-        "FROM Messages "
-        "WHERE group_id IS NULL AND "
-        "((sender_id = ? AND receiver_id = ?) OR (sender_id = ? AND receiver_id = ?)) "
-        "ORDER BY timestamp DESC LIMIT ?;";
+        "SELECT msg_id, sender_id, receiver_id, content, timestamp FROM ("
+        "SELECT * FROM (SELECT msg_id, sender_id, receiver_id, content, timestamp FROM Messages "
+        "WHERE group_id IS NULL AND sender_id = ? AND receiver_id = ? AND msg_id < ? "
+        "ORDER BY msg_id DESC LIMIT ?) "
+        "UNION ALL "
+        "SELECT * FROM (SELECT msg_id, sender_id, receiver_id, content, timestamp FROM Messages "
+        "WHERE group_id IS NULL AND sender_id = ? AND receiver_id = ? AND msg_id < ? AND sender_id <> receiver_id "
+        "ORDER BY msg_id DESC LIMIT ?)"
+        ") ORDER BY msg_id DESC LIMIT ?;";
 
     if (sqlite3_prepare_v2(db, sql, -1, &st, nullptr) != SQLITE_OK) {
         std::cerr << "[ERROR] prepare getChatHistory: " << sqlite3_errmsg(db) << std::endl;
         return msgs;
     }
 
+    sqlite3_int64 before = beforeMsgId > 0 ? beforeMsgId : INT64_MAX;
     sqlite3_bind_int(st, 1, userId);
     sqlite3_bind_int(st, 2, friendId);
-    sqlite3_bind_int(st, 3, friendId);
-    sqlite3_bind_int(st, 4, userId);
-    sqlite3_bind_int(st, 5, limit);
+    sqlite3_bind_int64(st, 3, before);
+    sqlite3_bind_int(st, 4, limit);
+    sqlite3_bind_int(st, 5, friendId);
+    sqlite3_bind_int(st, 6, userId);
+    sqlite3_bind_int64(st, 7, before);
+    sqlite3_bind_int(st, 8, limit);
+    sqlite3_bind_int(st, 9, limit);
 
     while (sqlite3_step(st) == SQLITE_ROW) {
         MessageRecord rec;
@@ -0,0 +1,68 @@
+#include "Dispatch.h"
+#include "Config.h"
+#include "Protocol.h"
+#include "WireFormat.h"
+#include <array>
+
+namespace {
+constexpr uint64_t SOURCE_TAG = uint64_t(1) << 62;
+constexpr uint64_t USER_TAG = uint64_t(1) << 61;
+
+struct Entry {
+    uint8_t type;
+    OpcodeTraits traits;
+};
+
+// 退出登录、心跳与分片确认只改内存状态，开销小且丢弃后果重，不设排队预算
+// 查询类请求超过预算时客户端已超时，结果无人接收；修改类请求的预算更长
+// 退出登录按来源地址分派，与同一客户端先前的登录落在同一串行通道，保证在登录之后进入存储阶段
+const Entry ENTRIES[] = {
+    {PRIVATE_MSG_REQ,           {SCHED_INTERACTIVE, 1, QUEUE_BUDGET_UPDATE_MS, true}},
+    {HEARTBEAT_REQ,             {SCHED_INTERACTIVE, 1, 0, true}},
+    {LOGOUT_REQ,                {SCHED_INTERACTIVE, 1, 0, false}},
+    {FRAGMENT_ACK,              {SCHED_INTERACTIVE, 1, 0, false}},
+
+    {LOGIN_REQ,                 {SCHED_NORMAL, 4, QUEUE_BUDGET_UPDATE_MS, false}},
+    {UPDATE_USER_REQ,           {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {FRIEND_REQUEST_REQ,        {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {FRIEND_REQUEST_ACTION_REQ, {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, false}},
+    {DELETE_FRIEND_REQ,         {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {BLOCK_USER_REQ,            {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {UNBLOCK_USER_REQ,          {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {CREATE_GROUP_REQ,          {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, false}},
+    {JOIN_GROUP_REQ,            {SCHED_NORMAL, 2, QUEUE_BUDGET_UPDATE_MS, true}},
+    {FRIEND_LIST_REQ,           {SCHED_NORMAL, 2, QUEUE_BUDGET_QUERY_MS, true}},
+    {FRIEND_REQUEST_LIST_REQ,   {SCHED_NORMAL, 2, QUEUE_BUDGET_QUERY_MS, true}},
+
+    {REGISTER_REQ,              {SCHED_BULK, 8, QUEUE_BUDGET_UPDATE_MS, false}},
+    {DELETE_USER_REQ,           {SCHED_BULK, 8, QUEUE_BUDGET_UPDATE_MS, true}},
+    {CHAT_HISTORY_REQ,          {SCHED_BULK, 4, QUEUE_BUDGET_QUERY_MS, true}},
+    {CHAT_HISTORY_PAGE_REQ,     {SCHED_BULK, 4, QUEUE_BUDGET_QUERY_MS, true}},
+    {MULTI_REQ,                 {SCHED_BULK, 2, QUEUE_BUDGET_QUERY_MS, false}},  // 按子请求个数计，见 dispatch
+};
+
+std::array<OpcodeTraits, 256> buildTable() {
+    std::array<OpcodeTraits, 256> table;
+    table.fill({SCHED_NORMAL, 1, QUEUE_BUDGET_UPDATE_MS, false});
+    for (const auto &e : ENTRIES) table[e.type] = e.traits;
+    return table;
+}
+
+const std::array<OpcodeTraits, 256> TABLE = buildTable();
+}
+
+const OpcodeTraits &opcodeTraits(uint8_t type) {
+    return TABLE[type];
+}
+
+uint64_t requestKey(const PacketBuffer &pkt, const PacketHeader &hdr) {
+    uint64_t key;
+    if (opcodeTraits(hdr.type).userKeyed && hdr.length >= sizeof(int32_t))
+        key = USER_TAG | wire::load32(pkt.data() + PACKET_HEADER_SIZE);
+    else
+        key = SOURCE_TAG | static_cast<uint64_t>(pkt.addr.sin_addr.s_addr) << 16 | pkt.addr.sin_port;
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return key;
+}
@@ -0,0 +1,153 @@
+#include "EgressQueue.h"
+#include "Config.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+
+EgressQueue::EgressQueue(size_t batchSize, std::chrono::microseconds flushDeadline)
+    : sockfd(-1), batchSize(batchSize), flushDeadline(flushDeadline), stopping(false),
+      msgs(batchSize), iovs(batchSize * 2) {}
+
+EgressQueue::~EgressQueue() {
+    stop();
+}
+
+void EgressQueue::start(int fd) {
+    sockfd = fd;
+    writer = std::thread([this]{ writerLoop(); });
+}
+
+void EgressQueue::startExternal(int fd, std::function<void()> notify) {
+    sockfd = fd;
+    externalNotify = std::move(notify);
+}
+
+void EgressQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    if (writer.joinable()) writer.join();
+
+    // 外部排空模式下没有写线程，剩余数据报在此同步发出
+    if (sockfd >= 0) {
+        std::vector<OutDatagram> out;
+        drain(out);
+        flush(out);
+    }
+}
+
+void EgressQueue::push(const sockaddr_in &addr, std::vector<uint8_t> &&bytes) {
+    push(OutDatagram{addr, std::move(bytes), PacketRef(), nullptr, ByteView()});
+}
+
+void EgressQueue::push(OutDatagram &&datagram) {
+    bool wasEmpty, wake;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        wasEmpty = pending.empty();
+        if (wasEmpty) firstPending = std::chrono::steady_clock::now();
+        pending.push_back(std::move(datagram));
+        // 只在队列由空变非空或刚好攒满一批时唤醒写线程，避免每个包都触发 futex
+        wake = wasEmpty || pending.size() == batchSize;
+    }
+    if (wake) notifyWriter(wasEmpty);
+}
+
+void EgressQueue::push(std::vector<OutDatagram> &&datagrams) {
+    if (datagrams.empty()) return;
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        wasEmpty = pending.empty();
+        if (wasEmpty) firstPending = std::chrono::steady_clock::now();
+        for (auto &d : datagrams) pending.push_back(std::move(d));
+    }
+    notifyWriter(wasEmpty);
+}
+
+void EgressQueue::notifyWriter(bool becameNonEmpty) {
+    if (externalNotify) {
+        // 外部排空方每轮循环取走全部数据报，只需在队列由空变非空时唤醒
+        if (becameNonEmpty) externalNotify();
+    } else {
+        condition.notify_one();
+    }
+}
+
+void EgressQueue::drain(std::vector<OutDatagram> &out) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (out.empty()) out.swap(pending);
+    else {
+        for (auto &d : pending) out.push_back(std::move(d));
+        pending.clear();
+    }
+}
+
+void EgressQueue::writerLoop() {
+    std::vector<OutDatagram> out;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            condition.wait(lock, [this]{ return stopping || !pending.empty(); });
+            if (pending.empty()) return;  // stopping 且已发完
+            // 未攒满一批时等到截止时间，保证单个回复的额外延迟有上界
+            if (!stopping && pending.size() < batchSize) {
+                condition.wait_until(lock, firstPending + flushDeadline,
+                                     [this]{ return stopping || pending.size() >= batchSize; });
+            }
+            out.swap(pending);
+        }
+        flush(out);
+        out.clear();
+    }
+}
+
+void EgressQueue::flush(std::vector<OutDatagram> &out) {
+    for (size_t base = 0; base < out.size(); base += batchSize) {
+        size_t count = std::min(batchSize, out.size() - base);
+        for (size_t i = 0; i < count; ++i) {
+            OutDatagram &d = out[base + i];
+            msghdr &h = msgs[i].msg_hdr;
+            h = msghdr{};
+            h.msg_name = &d.addr;
+            h.msg_namelen = sizeof(d.addr);
+            h.msg_iov = &iovs[i * 2];
+            h.msg_iovlen = d.fillIov(h.msg_iov);
+        }
+
+        size_t sent = 0;
+        while (sent < count) {
+            int n = sendmmsg(sockfd, msgs.data() + sent, count - sent, 0);
+            egressStats.syscalls.fetch_add(1, std::memory_order_relaxed);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                // 套接字是非阻塞的：发送缓冲区满（EAGAIN）或网卡队列满（ENOBUFS）时等待后重发同一个数据报，
+                // 否则登录后的离线消息、分片窗口与群发等突发回复会被整批丢掉
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                    egressStats.stalls.fetch_add(1, std::memory_order_relaxed);
+                    waitWritable(errno == ENOBUFS);
+                    continue;
+                }
+                // 其余错误只与该数据报的目标或大小有关（EMSGSIZE、EHOSTUNREACH 等），跳过它继续发送其余部分
+                egressStats.errors.fetch_add(1, std::memory_order_relaxed);
+                ++sent;
+                continue;
+            }
+            sent += n;
+            egressStats.datagrams.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+}
+
+void EgressQueue::waitWritable(bool queueFull) {
+    // ENOBUFS 表示网卡发送队列满，POLLOUT 不反映这种状态，只能退避一段时间
+    if (queueFull) {
+        std::this_thread::sleep_for(std::chrono::microseconds(EGRESS_NOBUFS_BACKOFF_US));
+        return;
+    }
+    pollfd p{sockfd, POLLOUT, 0};
+    while (poll(&p, 1, EGRESS_POLL_TIMEOUT_MS) < 0 && errno == EINTR) {}
+}
@@ -0,0 +1,118 @@
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+EventLoop::EventLoop() : epfd(-1), wakeFd(-1), stopped(false) {}
+
+EventLoop::~EventLoop() {
+    for (auto &h : handlers)
+        if (h.second->owned) close(h.first);
+    if (epfd >= 0) close(epfd);
+}
+
+bool EventLoop::init() {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) { perror("epoll_create1"); return false; }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) { perror("eventfd"); return false; }
+    return addHandler(wakeFd, EPOLLIN, true, [this](uint32_t) {
+        uint64_t v;
+        while (read(wakeFd, &v, sizeof(v)) > 0) {}
+    });
+}
+
+bool EventLoop::addFd(int fd, uint32_t events, Callback cb) {
+    return addHandler(fd, events, false, std::move(cb));
+}
+
+bool EventLoop::addHandler(int fd, uint32_t events, bool owned, Callback cb) {
+    auto h = std::make_unique<Handler>(Handler{fd, owned, std::move(cb)});
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = h.get();
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl(ADD)");
+        return false;
+    }
+    handlers[fd] = std::move(h);
+    return true;
+}
+
+void EventLoop::removeFd(int fd) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    handlers.erase(fd);
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds interval, std::function<void()> cb) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) { perror("timerfd_create"); return -1; }
+    itimerspec spec{};
+    spec.it_interval.tv_sec = interval.count() / 1000;
+    spec.it_interval.tv_nsec = (interval.count() % 1000) * 1000000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(tfd, 0, &spec, nullptr) < 0) {
+        perror("timerfd_settime"); close(tfd); return -1;
+    }
+    bool ok = addHandler(tfd, EPOLLIN, true, [tfd, cb](uint32_t) {
+        uint64_t expirations;
+        if (read(tfd, &expirations, sizeof(expirations)) > 0) cb();
+    });
+    if (!ok) { close(tfd); return -1; }
+    return tfd;
+}
+
+bool EventLoop::watchSignals(std::initializer_list<int> signals, std::function<void(int)> cb) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int s : signals) sigaddset(&mask, s);
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0) { perror("signalfd"); return false; }
+    bool ok = addHandler(sfd, EPOLLIN, true, [sfd, cb](uint32_t) {
+        signalfd_siginfo info;
+        while (read(sfd, &info, sizeof(info)) == sizeof(info))
+            cb(static_cast<int>(info.ssi_signo));
+    });
+    if (!ok) close(sfd);
+    return ok;
+}
+
+void EventLoop::run() {
+    epoll_event events[64];
+    while (!stopped.load(std::memory_order_acquire)) {
+        int n = epoll_wait(epfd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            auto *h = static_cast<Handler*>(events[i].data.ptr);
+            h->cb(events[i].events);
+        }
+    }
+}
+
+void EventLoop::stop() {
+    stopped.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        perror("eventfd write");
+}
+
+bool blockSignals(std::initializer_list<int> signals) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int s : signals) sigaddset(&mask, s);
+    if (pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) {
+        std::cerr << "[ERROR] 屏蔽信号失败" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,135 @@
+#include "FragmentSender.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+bool sameEndpoint(const sockaddr_in &a, const sockaddr_in &b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+}
+
+FragmentSender::FragmentSender(EgressQueue &egress, size_t threshold, std::chrono::milliseconds rto,
+                               unsigned maxRetries, size_t maxTransfers)
+    : egress(egress), threshold(threshold), rto(rto), maxRetries(maxRetries),
+      maxTransfers(maxTransfers), nextId(1) {}
+
+OutDatagram FragmentSender::makeFragment(uint32_t id, const Transfer &t, uint16_t index) const {
+    size_t offset = static_cast<size_t>(index) * FRAGMENT_PAYLOAD_SIZE;
+    size_t len = std::min(FRAGMENT_PAYLOAD_SIZE, t.payload->size() - offset);
+
+    // 头部 = 协议头 + 分片头，数据部分直接引用共享的响应负载，重传时也不复制
+    std::vector<uint8_t> head(PACKET_HEADER_SIZE + FRAGMENT_HEADER_SIZE);
+    encodeHeader(PacketHeader{ FRAGMENT_DATA, t.flags, t.requestId, static_cast<uint32_t>(FRAGMENT_HEADER_SIZE + len),
+                               t.version },
+                 head.data());
+    FragmentHeader fh{ id, t.type, index, static_cast<uint16_t>(t.acked.size()),
+                       static_cast<uint32_t>(t.payload->size()) };
+    encodeFragmentHeader(fh, head.data() + PACKET_HEADER_SIZE);
+
+    return OutDatagram{t.addr, std::move(head), PacketRef(), t.payload,
+                       ByteView{t.payload->data() + offset, len}};
+}
+
+void FragmentSender::send(const sockaddr_in &addr, MessageType type, uint32_t requestId,
+                          std::vector<uint8_t> &&payload, uint16_t flags, uint8_t version) {
+    if (payload.size() > threshold) {
+        send(addr, type, requestId, std::make_shared<const std::vector<uint8_t>>(std::move(payload)), flags, version);
+        return;
+    }
+    egress.push(addr, buildPacket(type, requestId, payload, flags, version));
+}
+
+void FragmentSender::send(const sockaddr_in &addr, MessageType type, uint32_t requestId,
+                          std::shared_ptr<const std::vector<uint8_t>> payload, uint16_t flags,
+                          uint8_t version) {
+    size_t count = (payload->size() + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+    if (count > UINT16_MAX) {
+        // 分片数超出分片头的 16 位计数，整个报文也超出数据报上限，发出去只会被内核以 EMSGSIZE 拒绝
+        fragmentStats.oversized.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[WARN] 响应过大，无法分片发送，已丢弃: " << payload->size() << " 字节" << std::endl;
+        return;
+    }
+    if (payload->size() <= threshold) {
+        std::vector<uint8_t> head(PACKET_HEADER_SIZE);
+        encodeHeader(PacketHeader{ type, flags, requestId, static_cast<uint32_t>(payload->size()), version },
+                     head.data());
+        ByteView body{payload->data(), payload->size()};
+        egress.push(OutDatagram{addr, std::move(head), PacketRef(), std::move(payload), body});
+        return;
+    }
+
+    uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    Transfer t{addr, type, requestId, flags, version, std::move(payload), SackBitmap(count), std::chrono::steady_clock::now(), 0};
+
+    // 所有分片一次性入队，由发送队列批量发出
+    std::vector<OutDatagram> out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) out.push_back(makeFragment(id, t, static_cast<uint16_t>(i)));
+    fragmentStats.transfers.fetch_add(1, std::memory_order_relaxed);
+    fragmentStats.fragments.fetch_add(count, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(transfersMutex);
+        if (transfers.size() < maxTransfers) transfers.emplace(id, std::move(t));
+        else fragmentStats.failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    egress.push(std::move(out));
+}
+
+void FragmentSender::resendMissing(uint32_t id, const Transfer &t, std::vector<OutDatagram> &out) const {
+    size_t count = t.acked.size();
+    size_t base = t.acked.firstMissing();
+    size_t end = std::min(count, base + SACK_WINDOW);
+    for (size_t i = base; i < end; ++i)
+        if (!t.acked.test(i)) out.push_back(makeFragment(id, t, static_cast<uint16_t>(i)));
+    if (end < count && !t.acked.test(count - 1))
+        out.push_back(makeFragment(id, t, static_cast<uint16_t>(count - 1)));
+}
+
+void FragmentSender::onAck(const sockaddr_in &addr, ByteView body) {
+    FragmentAck ack;
+    if (!decodeFragmentAck(body.data(), body.size(), ack)) return;
+
+    std::vector<OutDatagram> out;
+    {
+        std::lock_guard<std::mutex> lock(transfersMutex);
+        auto it = transfers.find(ack.transferId);
+        if (it == transfers.end() || !sameEndpoint(it->second.addr, addr)) return;
+        Transfer &t = it->second;
+        t.acked.apply(ack);
+        if (t.acked.complete()) {
+            transfers.erase(it);
+            fragmentStats.completed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // 客户端只在发现缺口或等待超时时确认，收到即说明窗口内未置位的分片已丢失
+        t.lastActivity = std::chrono::steady_clock::now();
+        resendMissing(ack.transferId, t, out);
+    }
+    fragmentStats.retransmits.fetch_add(out.size(), std::memory_order_relaxed);
+    egress.push(std::move(out));
+}
+
+void FragmentSender::onTimer() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<OutDatagram> out;
+    {
+        std::lock_guard<std::mutex> lock(transfersMutex);
+        for (auto it = transfers.begin(); it != transfers.end();) {
+            Transfer &t = it->second;
+            if (now - t.lastActivity < rto) { ++it; continue; }
+            if (++t.retries > maxRetries) {
+                fragmentStats.failed.fetch_add(1, std::memory_order_relaxed);
+                it = transfers.erase(it);
+                continue;
+            }
+            t.lastActivity = now;
+            resendMissing(it->first, t, out);
+            ++it;
+        }
+    }
+    if (out.empty()) return;
+    fragmentStats.retransmits.fetch_add(out.size(), std::memory_order_relaxed);
+    egress.push(std::move(out));
+}
@@ -0,0 +1,92 @@
+#include "LaneExecutor.h"
+#include "Dispatch.h"
+
+namespace {
+size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+}
+
+LaneExecutor::LaneExecutor(ThreadPool &pool, size_t laneCount, size_t maxDepth, unsigned quantum, bool priority,
+                           Handler handler, ShedHandler onShed)
+    : pool(pool), mask(roundUpPow2(laneCount ? laneCount : 1) - 1), lanes(new Lane[mask + 1]),
+      maxDepth(maxDepth), quantum(quantum ? quantum : 1), priority(priority),
+      handler(std::move(handler)), onShed(std::move(onShed)) {}
+
+size_t LaneExecutor::classOf(const PacketBuffer &pkt) const {
+    return priority ? opcodeTraits(pkt.data()[PACKET_TYPE_OFFSET]).cls : 0;
+}
+
+bool LaneExecutor::submit(PacketRef &&packet, const PacketHeader &hdr, std::chrono::steady_clock::time_point now) {
+    Lane &lane = lanes[requestKey(*packet.get(), hdr) & mask];
+    packet->queuedAt = now;
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        if (maxDepth > 0 && lane.pending.size() >= maxDepth) {
+            laneStats.overflow.fetch_add(1, std::memory_order_relaxed);
+            first = false;
+        } else {
+            lane.pending.push(std::move(packet));
+            size_t depth = lane.pending.size();
+            if (depth > laneStats.maxDepth.load(std::memory_order_relaxed))
+                laneStats.maxDepth.store(depth, std::memory_order_relaxed);
+            first = !lane.scheduled;
+            lane.scheduled = true;
+        }
+    }
+    if (packet) {
+        PacketChain rejected;
+        rejected.push(std::move(packet));
+        onShed(rejected);
+        return false;
+    }
+    laneStats.submitted.fetch_add(1, std::memory_order_relaxed);
+    // scheduled 置位后只有本线程会提交排空任务，队首也只有排空任务会取走，这里读取队首无需持锁
+    if (first) schedule(lane, *lane.pending.front(), false);
+    return true;
+}
+
+void LaneExecutor::schedule(Lane &lane, const PacketBuffer &head, bool fromWorker) {
+    size_t cls = classOf(head);
+    uint32_t cost = opcodeTraits(head.data()[PACKET_TYPE_OFFSET]).cost;
+    laneStats.drains.fetch_add(1, std::memory_order_relaxed);
+    // 工作线程上重新入队时放入注入队列而非本线程的双端队列，排在其他通道之后，避免一个繁忙的用户独占工作线程；
+    // 被拒绝时线程池调用 Drain::shed 丢弃整个通道的积压
+    pool.enqueue(Task(Drain{this, &lane, static_cast<uint32_t>(cls)}), cls, cost, !fromWorker);
+}
+
+void LaneExecutor::drain(Lane &lane, size_t cls) {
+    for (unsigned n = 0;; ++n) {
+        PacketRef pkt;
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            const PacketBuffer *head = lane.pending.front();
+            if (!head) {
+                lane.scheduled = false;
+                return;
+            }
+            if (n < quantum && classOf(*head) == cls) pkt = lane.pending.pop();
+        }
+        if (!pkt) {
+            // 让出：scheduled 保持置位，期间新到的请求只追加到队尾，不会另外提交排空任务
+            laneStats.yields.fetch_add(1, std::memory_order_relaxed);
+            schedule(lane, *lane.pending.front(), true);
+            return;
+        }
+        handler(std::move(pkt));
+    }
+}
+
+void LaneExecutor::shedLane(Lane &lane) {
+    PacketChain dropped;
+    {
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        dropped = std::move(lane.pending);
+        lane.scheduled = false;
+    }
+    laneStats.shed.fetch_add(dropped.size(), std::memory_order_relaxed);
+    if (!dropped.empty()) onShed(dropped);
+}
@@ -0,0 +1,34 @@
+#include "Listener.h"
+#include <sys/socket.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cstdio>
+#include <iostream>
+
+int openListenerSocket(const sockaddr_in &addr, bool reusePort) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { perror("socket"); return -1; }
+    if (reusePort) {
+        int on = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+            perror("setsockopt(SO_REUSEPORT)"); close(fd); return -1;
+        }
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("bind"); close(fd); return -1;
+    }
+    return fd;
+}
+
+bool pinThreadToCpu(std::thread &t, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "[WARN] 绑定 CPU " << cpu << " 失败: " << rc << std::endl;
+        return false;
+    }
+    return true;
+}
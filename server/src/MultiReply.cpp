@@ -0,0 +1,28 @@
+#include "MultiReply.h"
+#include "Config.h"
+#include <algorithm>
+#include <iostream>
+
+MultiReply::MultiReply(FragmentSender &out, const sockaddr_in &addr, uint32_t requestId, uint8_t version)
+    : out(out), addr(addr), requestId(requestId), version(version) {}
+
+MultiReply::~MultiReply() {
+    // 子响应按完成顺序到达，缓存命中的可能早于需要查询的，发送前恢复请求中的顺序
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.index < b.index; });
+    MultiResp resp;
+    resp.responses.reserve(entries.size());
+    for (const auto &e : entries) {
+        resp.responses.push_back({e.index, e.type, e.flags,
+            std::string_view(reinterpret_cast<const char*>(e.payload->data()), e.payload->size())});
+    }
+#if ENABLE_SEND_LOG
+    std::cout << "[SEND] Type: " << static_cast<int>(MULTI_RESP) << ", Responses: " << entries.size() << std::endl;
+#endif
+    out.send(addr, MULTI_RESP, requestId, encodeMessage(resp), 0, version);
+}
+
+void MultiReply::add(uint16_t index, MessageType type, uint16_t flags, Payload payload) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back({index, type, flags, std::move(payload)});
+}
@@ -0,0 +1,80 @@
+#include "PacketBuffer.h"
+#include <sys/mman.h>
+#include <iostream>
+#include <new>
+
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+}
+
+BufferPool::BufferPool(size_t capacity, size_t buffersPerSlab, size_t maxSlabs, bool hugePages)
+    : bufCapacity(capacity),
+      stride(alignUp(sizeof(PacketBuffer) + capacity, alignof(PacketBuffer))),
+      buffersPerSlab(buffersPerSlab), maxSlabs(maxSlabs), hugePages(hugePages) {}
+
+BufferPool::~BufferPool() {
+    for (auto &s : slabs) munmap(s.first, s.second);
+}
+
+bool BufferPool::grow() {
+    if (maxSlabs && slabs.size() >= maxSlabs) return false;
+
+    size_t bytes = stride * buffersPerSlab;
+    void *mem = MAP_FAILED;
+    bool huge = false;
+    if (hugePages) {
+        // 大页需要按 2MB 取整，失败（如未预留大页）时退回普通页
+        size_t hugeBytes = alignUp(bytes, HUGE_PAGE_SIZE);
+        mem = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            bytes = hugeBytes;
+            huge = true;
+        }
+    }
+    if (mem == MAP_FAILED) {
+        mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("mmap(buffer slab)");
+            return false;
+        }
+    }
+    slabs.emplace_back(mem, bytes);
+    poolStats.slabs.fetch_add(1, std::memory_order_relaxed);
+    if (huge) poolStats.hugePageSlabs.fetch_add(1, std::memory_order_relaxed);
+
+    size_t count = bytes / stride;
+    auto *base = static_cast<uint8_t*>(mem);
+    freeList.reserve(freeList.size() + count);
+    for (size_t i = count; i-- > 0;) {
+        auto *buf = new (base + i * stride) PacketBuffer();
+        buf->pool = this;
+        freeList.push_back(buf);
+    }
+    return true;
+}
+
+PacketRef BufferPool::acquire() {
+    PacketBuffer *buf;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (freeList.empty() && !grow()) {
+            poolStats.exhausted.fetch_add(1, std::memory_order_relaxed);
+            return PacketRef();
+        }
+        buf = freeList.back();
+        freeList.pop_back();
+    }
+    buf->refs.store(1, std::memory_order_relaxed);
+    buf->offset = 0;
+    buf->length = 0;
+    buf->truncated = false;
+    return PacketRef(buf);
+}
+
+void BufferPool::recycle(PacketBuffer *buf) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    freeList.push_back(buf);
+}
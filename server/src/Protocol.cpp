@@ -1,4 +0,0 @@
-// Protocol.cpp
-// 本项目协议由 PacketHeader 和 MessageType 枚举直接解析，暂无额外逻辑
-
-#include "Protocol.h"
\ No newline at end of file
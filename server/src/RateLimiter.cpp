@@ -0,0 +1,134 @@
+#include "RateLimiter.h"
+#include "SessionTable.h"
+#include "WireFormat.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+constexpr uint64_t SOURCE_TAG = uint64_t(1) << 62;
+constexpr uint64_t USER_TAG = uint64_t(1) << 61;
+constexpr uint32_t MILLI = 1000;
+
+size_t roundUpPow2(size_t v, size_t min) {
+    size_t p = min;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+size_t hashKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+}
+
+RateLimiter::RateLimiter(size_t capacity, uint32_t sourceRate, uint32_t sourceBurst,
+                         uint32_t userRate, uint32_t userBurst, const SessionTable *sessions)
+    : entries(nullptr), shardMask(0), bytes(0), shards(new Shard[SHARD_COUNT]), sessions(sessions),
+      sourceRate(sourceRate), sourceBurst(sourceBurst), userRate(userRate), userBurst(userBurst) {
+    memset(costs, 1, sizeof(costs));
+    memset(userKeyed, 0, sizeof(userKeyed));
+    size_t n = roundUpPow2(capacity, SHARD_COUNT * PROBE_LIMIT);
+    // 匿名映射的页在首次写入时才分配且已清零，空表不占物理内存
+    void *mem = mmap(nullptr, n * sizeof(Entry), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap(rate limiter)");
+        return;  // entries 为空时不限速
+    }
+    entries = static_cast<Entry*>(mem);
+    shardMask = n / SHARD_COUNT - 1;
+    bytes = n * sizeof(Entry);
+}
+
+RateLimiter::~RateLimiter() {
+    if (entries) munmap(entries, bytes);
+}
+
+void RateLimiter::setCost(uint8_t type, uint8_t cost, bool keyed) {
+    costs[type] = cost;
+    userKeyed[type] = keyed;
+}
+
+size_t RateLimiter::shardOf(uint64_t key) const {
+    // 分片取哈希的高位，分片内的位置取低位，两者互不相关
+    return (hashKey(key) >> 58) & (SHARD_COUNT - 1);
+}
+
+RateLimiter::Entry *RateLimiter::find(uint64_t key, uint32_t burst, uint32_t nowMs, const Entry *keep) {
+    size_t h = hashKey(key);
+    Entry *base = entries + shardOf(key) * (shardMask + 1);
+    Entry *victim = nullptr;
+    for (size_t i = 0; i < PROBE_LIMIT; ++i) {
+        Entry *e = &base[(h + i) & shardMask];
+        if (e->key == key) return e;
+        if (e->key == 0) { victim = e; break; }
+        if (e == keep) continue;
+        if (!victim || nowMs - e->stamp > nowMs - victim->stamp) victim = e;
+    }
+    if (victim->key != 0) limitStats.evictions.fetch_add(1, std::memory_order_relaxed);
+    // 新来源从满桶开始；被淘汰的多为长时间未活跃、本就已补满的桶
+    *victim = Entry{key, nowMs, burst * MILLI};
+    return victim;
+}
+
+void RateLimiter::refill(Entry *e, uint32_t rate, uint32_t burst, uint32_t nowMs) {
+    uint64_t elapsed = nowMs - e->stamp;
+    // 每毫秒补充 rate / 1000 个令牌，即 rate 个千分之一令牌
+    uint64_t tokens = e->tokens + elapsed * rate;
+    e->tokens = static_cast<uint32_t>(std::min<uint64_t>(tokens, uint64_t(burst) * MILLI));
+    e->stamp = nowMs;
+}
+
+bool RateLimiter::sessionMatches(uint32_t userId, const sockaddr_in &src) const {
+    if (!sessions) return true;
+    sockaddr_in addr;
+    return sessions->lookup(static_cast<int>(userId), addr) && addr.sin_addr.s_addr == src.sin_addr.s_addr &&
+           addr.sin_port == src.sin_port;
+}
+
+bool RateLimiter::allow(const sockaddr_in &src, uint8_t type, const uint8_t *body, size_t len,
+                        uint32_t nowMs, uint32_t units) {
+    uint32_t cost = costs[type] * MILLI * units;
+    if (cost == 0 || !entries) return true;
+
+    // 来源只按 IP 计：端口由客户端任意选择，按四元组计时换个源端口就能绕过限速
+    uint64_t sourceKey = SOURCE_TAG | src.sin_addr.s_addr;
+    // 负载中的 userId 未经认证，只有来自该用户登录地址的请求才计入其桶
+    uint64_t userKey = 0;
+    if (userKeyed[type] && len >= sizeof(int32_t)) {
+        uint32_t userId = wire::load32(body);
+        if (sessionMatches(userId, src)) userKey = USER_TAG | userId;
+    }
+
+    // 两个桶可能在不同分片，std::lock 按无死锁的顺序同时加锁
+    size_t sourceShard = shardOf(sourceKey);
+    std::unique_lock<std::mutex> sourceLock(shards[sourceShard].mutex, std::defer_lock);
+    std::unique_lock<std::mutex> userLock;
+    if (userKey && shardOf(userKey) != sourceShard) {
+        userLock = std::unique_lock<std::mutex>(shards[shardOf(userKey)].mutex, std::defer_lock);
+        std::lock(sourceLock, userLock);
+    } else {
+        sourceLock.lock();
+    }
+
+    Entry *source = find(sourceKey, sourceBurst, nowMs);
+    refill(source, sourceRate, sourceBurst, nowMs);
+    Entry *user = nullptr;
+    if (userKey) {
+        user = find(userKey, userBurst, nowMs, source);
+        refill(user, userRate, userBurst, nowMs);
+    }
+
+    // 两个桶都足够时才扣除，避免被拒绝的请求白白消耗另一个桶
+    if (source->tokens < cost || (user && user->tokens < cost)) {
+        limitStats.limited.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    source->tokens -= cost;
+    if (user) user->tokens -= cost;
+    return true;
+}
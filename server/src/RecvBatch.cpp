@@ -0,0 +1,72 @@
+#include "RecvBatch.h"
+#include <cerrno>
+
+RecvRing::RecvRing(BufferPool &pool, size_t slots, size_t batchSize, size_t bufSize)
+    : pool(pool), batches(slots), batchSz(batchSize), bufSize(bufSize) {
+    for (auto &b : batches) {
+        b.packets.resize(batchSize);
+        b.msgs.resize(batchSize);
+        b.iovs.resize(batchSize);
+        freeList.push_back(&b);
+    }
+}
+
+RecvBatch *RecvRing::acquire() {
+    std::unique_lock<std::mutex> lock(freeMutex);
+    freeCond.wait(lock, [this]{ return !freeList.empty(); });
+    RecvBatch *b = freeList.back();
+    freeList.pop_back();
+    return b;
+}
+
+void RecvRing::release(RecvBatch *batch) {
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        freeList.push_back(batch);
+    }
+    freeCond.notify_one();
+}
+
+int RecvRing::receive(int fd, RecvBatch *batch) {
+    // 补齐被工作线程移走的缓冲区，并重置内核会改写的字段
+    size_t vlen = 0;
+    for (; vlen < batchSz; ++vlen) {
+        PacketRef &p = batch->packets[vlen];
+        if (!p && !(p = pool.acquire())) break;
+        batch->iovs[vlen].iov_base = p->raw();
+        batch->iovs[vlen].iov_len = bufSize;
+        msghdr &h = batch->msgs[vlen].msg_hdr;
+        h = msghdr{};
+        h.msg_name = &p->addr;
+        h.msg_namelen = sizeof(sockaddr_in);
+        h.msg_iov = &batch->iovs[vlen];
+        h.msg_iovlen = 1;
+        batch->msgs[vlen].msg_len = 0;
+    }
+    batch->count = 0;
+
+    int n;
+    if (vlen == 0) {
+        // 缓冲池耗尽：读出并丢弃一个数据报，避免水平触发的 epoll 空转
+        uint8_t scratch;
+        do {
+            n = static_cast<int>(recv(fd, &scratch, sizeof(scratch), 0));
+        } while (n < 0 && errno == EINTR);
+        return n < 0 ? -1 : 0;
+    }
+
+    do {
+        n = recvmmsg(fd, batch->msgs.data(), vlen, MSG_WAITFORONE, nullptr);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return n;
+
+    batch->count = static_cast<unsigned>(n);
+    for (int i = 0; i < n; ++i) {
+        PacketBuffer *p = batch->packets[i].get();
+        p->offset = 0;
+        p->length = batch->msgs[i].msg_len;
+        p->truncated = batch->msgs[i].msg_hdr.msg_flags & MSG_TRUNC;
+        p->raw()[p->length] = 0;  // 结尾补 NUL，字符串字段越界时 strlen 也停在报文末尾
+    }
+    return n;
+}
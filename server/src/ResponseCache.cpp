@@ -0,0 +1,63 @@
+#include "ResponseCache.h"
+
+size_t ResponseCache::KeyHash::operator()(const Key &k) const {
+    uint64_t v = static_cast<uint64_t>(static_cast<uint32_t>(k.userId)) << 32 | static_cast<uint32_t>(k.peerId);
+    v ^= (static_cast<uint64_t>(k.type) | static_cast<uint64_t>(k.flags) << 8 | static_cast<uint64_t>(k.version) << 24) *
+         0x9E3779B97F4A7C15ULL;
+    v ^= v >> 31;
+    v *= 0xBF58476D1CE4E5B9ULL;
+    v ^= v >> 29;
+    return static_cast<size_t>(v);
+}
+
+ResponseCache::ResponseCache(size_t maxEntries)
+    : maxPerShard(maxEntries / SHARD_COUNT + 1), shards(new Shard[SHARD_COUNT]) {}
+
+ResponseCache::Shard &ResponseCache::shardFor(const Key &key) {
+    // 同一用户的各类响应落在同一分片
+    return shards[static_cast<uint32_t>(key.userId) * 0x9E3779B1u >> 28 & (SHARD_COUNT - 1)];
+}
+
+size_t ResponseCache::versionSlot(const Key &key) {
+    // 同一查询的各个编码变体（flags、version）总是一起失效，共用一个槽位；
+    // 分片由 userId 决定，槽位取哈希的高位，使同一分片内不同用户与类型的 key 分散开
+    return KeyHash()(Key{key.type, key.userId, key.peerId}) >> 40 & (VERSION_SLOTS - 1);
+}
+
+ResponseCache::Payload ResponseCache::get(const Key &key) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.entries.find(key);
+    if (it == s.entries.end()) {
+        cacheStats.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    cacheStats.hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+}
+
+uint64_t ResponseCache::ticket(const Key &key) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.versions[versionSlot(key)];
+}
+
+void ResponseCache::put(const Key &key, uint64_t ticket, Payload payload) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.versions[versionSlot(key)] != ticket) {
+        cacheStats.staleFills.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // 分片已满时淘汰任意一项，只保证内存有上界
+    if (s.entries.size() >= maxPerShard && !s.entries.count(key)) s.entries.erase(s.entries.begin());
+    s.entries[key] = std::move(payload);
+}
+
+void ResponseCache::invalidate(const Key &key) {
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    ++s.versions[versionSlot(key)];
+    s.entries.erase(key);
+    cacheStats.invalidations.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,182 @@
+#include "SessionTable.h"
+#include <climits>
+
+namespace {
+constexpr int32_t EMPTY_KEY = INT32_MIN;
+constexpr uint64_t ONLINE_FLAG = uint64_t(1) << 63;
+
+uint64_t packAddr(const sockaddr_in &addr) {
+    return ONLINE_FLAG | static_cast<uint64_t>(addr.sin_addr.s_addr) << 16 | addr.sin_port;
+}
+
+void unpackAddr(uint64_t v, sockaddr_in &addr) {
+    addr = sockaddr_in{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = static_cast<uint32_t>(v >> 16);
+    addr.sin_port = static_cast<uint16_t>(v);
+}
+
+size_t roundUpPow2(size_t v) {
+    size_t p = 8;
+    while (p < v) p <<= 1;
+    return p;
+}
+}
+
+SessionTable::Table::Table(size_t capacity)
+    : mask(capacity - 1), used(0), slots(new Slot[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].key.store(EMPTY_KEY, std::memory_order_relaxed);
+        slots[i].value.store(0, std::memory_order_relaxed);
+        slots[i].lastSeen.store(0, std::memory_order_relaxed);
+        slots[i].epoch.store(0, std::memory_order_relaxed);
+        slots[i].features.store(0, std::memory_order_relaxed);
+    }
+}
+
+SessionTable::SessionTable(size_t initialCapacity)
+    : shards(new Shard[SHARD_COUNT]) {
+    size_t cap = roundUpPow2(initialCapacity);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        shards[i].generations.push_back(std::make_unique<Table>(cap));
+        shards[i].table.store(shards[i].generations.back().get(), std::memory_order_release);
+    }
+}
+
+SessionTable::~SessionTable() = default;
+
+size_t SessionTable::hash(int userId) {
+    return static_cast<size_t>(static_cast<uint32_t>(userId) * 0x9E3779B97F4A7C15ULL);
+}
+
+SessionTable::Shard &SessionTable::shardFor(int userId) const {
+    // 高位选分片，低位在分片内定位槽位
+    return shards[hash(userId) >> 58 & (SHARD_COUNT - 1)];
+}
+
+const SessionTable::Slot *SessionTable::find(const Table *t, int userId) {
+    size_t h = hash(userId);
+    for (size_t i = 0; i <= t->mask; ++i) {
+        const Slot &s = t->slots[(h + i) & t->mask];
+        int32_t k = s.key.load(std::memory_order_acquire);
+        if (k == userId) return &s;
+        if (k == EMPTY_KEY) return nullptr;
+    }
+    return nullptr;
+}
+
+SessionTable::Slot *SessionTable::findOrClaim(Shard &shard, int userId) {
+    Table *t = shard.table.load(std::memory_order_relaxed);
+    if (const Slot *s = find(t, userId)) return const_cast<Slot*>(s);
+
+    // 负载因子超过 0.7 时扩容：只搬迁在线的会话，顺带清理退出登录留下的 key
+    if ((t->used + 1) * 10 > (t->mask + 1) * 7) {
+        auto bigger = std::make_unique<Table>((t->mask + 1) * 2);
+        for (size_t i = 0; i <= t->mask; ++i) {
+            int32_t k = t->slots[i].key.load(std::memory_order_relaxed);
+            uint64_t v = t->slots[i].value.load(std::memory_order_relaxed);
+            if (k == EMPTY_KEY || v == 0) continue;
+            size_t h = hash(k);
+            for (size_t j = 0;; ++j) {
+                Slot &dst = bigger->slots[(h + j) & bigger->mask];
+                if (dst.key.load(std::memory_order_relaxed) != EMPTY_KEY) continue;
+                dst.value.store(v, std::memory_order_relaxed);
+                dst.lastSeen.store(t->slots[i].lastSeen.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                dst.epoch.store(t->slots[i].epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                dst.features.store(t->slots[i].features.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                dst.key.store(k, std::memory_order_relaxed);
+                ++bigger->used;
+                break;
+            }
+        }
+        t = bigger.get();
+        shard.generations.push_back(std::move(bigger));
+        shard.table.store(t, std::memory_order_release);
+    }
+
+    size_t h = hash(userId);
+    for (size_t i = 0;; ++i) {
+        Slot &s = t->slots[(h + i) & t->mask];
+        if (s.key.load(std::memory_order_relaxed) != EMPTY_KEY) continue;
+        s.key.store(userId, std::memory_order_release);
+        ++t->used;
+        return &s;
+    }
+}
+
+bool SessionTable::insert(int userId, const sockaddr_in &addr, uint32_t now, uint32_t *epoch,
+                          uint16_t features) {
+    if (userId == EMPTY_KEY) return false;
+    Shard &shard = shardFor(userId);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    Slot *s = findOrClaim(shard, userId);
+    if (s->value.load(std::memory_order_relaxed) != 0) return false;
+    uint32_t e = s->epoch.load(std::memory_order_relaxed) + 1;
+    s->epoch.store(e, std::memory_order_relaxed);
+    s->lastSeen.store(now, std::memory_order_relaxed);
+    s->features.store(features, std::memory_order_relaxed);
+    s->value.store(packAddr(addr), std::memory_order_release);
+    if (epoch) *epoch = e;
+    online.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool SessionTable::erase(int userId) {
+    if (userId == EMPTY_KEY) return false;
+    Shard &shard = shardFor(userId);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    Slot *s = const_cast<Slot*>(find(shard.table.load(std::memory_order_relaxed), userId));
+    if (!s || s->value.load(std::memory_order_relaxed) == 0) return false;
+    s->value.store(0, std::memory_order_release);
+    online.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool SessionTable::lookup(int userId, sockaddr_in &addr) const {
+    if (userId == EMPTY_KEY) return false;
+    const Table *t = shardFor(userId).table.load(std::memory_order_acquire);
+    const Slot *s = find(t, userId);
+    if (!s) return false;
+    uint64_t v = s->value.load(std::memory_order_acquire);
+    if (!(v & ONLINE_FLAG)) return false;
+    unpackAddr(v, addr);
+    return true;
+}
+
+bool SessionTable::contains(int userId) const {
+    sockaddr_in addr;
+    return lookup(userId, addr);
+}
+
+bool SessionTable::touch(int userId, const sockaddr_in &addr, uint32_t now) {
+    if (userId == EMPTY_KEY) return false;
+    const Table *t = shardFor(userId).table.load(std::memory_order_acquire);
+    Slot *s = const_cast<Slot*>(find(t, userId));
+    if (!s || s->value.load(std::memory_order_acquire) != packAddr(addr)) return false;
+    s->lastSeen.store(now, std::memory_order_relaxed);
+    return true;
+}
+
+uint16_t SessionTable::features(int userId, const sockaddr_in &addr) const {
+    if (userId == EMPTY_KEY) return 0;
+    const Table *t = shardFor(userId).table.load(std::memory_order_acquire);
+    const Slot *s = find(t, userId);
+    if (!s || s->value.load(std::memory_order_acquire) != packAddr(addr)) return 0;
+    return s->features.load(std::memory_order_relaxed);
+}
+
+SessionTable::IdleCheck SessionTable::expireIfIdle(int userId, uint32_t epoch, uint32_t idleBefore,
+                                                   uint32_t &lastSeen) {
+    if (userId == EMPTY_KEY) return IdleCheck::Gone;
+    Shard &shard = shardFor(userId);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    Slot *s = const_cast<Slot*>(find(shard.table.load(std::memory_order_relaxed), userId));
+    if (!s || s->value.load(std::memory_order_relaxed) == 0 ||
+        s->epoch.load(std::memory_order_relaxed) != epoch)
+        return IdleCheck::Gone;
+    lastSeen = s->lastSeen.load(std::memory_order_relaxed);
+    if (lastSeen >= idleBefore) return IdleCheck::Alive;
+    s->value.store(0, std::memory_order_release);
+    online.fetch_sub(1, std::memory_order_relaxed);
+    return IdleCheck::Expired;
+}
@@ -0,0 +1,78 @@
+#include "Stage.h"
+
+Stage::Stage(const char *name, size_t threads, size_t capacity)
+    : stageName(name), perThread(capacity ? capacity : 1), queued(0) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) workers.push_back(std::make_unique<Worker>());
+    for (auto &w : workers) {
+        Worker *wp = w.get();
+        wp->thread = std::thread([this, wp] { run(*wp); });
+    }
+}
+
+Stage::~Stage() {
+    shutdown();
+}
+
+void Stage::submit(uint64_t key, Job job) {
+    Worker &w = *workers[key % workers.size()];
+    auto now = std::chrono::steady_clock::now();
+    size_t depth;
+    {
+        std::unique_lock<std::mutex> lock(w.mutex);
+        if (w.queue.size() >= perThread && !w.stop) {
+            stageStats.blocked.fetch_add(1, std::memory_order_relaxed);
+            w.notFull.wait(lock, [&] { return w.queue.size() < perThread || w.stop; });
+        }
+        if (w.stop) {
+            lock.unlock();
+            job();
+            return;
+        }
+        w.queue.push_back(Item{std::move(job), now});
+        // 计数与队列在同一把锁内变化，合计值不会超过容量
+        depth = queued.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    stageStats.submitted.fetch_add(1, std::memory_order_relaxed);
+    if (depth > stageStats.maxDepth.load(std::memory_order_relaxed))
+        stageStats.maxDepth.store(depth, std::memory_order_relaxed);
+    w.notEmpty.notify_one();
+}
+
+void Stage::run(Worker &w) {
+    for (;;) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(w.mutex);
+            w.notEmpty.wait(lock, [&] { return !w.queue.empty() || w.stop; });
+            if (w.queue.empty()) return;  // 已停止且排空
+            item = std::move(w.queue.front());
+            w.queue.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        w.notFull.notify_one();
+
+        auto start = std::chrono::steady_clock::now();
+        item.job();
+        auto end = std::chrono::steady_clock::now();
+        stageStats.waitUs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(start - item.enqueued).count()),
+            std::memory_order_relaxed);
+        stageStats.runUs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()),
+            std::memory_order_relaxed);
+    }
+}
+
+void Stage::shutdown() {
+    for (auto &w : workers) {
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->stop = true;
+        }
+        w->notEmpty.notify_all();
+        w->notFull.notify_all();
+    }
+    for (auto &w : workers)
+        if (w->thread.joinable()) w->thread.join();
+}
@@ -1,40 +1,264 @@
 #include "ThreadPool.h"
 
-ThreadPool::ThreadPool(size_t workerCount) : stop(false) {
+namespace {
+// 当前线程所属的线程池与工作线程下标，用于把工作线程提交的任务放进它自己的双端队列
+thread_local ThreadPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// 把 std::function 形式的任务与丢弃回调包装成 Task
+struct FunctionTask {
+    std::function<void()> task;
+    std::function<void()> onShed;
+
+    void operator()() { task(); }
+    void shed() { if (onShed) onShed(); }
+};
+}
+
+ThreadPool::ThreadPool(size_t workerCount, size_t capacity, OverflowPolicy policy,
+                       std::vector<ClassConfig> configs, size_t reserved)
+    : queued(0), searching(0), stop(false), maxTasks(capacity), overflow(policy),
+      spinRounds(std::thread::hardware_concurrency() > 1 ? SPIN_ROUNDS + YIELD_ROUNDS : 0) {
+    if (configs.empty()) configs.push_back({"default", false, 1});
+    bool anyStrict = false;
+    for (auto &c : configs) {
+        if (!c.strict && c.weight == 0) c.weight = 1;
+        anyStrict |= c.strict;
+        classes.push_back(SchedClass{c, std::make_unique<MpmcRing<Job>>(capacity ? capacity : UNBOUNDED_RING)});
+    }
+    perClass.reset(new SchedClassStats[classes.size()]);
+    if (workerCount == 0) workerCount = 1;
+    if (!anyStrict || reserved >= workerCount) reserved = anyStrict ? workerCount - 1 : 0;
+
     for (size_t i = 0; i < workerCount; ++i) {
-        workers.emplace_back([this] {
-            for (;;) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(this->queueMutex);
-                    this->condition.wait(lock, [this]{ return this->stop || !this->tasks.empty(); });
-                    if (this->stop && this->tasks.empty()) return;
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
-                task();
+        state.push_back(std::make_unique<Worker>(i < reserved));
+        state.back()->deficit.assign(classes.size(), 0);
+        state.back()->rng = static_cast<uint32_t>(i * 2654435761u + 1);
+    }
+    for (size_t i = 0; i < workerCount; ++i)
+        workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    Worker &w = *state[index];
+    Job job;
+    bool isSearching = false;
+    for (;;) {
+        bool found = next(w, index, job);
+        if (!found && !w.reserved) {
+            // 先忙等再让出 CPU：突发流量下新任务通常很快到达，省去休眠与唤醒的系统调用
+            if (!isSearching) {
+                isSearching = true;
+                searching.fetch_add(1);
             }
-        });
+            for (unsigned i = 0; !found && i < spinRounds; ++i) {
+                if (i < SPIN_ROUNDS) cpuRelax();
+                else std::this_thread::yield();
+                found = next(w, index, job);
+            }
+        }
+        if (isSearching) {
+            // 有线程在找任务时提交方不唤醒其他线程；最后一个找任务的线程找到任务后若还有剩余再唤醒下一个，
+            // 避免每次提交都唤醒一个线程，醒来后扑空再休眠
+            isSearching = false;
+            if (searching.fetch_sub(1) == 1 && found && hasWork(w)) wake(sharedLot);
+        }
+        if (found) {
+            run(job);
+            continue;
+        }
+        if (stop.load(std::memory_order_acquire)) return;
+        isSearching = park(w);
+    }
+}
+
+bool ThreadPool::next(Worker &w, size_t index, Job &job) {
+    for (auto &c : classes)
+        if (c.config.strict && c.inject->pop(job)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    if (w.local.pop(job)) return true;
+    if (w.reserved) return false;
+    return popWeighted(w, job) || steal(w, index, job);
+}
+
+bool ThreadPool::popWeighted(Worker &w, Job &job) {
+    const size_t n = classes.size();
+    // 第一圈只从有剩余额度的类取，第二圈不看额度，保证只要有任务就不空闲
+    for (size_t i = 0; i < 2 * n; ++i) {
+        size_t c = w.cursor;
+        SchedClass &sc = classes[c];
+        if (!sc.config.strict && (i >= n || w.deficit[c] > 0)) {
+            if (sc.inject->pop(job)) {
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                w.deficit[c] -= job.cost;
+                return true;
+            }
+            w.deficit[c] = 0;  // 空队列不积累额度
+        }
+        w.cursor = (c + 1) % n;
+        if (w.deficit[w.cursor] <= 0) w.deficit[w.cursor] += classes[w.cursor].config.weight;
+    }
+    return false;
+}
+
+bool ThreadPool::steal(Worker &w, size_t index, Job &job) {
+    const size_t n = state.size();
+    if (n < 2) return false;
+    w.rng ^= w.rng << 13;
+    w.rng ^= w.rng >> 17;
+    w.rng ^= w.rng << 5;
+    size_t start = w.rng % n;
+    for (size_t i = 0; i < n; ++i) {
+        size_t victim = (start + i) % n;
+        if (victim == index) continue;
+        if (state[victim]->local.steal(job)) {
+            poolStats.steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::hasWork(const Worker &w) const {
+    for (const auto &c : classes)
+        if ((c.config.strict || !w.reserved) && !c.inject->empty()) return true;
+    if (!w.local.empty()) return true;
+    if (w.reserved) return false;
+    for (const auto &s : state)
+        if (!s->local.empty()) return true;
+    return false;
+}
+
+bool ThreadPool::park(Worker &w) {
+    ParkingLot &lot = w.reserved ? reservedLot : sharedLot;
+    std::unique_lock<std::mutex> lock(lot.mutex);
+    lot.sleepers.fetch_add(1, std::memory_order_relaxed);
+    // 与 wake 中的栅栏配对：提交方要么看到休眠者，要么这里看到新任务
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool woken = false;
+    if (!stop.load(std::memory_order_relaxed) && !hasWork(w)) {
+        poolStats.parks.fetch_add(1, std::memory_order_relaxed);
+        lot.cv.wait(lock, [&]{ return lot.permits > 0 || stop.load(std::memory_order_relaxed); });
+        if (lot.permits > 0) {
+            --lot.permits;
+            woken = true;
+        }
     }
+    lot.sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return woken && &lot == &sharedLot;
+}
+
+void ThreadPool::wake(size_t cls) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // 严格优先的任务优先唤醒预留线程，其他任务只有共享线程能执行
+    if (classes[cls].config.strict && reservedLot.sleepers.load(std::memory_order_relaxed) > 0)
+        wake(reservedLot);
+    else if (searching.load() == 0)
+        wake(sharedLot);
 }
 
-void ThreadPool::enqueue(std::function<void()> task) {
+void ThreadPool::wake(ParkingLot &lot) {
+    if (lot.sleepers.load(std::memory_order_relaxed) == 0) return;
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        tasks.push(std::move(task));
+        std::lock_guard<std::mutex> lock(lot.mutex);
+        if (lot.permits >= lot.sleepers.load(std::memory_order_relaxed)) return;
+        ++lot.permits;
+        // 被唤醒的共享线程在找到任务前算作正在找任务，由唤醒方计入，紧接着的提交不再重复唤醒
+        if (&lot == &sharedLot) searching.fetch_add(1);
+    }
+    lot.cv.notify_one();
+}
+
+void ThreadPool::run(Job &job) {
+    uint64_t waited = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - job.enqueued).count());
+    SchedClassStats &s = perClass[job.cls];
+    s.executed.fetch_add(1, std::memory_order_relaxed);
+    s.waitUs.fetch_add(waited, std::memory_order_relaxed);
+    if (waited > s.maxWaitUs.load(std::memory_order_relaxed))
+        s.maxWaitUs.store(waited, std::memory_order_relaxed);
+    job.task();
+    job.task.reset();
+}
+
+bool ThreadPool::evictFrom(size_t lowest, Job &shed) {
+    for (size_t i = classes.size(); i-- > lowest;) {
+        if (classes[i].inject->pop(shed)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
     }
-    condition.notify_one();
+    return false;
+}
+
+bool ThreadPool::enqueue(std::function<void()> task, std::function<void()> onShed, size_t cls, uint32_t cost) {
+    return enqueue(Task(FunctionTask{std::move(task), std::move(onShed)}), cls, cost);
+}
+
+bool ThreadPool::enqueue(Task task, size_t cls, uint32_t cost, bool local) {
+    if (cls >= classes.size()) cls = classes.size() - 1;
+    Job job{std::move(task), cost ? cost : 1, static_cast<uint32_t>(cls), std::chrono::steady_clock::now()};
+
+    if (local && currentPool == this && !classes[cls].config.strict) {
+        if (state[currentWorker]->local.push(std::move(job))) {
+            wake(cls);
+            return true;
+        }
+    }
+
+    Job shed;
+    bool admitted = true;
+    size_t depth = queued.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (maxTasks > 0 && depth > maxTasks) {
+        --depth;
+        if (evictFrom(cls + 1, shed)) {
+            poolStats.preempted.fetch_add(1, std::memory_order_relaxed);
+        } else if (overflow == OverflowPolicy::DropOldest && evictFrom(cls, shed)) {
+            poolStats.droppedOldest.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            admitted = false;
+        }
+    }
+    // 容量为 0 时注入队列本身满了也按拒绝处理
+    if (admitted && !classes[cls].inject->push(std::move(job))) admitted = false;
+    if (!admitted) {
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        auto &counter = overflow == OverflowPolicy::RejectBusy ? poolStats.rejectedBusy
+                                                               : poolStats.droppedNewest;
+        counter.fetch_add(1, std::memory_order_relaxed);
+        // 丢弃回调可能发送回复或归还资源，在调用线程上执行
+        job.task.shed();
+    } else {
+        poolStats.admitted.fetch_add(1, std::memory_order_relaxed);
+        if (depth > poolStats.maxDepth.load(std::memory_order_relaxed))
+            poolStats.maxDepth.store(depth, std::memory_order_relaxed);
+        wake(cls);
+    }
+    shed.task.shed();
+    return admitted;
 }
 
 void ThreadPool::shutdown() {
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        stop = true;
+    stop.store(true, std::memory_order_release);
+    for (ParkingLot *lot : {&sharedLot, &reservedLot}) {
+        std::lock_guard<std::mutex> lock(lot->mutex);
+        lot->cv.notify_all();
     }
-    condition.notify_all();
-    for (auto &worker : workers) worker.join();
+    // 可重复调用：已退出的工作线程不再 join
+    for (auto &worker : workers)
+        if (worker.joinable()) worker.join();
 }
 
 ThreadPool::~ThreadPool() {
     shutdown();
-}
\ No newline at end of file
+}
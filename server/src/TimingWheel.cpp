@@ -0,0 +1,56 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel(uint64_t startTick)
+    : current(startTick), count(0) {}
+
+void TimingWheel::place(const Entry &e) {
+    // 按剩余 tick 数选层：第 L 层覆盖 64^(L+1) 个 tick，槽位由到期时间的第 L 组位决定，
+    // 该槽位下一次下沉时恰好是到期时间所在区间的起点
+    uint64_t delta = e.expire - current;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        unsigned shift = SLOT_BITS * level;
+        bool inRange = delta < (uint64_t(1) << (shift + SLOT_BITS));
+        if (!inRange && level + 1 < LEVELS) continue;
+        // 超出时间轮范围：先放在最高层最后到达的槽位，下沉时再按真实到期时间重新放置
+        uint64_t t = inRange ? e.expire : current + ((SLOTS - 1) << shift);
+        slots[level][(t >> shift) & (SLOTS - 1)].push_back(e);
+        return;
+    }
+}
+
+void TimingWheel::schedule(const Entry &e) {
+    // 当前 tick 的槽位已经处理过，到期时间不晚于当前 tick 的条目留到下一次推进时回调
+    if (e.expire <= current) overdue.push_back(e);
+    else place(e);
+    ++count;
+}
+
+void TimingWheel::advance(uint64_t nowTick, const std::function<void(const Entry &)> &onExpire) {
+    if (!overdue.empty()) {
+        std::vector<Entry> due;
+        due.swap(overdue);
+        count -= due.size();
+        for (const auto &e : due) onExpire(e);
+    }
+
+    std::vector<Entry> batch;
+    while (current < nowTick) {
+        ++current;
+        // 低层转完一圈时，把上层当前槽位的条目下沉；从高层往低层处理，
+        // 使高层下沉到中间层当前槽位的条目也能继续下沉
+        unsigned top = 0;
+        while (top + 1 < LEVELS && (current & ((uint64_t(1) << (SLOT_BITS * (top + 1))) - 1)) == 0) ++top;
+        for (unsigned level = top; level >= 1; --level) {
+            auto &slot = slots[level][(current >> (SLOT_BITS * level)) & (SLOTS - 1)];
+            batch.swap(slot);
+            for (const auto &e : batch) place(e);
+            batch.clear();
+        }
+        auto &slot = slots[0][current & (SLOTS - 1)];
+        if (slot.empty()) continue;
+        batch.swap(slot);
+        count -= batch.size();
+        for (const auto &e : batch) onExpire(e);
+        batch.clear();
+    }
+}
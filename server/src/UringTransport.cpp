@@ -0,0 +1,405 @@
+#include "UringTransport.h"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+// user_data 高 8 位区分完成事件类型，低位为发送槽位编号
+enum : uint64_t {
+    TAG_RECV = 1,
+    TAG_WAKE = 2,
+    TAG_SEND = 3,
+    TAG_SEND_ZC = 4,
+    TAG_RETRY = 5,
+};
+constexpr long POOL_RETRY_NS = 1000 * 1000;  // 缓冲池耗尽时重试补充接收缓冲区的间隔
+constexpr unsigned TAG_SHIFT = 56;
+constexpr uint16_t BUF_GROUP = 0;
+
+inline uint64_t makeTag(uint64_t kind, uint64_t value = 0) { return (kind << TAG_SHIFT) | value; }
+
+int sysSetup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int sysRegister(int fd, unsigned opcode, void *arg, unsigned nrArgs) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+}
+
+UringTransport::UringTransport(int fd, BufferPool &pool, unsigned entries, unsigned bufCount, size_t bufSize,
+                               size_t zeroCopyThreshold)
+    : sockfd(fd), ringFd(-1), wakeFd(-1), entries(entries), bufCount(bufCount),
+      bufSize(sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + bufSize),
+      zeroCopyThreshold(zeroCopyThreshold),
+      sqRingPtr(MAP_FAILED), cqRingPtr(MAP_FAILED), sqRingSize(0), cqRingSize(0),
+      sqes(nullptr), sqesSize(0), sqHead(nullptr), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr),
+      cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr), sqeTail(0), toSubmit(0),
+      pool(pool), bufRing(nullptr), bufRingSize(0), bufSlots(bufCount), bufTail(0), recvMsg{}, recvArmed(false),
+      recvFailed(false), bufsAvailable(0), retryArmed(false), retryTs{}, egress(nullptr), inflightSends(0),
+      stopping(false) {}
+
+UringTransport::~UringTransport() {
+    if (ringFd >= 0) close(ringFd);
+    if (wakeFd >= 0) close(wakeFd);
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqRingPtr != MAP_FAILED && cqRingPtr != sqRingPtr) munmap(cqRingPtr, cqRingSize);
+    if (sqRingPtr != MAP_FAILED) munmap(sqRingPtr, sqRingSize);
+    if (bufRing) munmap(bufRing, bufRingSize);
+}
+
+bool UringTransport::init() {
+    // 缓冲环要求条目数为 2 的幂
+    if (bufCount == 0 || (bufCount & (bufCount - 1)) != 0 || bufCount > 32768) {
+        std::cerr << "[ERROR] io_uring 缓冲数量必须是不超过 32768 的 2 的幂" << std::endl;
+        return false;
+    }
+    // 缓冲区结尾预留一个字节补 NUL
+    if (bufSize >= pool.capacity()) {
+        std::cerr << "[ERROR] 缓冲池的缓冲区容量不足以容纳 io_uring 收包元数据" << std::endl;
+        return false;
+    }
+
+    io_uring_params p{};
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 4;  // 多次触发收包会连续产生完成事件，完成队列留足余量
+    ringFd = sysSetup(entries, &p);
+    if (ringFd < 0) { perror("io_uring_setup"); return false; }
+    entries = p.sq_entries;
+
+    sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ringFd, IORING_OFF_SQ_RING);
+    if (sqRingPtr == MAP_FAILED) { perror("mmap(sq ring)"); return false; }
+    if (singleMmap) {
+        cqRingPtr = sqRingPtr;
+    } else {
+        cqRingPtr = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ringFd, IORING_OFF_CQ_RING);
+        if (cqRingPtr == MAP_FAILED) { perror("mmap(cq ring)"); return false; }
+    }
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqePtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd, IORING_OFF_SQES);
+    if (sqePtr == MAP_FAILED) { perror("mmap(sqes)"); return false; }
+    sqes = static_cast<io_uring_sqe*>(sqePtr);
+
+    auto *sq = static_cast<uint8_t*>(sqRingPtr);
+    sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    auto *cq = static_cast<uint8_t*>(cqRingPtr);
+    cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    sqeTail = *sqTail;
+
+    // 注册内核提供缓冲环
+    bufRingSize = bufCount * sizeof(io_uring_buf);
+    void *ringMem = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMem == MAP_FAILED) { perror("mmap(buf ring)"); return false; }
+    bufRing = static_cast<io_uring_buf_ring*>(ringMem);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = bufCount;
+    reg.bgid = BUF_GROUP;
+    int rc = sysRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1);
+    if (rc < 0) { perror("io_uring_register(PBUF_RING)"); return false; }
+    for (unsigned i = 0; i < bufCount; ++i) refill(static_cast<uint16_t>(i));
+    __atomic_store_n(&bufRing->tail, static_cast<uint16_t>(bufTail), __ATOMIC_RELEASE);
+    if (bufsAvailable == 0) {
+        std::cerr << "[ERROR] 缓冲池无法提供 io_uring 接收缓冲区" << std::endl;
+        return false;
+    }
+
+    // 多次触发 recvmsg 只使用 msghdr 中的地址/控制区长度来布局缓冲区
+    recvMsg.msg_namelen = sizeof(sockaddr_in);
+    recvMsg.msg_controllen = 0;
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) { perror("eventfd"); return false; }
+    return true;
+}
+
+void UringTransport::attachEgress(EgressQueue *queue) {
+    egress = queue;
+}
+
+io_uring_sqe *UringTransport::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqeTail - head >= entries) {
+        submit(0);
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqeTail - head >= entries) return nullptr;
+    }
+    unsigned idx = sqeTail & *sqMask;
+    io_uring_sqe *sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[idx] = idx;
+    ++sqeTail;
+    ++toSubmit;
+    return sqe;
+}
+
+int UringTransport::submit(unsigned waitFor) {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    int ret;
+    do {
+        ret = sysEnter(ringFd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret < 0 && errno == EINTR && waitFor == 0);
+    uringStats.enterCalls.fetch_add(1, std::memory_order_relaxed);
+    if (ret > 0) toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+    return ret;
+}
+
+bool UringTransport::refill(uint16_t bid) {
+    PacketRef buf = pool.acquire();
+    if (!buf) {
+        emptyBids.push_back(bid);
+        return false;
+    }
+    // 内核头文件中 bufs 以 C 柔性数组声明，C++ 下空结构体占位会使其偏移错误，按首地址手动索引
+    io_uring_buf *b = reinterpret_cast<io_uring_buf*>(bufRing) + (bufTail & (bufCount - 1));
+    b->addr = reinterpret_cast<uint64_t>(buf->raw());
+    b->len = static_cast<uint32_t>(bufSize);
+    b->bid = bid;
+    bufSlots[bid] = std::move(buf);
+    ++bufTail;
+    ++bufsAvailable;
+    return true;
+}
+
+void UringTransport::armRecv() {
+    io_uring_sqe *sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sockfd;
+    sqe->addr = reinterpret_cast<uint64_t>(&recvMsg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = makeTag(TAG_RECV);
+    recvArmed = true;
+}
+
+void UringTransport::armWake() {
+    io_uring_sqe *sqe = getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = makeTag(TAG_WAKE);
+}
+
+void UringTransport::wake() {
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        perror("eventfd write");
+}
+
+void UringTransport::stop() {
+    stopping.store(true, std::memory_order_release);
+    wake();
+}
+
+void UringTransport::armRetryTimer() {
+    if (retryArmed) return;
+    io_uring_sqe *sqe = getSqe();
+    if (!sqe) return;
+    retryTs.tv_sec = 0;
+    retryTs.tv_nsec = POOL_RETRY_NS;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = reinterpret_cast<uint64_t>(&retryTs);
+    sqe->len = 1;
+    sqe->user_data = makeTag(TAG_RETRY);
+    retryArmed = true;
+    uringStats.poolRetries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UringTransport::replenish() {
+    // 缓冲区由工作线程释放最后一个引用时直接回到缓冲池，这里只需补上之前池耗尽时落下的 bid
+    if (emptyBids.empty()) return;
+    std::vector<uint16_t> bids;
+    bids.swap(emptyBids);
+    for (uint16_t bid : bids) refill(bid);
+    __atomic_store_n(&bufRing->tail, static_cast<uint16_t>(bufTail), __ATOMIC_RELEASE);
+}
+
+void UringTransport::submitSends() {
+    if (!egress) return;
+    std::vector<OutDatagram> out;
+    egress->drain(out);
+    if (out.empty()) return;
+
+    uint32_t slotId;
+    if (freeSendSlots.empty()) {
+        slotId = static_cast<uint32_t>(sendSlots.size());
+        sendSlots.push_back(std::make_unique<SendSlot>());
+    } else {
+        slotId = freeSendSlots.back();
+        freeSendSlots.pop_back();
+    }
+    SendSlot &slot = *sendSlots[slotId];
+    slot.datagrams = std::move(out);
+    size_t n = slot.datagrams.size();
+    slot.hdrs.assign(n, msghdr{});
+    slot.iovs.resize(n * 2);
+    slot.remaining = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        OutDatagram &d = slot.datagrams[i];
+        msghdr &h = slot.hdrs[i];
+        h.msg_name = &d.addr;
+        h.msg_namelen = sizeof(d.addr);
+        h.msg_iov = &slot.iovs[i * 2];
+        h.msg_iovlen = d.fillIov(h.msg_iov);
+
+        io_uring_sqe *sqe = getSqe();
+        if (!sqe) {
+            uringStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        bool zeroCopy = zeroCopyThreshold && d.size() >= zeroCopyThreshold;
+        sqe->opcode = zeroCopy ? IORING_OP_SENDMSG_ZC : IORING_OP_SENDMSG;
+        sqe->fd = sockfd;
+        sqe->addr = reinterpret_cast<uint64_t>(&h);
+        sqe->len = 1;
+        sqe->user_data = makeTag(zeroCopy ? TAG_SEND_ZC : TAG_SEND, slotId);
+        ++slot.remaining;
+        if (zeroCopy) uringStats.zeroCopySends.fetch_add(1, std::memory_order_relaxed);
+    }
+    uringStats.sendSubmitted.fetch_add(slot.remaining, std::memory_order_relaxed);
+    if (slot.remaining == 0) {
+        slot.datagrams.clear();
+        freeSendSlots.push_back(slotId);
+    } else {
+        ++inflightSends;
+    }
+}
+
+void UringTransport::onSendCompletion(uint32_t slotId, const io_uring_cqe &cqe, bool zeroCopy) {
+    if (slotId >= sendSlots.size()) return;
+    if (!(zeroCopy && (cqe.flags & IORING_CQE_F_NOTIF))) {
+        if (cqe.res < 0) uringStats.sendErrors.fetch_add(1, std::memory_order_relaxed);
+        // 零拷贝发送在通知事件到达前内核仍引用用户缓冲区
+        if (zeroCopy && (cqe.flags & IORING_CQE_F_MORE)) return;
+    }
+    SendSlot &slot = *sendSlots[slotId];
+    if (--slot.remaining == 0) {
+        slot.datagrams.clear();
+        freeSendSlots.push_back(slotId);
+        --inflightSends;
+    }
+}
+
+void UringTransport::reap(PacketChain &packets) {
+    bool provided = false;
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & *cqMask];
+        uint64_t kind = cqe.user_data >> TAG_SHIFT;
+        switch (kind) {
+        case TAG_RECV: {
+            if (!(cqe.flags & IORING_CQE_F_MORE)) recvArmed = false;
+            if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+                if (cqe.res < 0 && cqe.res != -ENOBUFS && !recvFailed) {
+                    recvFailed = true;
+                    std::cerr << "[ERROR] io_uring recvmsg 失败: " << strerror(-cqe.res) << std::endl;
+                }
+                break;
+            }
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            --bufsAvailable;
+            PacketRef pkt = std::move(bufSlots[bid]);
+            uint8_t *raw = pkt->raw();
+            io_uring_recvmsg_out out;
+            memcpy(&out, raw, sizeof(out));
+            pkt->addr = sockaddr_in{};
+            memcpy(&pkt->addr, raw + sizeof(out), std::min<size_t>(out.namelen, sizeof(pkt->addr)));
+            pkt->offset = static_cast<uint32_t>(sizeof(out) + recvMsg.msg_namelen + recvMsg.msg_controllen);
+            // 被截断时 payloadlen 为原始长度，按实际写入的字节数截取
+            pkt->length = std::min<uint32_t>(out.payloadlen, static_cast<uint32_t>(bufSize - pkt->offset));
+            pkt->truncated = out.flags & MSG_TRUNC;
+            raw[pkt->offset + pkt->length] = 0;
+            packets.push(std::move(pkt));
+            refill(bid);
+            provided = true;
+            break;
+        }
+        case TAG_WAKE: {
+            uint64_t v;
+            while (read(wakeFd, &v, sizeof(v)) > 0) {}
+            if (!(cqe.flags & IORING_CQE_F_MORE)) armWake();
+            break;
+        }
+        case TAG_RETRY:
+            retryArmed = false;
+            break;
+        case TAG_SEND:
+        case TAG_SEND_ZC:
+            onSendCompletion(static_cast<uint32_t>(cqe.user_data & ((1ULL << TAG_SHIFT) - 1)),
+                             cqe, kind == TAG_SEND_ZC);
+            break;
+        default:
+            break;
+        }
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    if (provided) __atomic_store_n(&bufRing->tail, static_cast<uint16_t>(bufTail), __ATOMIC_RELEASE);
+}
+
+void UringTransport::run(const BatchHandler &onBatch) {
+    armWake();
+    armRecv();
+    while (!stopping.load(std::memory_order_acquire)) {
+        int rc = submit(1);
+        if (rc < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+            perror("io_uring_enter");
+            break;
+        }
+        PacketChain packets;
+        reap(packets);
+        if (!packets.empty()) onBatch(std::move(packets));
+
+        replenish();
+        if (!recvArmed && !recvFailed) {
+            if (bufsAvailable > 0) {
+                uringStats.recvRearms.fetch_add(1, std::memory_order_relaxed);
+                armRecv();
+            } else {
+                // 缓冲池耗尽：缓冲区归还时不会通知本线程，定时醒来重试
+                armRetryTimer();
+            }
+        }
+        // 本轮入队的所有回复一次性提交，由下一次 io_uring_enter 带入内核
+        submitSends();
+    }
+
+    // 退出前等待在途发送完成，内核可能仍引用这些缓冲区
+    for (int spins = 0; inflightSends > 0 && spins < 1000; ++spins) {
+        if (submit(1) < 0 && errno != EINTR) break;
+        PacketChain late;
+        reap(late);
+    }
+}
@@ -1,9 +1,89 @@
 #include "Config.h"
 #include "ChatServer.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
 
-int main() {
-    ChatServer server(SERVER_PORT, DB_FILE_PATH);
+// 读取 --name=value 形式的整数参数，不是数字或超出 [minValue, maxValue] 时报错
+static bool parseNumber(const char *arg, const char *name, long maxValue, long &out, long minValue = 1) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0 || arg[n] != '=') return false;
+    char *end = nullptr;
+    out = strtol(arg + n + 1, &end, 10);
+    if (end == arg + n + 1 || *end != '\0' || out < minValue || out > maxValue) {
+        std::cerr << "无效的 " << name << " 取值: " << (arg + n + 1) << std::endl;
+        out = -1;
+    }
+    return true;
+}
+
+// 解析命令行参数，未识别的参数给出警告后忽略
+static bool parseOptions(int argc, char *argv[], ServerOptions &opts) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        long v;
+        if (parseNumber(arg, "--recv-batch", 1024, v)) {
+            if (v < 0) return false;
+            opts.recvBatchSize = static_cast<size_t>(v);
+        } else if (parseNumber(arg, "--listeners", 256, v)) {
+            if (v < 0) return false;
+            opts.listenerCount = static_cast<size_t>(v);
+        } else if (strcmp(arg, "--transport=uring") == 0) {
+            opts.transport = 1;
+        } else if (strcmp(arg, "--transport=epoll") == 0) {
+            opts.transport = 0;
+        } else if (strcmp(arg, "--no-pin") == 0) {
+            opts.pinListeners = false;
+        } else if (strcmp(arg, "--no-rate-limit") == 0) {
+            opts.rateLimit = false;
+        } else if (strcmp(arg, "--no-compression") == 0) {
+            opts.compression = false;
+        } else if (strcmp(arg, "--no-priority") == 0) {
+            opts.priorityScheduling = false;
+        } else if (strcmp(arg, "--no-lanes") == 0) {
+            opts.userLanes = false;
+        } else if (strcmp(arg, "--huge-pages") == 0) {
+            opts.hugePages = true;
+        } else if (parseNumber(arg, "--workers", 256, v)) {
+            if (v < 0) return false;
+            opts.workerCount = static_cast<size_t>(v);
+        } else if (parseNumber(arg, "--db-batch", 4096, v)) {
+            if (v < 0) return false;
+            opts.dbBatch = static_cast<size_t>(v);
+        } else if (parseNumber(arg, "--encode-threads", 64, v)) {
+            if (v < 0) return false;
+            opts.encodeThreads = static_cast<size_t>(v);
+        } else if (parseNumber(arg, "--queue-capacity", 1 << 20, v, 0)) {  // 0 表示不限制
+            if (v < 0) return false;
+            opts.queueCapacity = static_cast<size_t>(v);
+        } else if (strcmp(arg, "--overload=drop-newest") == 0) {
+            opts.overloadPolicy = OverflowPolicy::DropNewest;
+        } else if (strcmp(arg, "--overload=drop-oldest") == 0) {
+            opts.overloadPolicy = OverflowPolicy::DropOldest;
+        } else if (strcmp(arg, "--overload=busy") == 0) {
+            opts.overloadPolicy = OverflowPolicy::RejectBusy;
+        } else if (parseNumber(arg, "--egress-batch", 1024, v)) {
+            if (v < 0) return false;
+            opts.egressBatchSize = static_cast<size_t>(v);
+        } else if (parseNumber(arg, "--egress-flush-us", 1000000, v)) {
+            if (v < 0) return false;
+            opts.egressFlushUs = static_cast<unsigned>(v);
+        } else {
+            std::cerr << "[WARN] 未知参数: " << arg << std::endl;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    ServerOptions opts;
+    if (!parseOptions(argc, argv, opts)) return -1;
+
+    // 在创建任何线程前屏蔽退出信号，由服务器主循环通过 signalfd 统一处理
+    if (!blockSignals({SIGINT, SIGTERM})) return -1;
+
+    ChatServer server(SERVER_PORT, DB_FILE_PATH, opts);
     if (!server.init()) {
         std::cerr << "数据库初始化失败" << std::endl;
         return -1;
@@ -13,4 +93,4 @@ int main() {
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
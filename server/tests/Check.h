@@ -0,0 +1,26 @@
+// Check.h
+// 单元测试用的最小断言：失败时打印位置并计数，不中断后续检查；main 以 checkFailures() 作为退出码
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+inline int &checkFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                          \
+    do {                                                                                     \
+        if (!(cond)) {                                                                       \
+            ++checkFailureCount();                                                           \
+            std::cerr << "[FAIL] " << __FILE__ << ":" << __LINE__ << ": " #cond << std::endl; \
+        }                                                                                    \
+    } while (0)
+
+inline int checkFailures() {
+    if (checkFailureCount() == 0) std::cout << "[PASS]" << std::endl;
+    return checkFailureCount() == 0 ? 0 : 1;
+}
+
+#endif // CHECK_H
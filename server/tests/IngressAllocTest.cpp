@@ -0,0 +1,219 @@
+// IngressAllocTest.cpp
+// 收包到处理函数的路径上不分配内存：替换全局 operator new 计数，预热后经回环套接字发送一批请求，
+// 按 ChatServer::dispatch 的方式批量收包（recvmmsg 读入缓冲池）、校验协议头、按调度类拆成 PacketChain 提交给线程池，
+// 处理函数解码负载，部分请求再从工作线程提交后续任务（进入本线程的双端队列，可被其他线程窃取）；
+// 另一轮改经 LaneExecutor 的串行通道。检查两轮中 operator new 的调用次数为 0
+#include "Check.h"
+#include "Config.h"
+#include "Dispatch.h"
+#include "LaneExecutor.h"
+#include "Listener.h"
+#include "PacketBuffer.h"
+#include "Protocol.h"
+#include "RecvBatch.h"
+#include "ThreadPool.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+
+void *allocate(size_t n, size_t align) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = align > alignof(std::max_align_t) ? aligned_alloc(align, (n + align - 1) / align * align)
+                                                : malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+}
+
+// 数组与 nothrow 形式的默认实现都转调这两个函数
+void *operator new(size_t n) { return allocate(n, 0); }
+void *operator new(size_t n, std::align_val_t a) { return allocate(n, static_cast<size_t>(a)); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { free(p); }
+
+namespace {
+
+constexpr uint64_t WINDOW = 128;  // 在途请求上限，缓冲池不会耗尽
+
+struct Ingress {
+    BufferPool buffers{POOL_BUFFER_SIZE, POOL_SLAB_BUFFERS, 1, false};
+    RecvRing ring{buffers, RECV_RING_SLOTS, RECV_BATCH_SIZE, RECV_BUFFER_SIZE};
+    ThreadPool pool{4, 0, OverflowPolicy::RejectBusy,
+                    {{"interactive", true, 0}, {"normal", false, SCHED_WEIGHT_NORMAL}, {"bulk", false, SCHED_WEIGHT_BULK}},
+                    1};
+    int rx = -1;
+    int tx = -1;
+    sockaddr_in to{};
+    std::vector<std::vector<uint8_t>> datagrams;
+    std::atomic<uint64_t> handled{0};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<uint64_t> shed{0};
+    uint64_t received = 0;
+};
+
+// 处理函数：解码负载；查询类请求的回复在后续任务中完成，相当于交给编码阶段
+struct Reply {
+    Ingress *in;
+    PacketRef pkt;
+
+    void operator()() { in->handled.fetch_add(1, std::memory_order_relaxed); }
+    void shed() { in->shed.fetch_add(1, std::memory_order_relaxed); }
+};
+
+void handle(Ingress &in, PacketRef &&pkt) {
+    PacketHeader hdr;
+    decodeHeader(pkt->data(), pkt->length, hdr);
+    const uint8_t *payload = pkt->data() + PACKET_HEADER_SIZE;
+    bool ok = false;
+    switch (hdr.type) {
+        case PRIVATE_MSG_REQ: {
+            PrivateMsgReq req;
+            ok = decodeMessage(payload, hdr.length, req) && !req.message.empty();
+            break;
+        }
+        case CHAT_HISTORY_REQ: {
+            ChatHistoryReq req;
+            ok = decodeMessage(payload, hdr.length, req);
+            if (ok) {
+                in.pool.enqueue(Task(Reply{&in, std::move(pkt)}), SCHED_BULK);
+                return;
+            }
+            break;
+        }
+        default: {
+            UserReq req;
+            ok = decodeMessage(payload, hdr.length, req);
+            if (ok && hdr.type == FRIEND_LIST_REQ) {
+                in.pool.enqueue(Task(Reply{&in, std::move(pkt)}), SCHED_NORMAL);
+                return;
+            }
+        }
+    }
+    if (!ok) in.malformed.fetch_add(1, std::memory_order_relaxed);
+    in.handled.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 一个调度类的收包批次，与 ChatServer::PacketTask 相同
+struct PacketTask {
+    Ingress *in;
+    PacketChain packets;
+
+    void operator()() {
+        while (PacketRef pkt = packets.pop()) handle(*in, std::move(pkt));
+    }
+    void shed() { in->shed.fetch_add(packets.size(), std::memory_order_relaxed); }
+};
+
+// 收包线程上的分派，lanes 非空时逐个交给串行通道
+void dispatch(Ingress &in, PacketChain &&packets, LaneExecutor *lanes) {
+    auto now = std::chrono::steady_clock::now();
+    PacketChain groups[SCHED_CLASS_COUNT];
+    uint32_t costs[SCHED_CLASS_COUNT] = {};
+    while (PacketRef pkt = packets.pop()) {
+        PacketHeader hdr;
+        if (pkt->truncated || !decodeHeader(pkt->data(), pkt->length, hdr)) {
+            in.malformed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (lanes) {
+            lanes->submit(std::move(pkt), hdr, now);
+            continue;
+        }
+        const OpcodeTraits &traits = opcodeTraits(hdr.type);
+        costs[traits.cls] += traits.cost;
+        groups[traits.cls].push(std::move(pkt));
+    }
+    for (size_t cls = 0; cls < SCHED_CLASS_COUNT; ++cls)
+        if (!groups[cls].empty()) in.pool.enqueue(Task(PacketTask{&in, std::move(groups[cls])}), cls, costs[cls]);
+}
+
+// 发送并处理 count 个请求，返回期间 operator new 的调用次数；回环上丢包时超时返回，由调用方的计数检查报告
+uint64_t run(Ingress &in, uint64_t count, LaneExecutor *lanes) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    uint64_t before = allocations.load();
+    uint64_t target = in.received + count;
+    uint64_t sent = in.received;
+    size_t next = 0;
+    while (in.received < target && std::chrono::steady_clock::now() < deadline) {
+        while (sent < target && sent - in.handled.load(std::memory_order_relaxed) < WINDOW) {
+            const auto &d = in.datagrams[next++ % in.datagrams.size()];
+            if (sendto(in.tx, d.data(), d.size(), 0, reinterpret_cast<const sockaddr*>(&in.to), sizeof(in.to)) < 0)
+                break;
+            ++sent;
+        }
+        RecvBatch *batch = in.ring.acquire();
+        int n = in.ring.receive(in.rx, batch);
+        if (n <= 0) {
+            in.ring.release(batch);
+            std::this_thread::yield();
+            continue;
+        }
+        in.received += static_cast<uint64_t>(n);
+        PacketChain packets;
+        for (int i = 0; i < n; ++i) packets.push(std::move(batch->packets[i]));
+        in.ring.release(batch);
+        dispatch(in, std::move(packets), lanes);
+    }
+    while (in.handled.load() + in.shed.load() < in.received && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+    return allocations.load() - before;
+}
+
+} // namespace
+
+int main() {
+    Ingress in;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    in.rx = openListenerSocket(addr, false);
+    CHECK(in.rx >= 0);
+    socklen_t len = sizeof(in.to);
+    getsockname(in.rx, reinterpret_cast<sockaddr*>(&in.to), &len);
+    in.tx = socket(AF_INET, SOCK_DGRAM, 0);
+
+    // 各调度类的请求混合：私聊与心跳（严格优先）、好友列表、聊天记录
+    for (int u = 1; u <= 8; ++u) {
+        in.datagrams.push_back(buildMessage(PRIVATE_MSG_REQ, u, PrivateMsgReq{u, u + 1, "hello there"}));
+        in.datagrams.push_back(buildMessage(HEARTBEAT_REQ, 0, UserReq{u}));
+        in.datagrams.push_back(buildMessage(FRIEND_LIST_REQ, u, UserReq{u}));
+        in.datagrams.push_back(buildMessage(CHAT_HISTORY_REQ, u, ChatHistoryReq{u, u + 1}));
+    }
+
+    const uint64_t N = 20000;
+    run(in, 2000, nullptr);  // 预热：缓冲池切片、各队列与线程的首次使用
+    uint64_t pooled = run(in, N, nullptr);
+
+    LaneExecutor lanes(in.pool, 64, 0, LANE_QUANTUM, true,
+                       [&in](PacketRef &&pkt) { handle(in, std::move(pkt)); },
+                       [&in](const PacketChain &packets) { in.shed.fetch_add(packets.size()); });
+    run(in, 2000, &lanes);
+    uint64_t laned = run(in, N, &lanes);
+
+    std::cout << N << " packets via thread pool: " << pooled << " allocations, via lanes: " << laned
+              << " allocations, steals: " << in.pool.stats().steals.load() << std::endl;
+    CHECK(pooled == 0);
+    CHECK(laned == 0);
+    CHECK(in.malformed.load() == 0);
+    CHECK(in.shed.load() == 0);
+    CHECK(in.buffers.stats().exhausted.load() == 0);
+    CHECK(in.received == 4000 + 2 * N);
+    CHECK(in.handled.load() == in.received);
+
+    in.pool.shutdown();
+    close(in.tx);
+    close(in.rx);
+    return checkFailures();
+}
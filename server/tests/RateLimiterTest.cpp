@@ -0,0 +1,84 @@
+// RateLimiterTest.cpp
+// 入站限速：来源桶只按 IP 计，换源端口不能绕过；多个收包线程共用一份时总速率不随线程数放大；
+// 用户桶只计入来自该用户登录地址的请求，其他主机冒用其 userId 不会耗尽它的令牌
+#include "Check.h"
+#include "RateLimiter.h"
+#include "SessionTable.h"
+#include "WireFormat.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t TYPE = 7;
+constexpr uint32_t BURST = 40;
+
+sockaddr_in addrOf(const char *ip, uint16_t port) {
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    inet_pton(AF_INET, ip, &a.sin_addr);
+    return a;
+}
+
+// 时间不流逝，桶不会补充：放行的请求数恰为桶容量
+void rotatingPortsShareOneBucket() {
+    RateLimiter limiter(1 << 12, 1, BURST, 1, BURST);
+    limiter.setCost(TYPE, 1, false);
+    uint32_t allowed = 0;
+    for (uint16_t port = 1000; port < 1200; ++port)
+        allowed += limiter.allow(addrOf("10.0.0.1", port), TYPE, nullptr, 0, 0);
+    CHECK(allowed == BURST);
+    // 其他 IP 不受影响
+    CHECK(limiter.allow(addrOf("10.0.0.2", 1000), TYPE, nullptr, 0, 0));
+}
+
+// 四个线程相当于四个监听器，同一来源的请求分散到各线程上，合计仍只放行一个桶的量
+void listenersShareTheLimit() {
+    RateLimiter limiter(1 << 12, 1, BURST, 1, BURST);
+    limiter.setCost(TYPE, 1, false);
+    std::atomic<uint32_t> allowed{0};
+    std::vector<std::thread> threads;
+    for (uint16_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 1000; ++i)
+                if (limiter.allow(addrOf("10.0.0.1", static_cast<uint16_t>(2000 + t)), TYPE, nullptr, 0, 0))
+                    allowed.fetch_add(1);
+        });
+    }
+    for (auto &t : threads) t.join();
+    CHECK(allowed.load() == BURST);
+}
+
+void userBucketNeedsTheSessionAddress() {
+    SessionTable sessions;
+    sockaddr_in victim = addrOf("10.0.0.5", 4000);
+    CHECK(sessions.insert(42, victim));
+    // 来源桶足够大，只有用户桶会限速
+    RateLimiter limiter(1 << 12, 1, 100000, 1, BURST, &sessions);
+    limiter.setCost(TYPE, 1, true);
+    uint8_t body[4];
+    wire::store32(body, 42);
+
+    // 攻击者从其他地址（包括同一 IP 的其他端口）冒用 userId 42，只消耗自己的来源桶
+    for (int i = 0; i < 500; ++i) {
+        CHECK(limiter.allow(addrOf("10.0.0.9", static_cast<uint16_t>(5000 + i)), TYPE, body, sizeof(body), 0));
+        CHECK(limiter.allow(addrOf("10.0.0.5", 4001), TYPE, body, sizeof(body), 0));
+    }
+    // 用户本人的桶仍是满的，放行恰好一个桶的量
+    uint32_t allowed = 0;
+    for (int i = 0; i < 100; ++i) allowed += limiter.allow(victim, TYPE, body, sizeof(body), 0);
+    CHECK(allowed == BURST);
+}
+
+} // namespace
+
+int main() {
+    rotatingPortsShareOneBucket();
+    listenersShareTheLimit();
+    userBucketNeedsTheSessionAddress();
+    return checkFailures();
+}
@@ -0,0 +1,56 @@
+// ResponseCacheTest.cpp
+// 响应缓存的填充票据：查询期间同一 key 失效时放弃写入；同一分片内其他 key 的失效
+// （合并提交中别的用户或别的响应类型的写入）不影响在途填充
+#include "Check.h"
+#include "ResponseCache.h"
+#include <memory>
+#include <vector>
+
+namespace {
+
+ResponseCache::Payload payload(uint8_t v) { return std::make_shared<const std::vector<uint8_t>>(1, v); }
+
+void staleFillIsDropped() {
+    ResponseCache cache(1024);
+    ResponseCache::Key key{FRIEND_LIST_RESP, 7, 0};
+    uint64_t t = cache.ticket(key);
+    cache.invalidate(key);
+    cache.put(key, t, payload(1));
+    CHECK(!cache.get(key));
+    CHECK(cache.stats().staleFills.load() == 1);
+
+    // 失效之后取的票据照常写入
+    t = cache.ticket(key);
+    cache.put(key, t, payload(2));
+    CHECK(cache.get(key) && (*cache.get(key))[0] == 2);
+}
+
+void otherKeysDoNotBlockFills() {
+    ResponseCache cache(1 << 16);
+    // 一批在途填充，期间对大量其他 key 失效（覆盖全部分片），相当于持续写入负载下的合并提交
+    std::vector<ResponseCache::Key> reads;
+    std::vector<uint64_t> tickets;
+    for (int u = 1; u <= 64; ++u) {
+        reads.push_back({FRIEND_LIST_RESP, u, 0});
+        tickets.push_back(cache.ticket(reads.back()));
+    }
+    for (int u = 1000; u < 1064; ++u) {
+        cache.invalidate({FRIEND_LIST_RESP, u, 0});
+        cache.invalidate({CHAT_HISTORY_RESP, u, u + 1});
+    }
+    for (int u = 1; u <= 64; ++u) cache.invalidate({FRIEND_REQUEST_LIST_RESP, u, 0});
+    for (size_t i = 0; i < reads.size(); ++i) cache.put(reads[i], tickets[i], payload(3));
+
+    size_t cached = 0;
+    for (const auto &k : reads) cached += cache.get(k) != nullptr;
+    // 版本槽冲突只会误丢极少数填充；按分片记版本时这里一项也不会写入
+    CHECK(cached >= reads.size() - 3);
+}
+
+} // namespace
+
+int main() {
+    staleFillIsDropped();
+    otherKeysDoNotBlockFills();
+    return checkFailures();
+}
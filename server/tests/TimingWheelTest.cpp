@@ -0,0 +1,169 @@
+// TimingWheelTest.cpp
+// 分层时间轮：逐 tick 推进，检查跨层下沉后恰好在到期 tick 回调；
+// 再按 ChatServer::expireIdleSessions 的方式配合会话表，检查心跳续期、重新登录后旧条目失效与百万会话规模
+#include "Check.h"
+#include "SessionTable.h"
+#include "TimingWheel.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// 层边界附近的剩余 tick 数：64、64^2、64^3、64^4 前后，以及超出时间轮范围的值
+const uint64_t DELTAS[] = {1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 262143, 262144, 262145,
+                           16777215, 16777216, 16777217, 20000000};
+
+void expiresExactlyAtDeadline() {
+    // 起点取在各层槽位边界上与边界之间，覆盖下沉时当前槽位与下一槽位的两种情况
+    for (uint64_t start : {uint64_t(0), uint64_t(37), uint64_t(262100)}) {
+        for (uint64_t delta : DELTAS) {
+            TimingWheel wheel(start);
+            wheel.schedule({1, 0, start + delta});
+            uint64_t firedAt = 0;
+            int fired = 0;
+            // 在到期前后各一段逐 tick 推进，远离到期时间的部分一次推进一大段
+            uint64_t coarse = start + delta > 200 ? start + delta - 200 : start;
+            wheel.advance(coarse, [&](const TimingWheel::Entry &) { ++fired; });
+            CHECK(fired == 0);
+            for (uint64_t t = coarse + 1; t <= start + delta + 200; ++t)
+                wheel.advance(t, [&](const TimingWheel::Entry &) { ++fired; firedAt = wheel.now(); });
+            CHECK(fired == 1);
+            CHECK(firedAt == start + delta);
+            CHECK(wheel.size() == 0);
+        }
+    }
+}
+
+void jumpAdvanceFiresEachAtItsTick() {
+    // 一次推进跨越多层时，每个条目仍在自己的到期 tick 回调
+    TimingWheel wheel(100);
+    for (uint64_t delta : DELTAS) wheel.schedule({static_cast<int>(delta % 1000000), 0, 100 + delta});
+    std::vector<uint64_t> order;
+    wheel.advance(100 + 20000000, [&](const TimingWheel::Entry &e) {
+        CHECK(wheel.now() == e.expire);
+        order.push_back(e.expire);
+    });
+    CHECK(order.size() == sizeof(DELTAS) / sizeof(DELTAS[0]));
+    for (size_t i = 1; i < order.size(); ++i) CHECK(order[i - 1] < order[i]);
+}
+
+void overdueFiresOnNextAdvance() {
+    TimingWheel wheel(500);
+    wheel.schedule({7, 0, 500});
+    wheel.schedule({8, 0, 10});
+    CHECK(wheel.size() == 2);
+    int fired = 0;
+    wheel.advance(500, [&](const TimingWheel::Entry &) { ++fired; });
+    CHECK(fired == 2);
+    CHECK(wheel.size() == 0);
+}
+
+// 与 ChatServer 相同的心跳检查：到期条目按会话的最近活跃时刻续期或下线
+struct Presence {
+    static constexpr uint32_t TIMEOUT = 90;
+    SessionTable sessions;
+    TimingWheel wheel;
+    std::vector<int> expired;
+
+    bool login(int userId, uint32_t now) {
+        sockaddr_in addr{};
+        addr.sin_port = static_cast<uint16_t>(userId);
+        uint32_t epoch = 0;
+        if (!sessions.insert(userId, addr, now, &epoch)) return false;
+        wheel.schedule({userId, epoch, uint64_t(now) + TIMEOUT});
+        return true;
+    }
+    void heartbeat(int userId, uint32_t now) {
+        sockaddr_in addr{};
+        addr.sin_port = static_cast<uint16_t>(userId);
+        sessions.touch(userId, addr, now);
+    }
+    void tick(uint32_t now) {
+        std::vector<TimingWheel::Entry> due;
+        wheel.advance(now, [&](const TimingWheel::Entry &e) { due.push_back(e); });
+        for (const auto &e : due) {
+            uint32_t lastSeen = 0;
+            uint32_t idleBefore = now >= TIMEOUT ? now - TIMEOUT : 0;
+            switch (sessions.expireIfIdle(e.id, e.epoch, idleBefore, lastSeen)) {
+                case SessionTable::IdleCheck::Gone: break;
+                case SessionTable::IdleCheck::Alive: wheel.schedule({e.id, e.epoch, uint64_t(lastSeen) + TIMEOUT}); break;
+                case SessionTable::IdleCheck::Expired: expired.push_back(e.id); break;
+            }
+        }
+    }
+};
+
+void heartbeatPostponesExpiry() {
+    Presence p;
+    CHECK(p.login(1, 0));
+    CHECK(p.login(2, 0));
+    uint32_t now = 0;
+    // 用户 1 在到期前两次心跳，用户 2 从不心跳
+    for (++now; now <= 400; ++now) {
+        if (now == 50 || now == 120) p.heartbeat(1, now);
+        p.tick(now);
+        if (now == 91) {
+            // 空闲超过 TIMEOUT 个 tick 后下线
+            CHECK(p.expired.size() == 1);
+            CHECK(!p.sessions.contains(2));
+            CHECK(p.sessions.contains(1));
+        }
+        if (now == 210) CHECK(p.sessions.contains(1));
+        if (now == 211) CHECK(!p.sessions.contains(1));
+    }
+    CHECK(p.expired.size() == 2);
+    CHECK(p.wheel.size() == 0);
+}
+
+void reloginInvalidatesOldEntry() {
+    Presence p;
+    CHECK(p.login(5, 0));
+    CHECK(p.sessions.erase(5));
+    CHECK(p.login(5, 60));  // 新会话 epoch + 1，旧条目在 90 tick 到期时应被忽略
+    uint32_t now = 1;
+    for (; now <= 150; ++now) p.tick(now);
+    CHECK(p.expired.empty());
+    CHECK(p.sessions.contains(5));
+    for (; now <= 151; ++now) p.tick(now);
+    CHECK(p.expired.size() == 1);
+    CHECK(!p.sessions.contains(5));
+}
+
+void millionSessions() {
+    // 百万在线会话、每个会话一个条目；一半按时心跳，检查每个 tick 只处理到期的条目
+    const int N = 1000000;
+    Presence p;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int u = 1; u <= N; ++u) CHECK(p.login(u, static_cast<uint32_t>(u % 60)));
+    auto t1 = std::chrono::steady_clock::now();
+    uint32_t now = 1;
+    for (; now <= 100; ++now) {
+        if (now == 80)
+            for (int u = 2; u <= N; u += 2) p.heartbeat(u, now);
+        p.tick(now);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    // 未心跳的一半已全部下线（最晚一批在 59 + 90 + 1 tick），心跳的一半仍在线
+    for (; now <= 160; ++now) p.tick(now);
+    CHECK(p.expired.size() == static_cast<size_t>(N / 2));
+    CHECK(p.sessions.size() == static_cast<size_t>(N / 2));
+    for (; now <= 171; ++now) p.tick(now);
+    CHECK(p.sessions.size() == 0);
+    CHECK(p.wheel.size() == 0);
+    auto ms = [](auto d) { return std::chrono::duration_cast<std::chrono::milliseconds>(d).count(); };
+    std::cout << "1M sessions: login+schedule " << ms(t1 - t0) << " ms, first 100 ticks " << ms(t2 - t1)
+              << " ms" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    expiresExactlyAtDeadline();
+    jumpAdvanceFiresEachAtItsTick();
+    overdueFiresOnNextAdvance();
+    heartbeatPostponesExpiry();
+    reloginInvalidatesOldEntry();
+    millionSessions();
+    return checkFailures();
+}
@@ -0,0 +1,281 @@
+// WireCodecTest.cpp
+// 由字段表生成的消息编解码：每种负载编码后解码回来逐字段比较，并检查
+// encodedSize 与实际写入的长度一致、buildMessage 与 buildPacket 拼出的数据报相同、截断的负载解码失败；
+// 再用几段手写的字节检查线上布局没有随字段表改变，以及紧凑列表编码的往返
+#include "Check.h"
+#include "Protocol.h"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename T>
+struct Decoded {
+    std::vector<uint8_t> bytes;  // 解码出的字符串视图指向这里
+    T msg{};
+    bool ok = false;
+};
+
+// fixedPrefix 为负载末尾是 Rest 字段时其前面各字段的长度：只有短于它的截断才必然解码失败
+template <typename T>
+Decoded<T> roundTrip(const T &msg, size_t fixedPrefix = SIZE_MAX) {
+    Decoded<T> d;
+    d.bytes = encodeMessage(msg);
+    CHECK(d.bytes.size() == wire::encodedSize(msg));
+
+    std::vector<uint8_t> packet = buildMessage(PRIVATE_MSG_PUSH, 77, msg, FLAG_COMPRESSED, PROTOCOL_MIN_VERSION);
+    CHECK(packet == buildPacket(PRIVATE_MSG_PUSH, 77, d.bytes, FLAG_COMPRESSED, PROTOCOL_MIN_VERSION));
+
+    size_t limit = std::min(fixedPrefix, d.bytes.size());
+    for (size_t len = 0; len < limit; ++len) {
+        T partial{};
+        CHECK(!decodeMessage(d.bytes.data(), len, partial));
+    }
+
+    // 末尾追加的字节被忽略
+    std::vector<uint8_t> longer = d.bytes;
+    longer.push_back(0xEE);
+    T extended{};
+    if (fixedPrefix == SIZE_MAX) CHECK(decodeMessage(longer.data(), longer.size(), extended));
+
+    d.ok = decodeMessage(d.bytes.data(), d.bytes.size(), d.msg);
+    CHECK(d.ok);
+    return d;
+}
+
+std::vector<uint8_t> bytesOf(std::initializer_list<int> values) {
+    std::vector<uint8_t> out;
+    for (int v : values) out.push_back(static_cast<uint8_t>(v));
+    return out;
+}
+
+void accountMessages() {
+    for (bool ok : {false, true}) {
+        auto d = roundTrip(StatusResp{ok});
+        CHECK(d.msg.ok == ok);
+        CHECK(d.bytes.size() == 1);
+    }
+
+    auto cred = roundTrip(CredentialsReq{"alice", "p@ss word"});
+    CHECK(cred.msg.username == "alice");
+    CHECK(cred.msg.password == "p@ss word");
+
+    auto empty = roundTrip(CredentialsReq{"", ""});
+    CHECK(empty.msg.username.empty());
+    CHECK(empty.msg.password.empty());
+
+    auto login = roundTrip(LoginResp{true, -12345});
+    CHECK(login.msg.ok);
+    CHECK(login.msg.userId == -12345);
+
+    auto user = roundTrip(UserReq{0x7FFFFFFF});
+    CHECK(user.msg.userId == 0x7FFFFFFF);
+
+    auto update = roundTrip(UpdateUserReq{42, "bob", "secret"});
+    CHECK(update.msg.userId == 42);
+    CHECK(update.msg.newName == "bob");
+    CHECK(update.msg.newPassword == "secret");
+}
+
+void friendMessages() {
+    auto pair = roundTrip(UserPairReq{3, 9});
+    CHECK(pair.msg.userId == 3);
+    CHECK(pair.msg.targetId == 9);
+
+    auto action = roundTrip(FriendRequestActionReq{55, true});
+    CHECK(action.msg.requestId == 55);
+    CHECK(action.msg.accept);
+
+    FriendRequestListResp requests{true, {{10, 100}, {11, -1}, {500, 7}}};
+    auto rl = roundTrip(requests);
+    CHECK(rl.msg.ok);
+    CHECK(rl.msg.requests.size() == 3);
+    for (size_t i = 0; i < rl.msg.requests.size() && i < 3; ++i) {
+        CHECK(rl.msg.requests[i].requestId == requests.requests[i].requestId);
+        CHECK(rl.msg.requests[i].fromUserId == requests.requests[i].fromUserId);
+    }
+
+    FriendListResp friends{true, {{8, false}, {2, true}, {1000000, true}}};
+    auto fl = roundTrip(friends);
+    CHECK(fl.msg.ok);
+    CHECK(fl.msg.friends.size() == 3);
+    for (size_t i = 0; i < fl.msg.friends.size() && i < 3; ++i) {
+        CHECK(fl.msg.friends[i].friendId == friends.friends[i].friendId);
+        CHECK(fl.msg.friends[i].blocked == friends.friends[i].blocked);
+    }
+
+    auto none = roundTrip(FriendListResp{false, {}});
+    CHECK(!none.msg.ok);
+    CHECK(none.msg.friends.empty());
+}
+
+void groupAndChatMessages() {
+    auto create = roundTrip(CreateGroupReq{"room"});
+    CHECK(create.msg.groupName == "room");
+
+    auto join = roundTrip(JoinGroupReq{6, "room"});
+    CHECK(join.msg.userId == 6);
+    CHECK(join.msg.groupName == "room");
+
+    auto group = roundTrip(GroupMsg{12, "hello all"}, 4);
+    CHECK(group.msg.groupId == 12);
+    CHECK(group.msg.message == "hello all");
+
+    std::string body(3000, 'z');
+    auto priv = roundTrip(PrivateMsgReq{1, 2, body}, 8);
+    CHECK(priv.msg.senderId == 1);
+    CHECK(priv.msg.receiverId == 2);
+    CHECK(priv.msg.message == body);
+
+    auto push = roundTrip(PrivateMsgPush{1, ""}, 4);
+    CHECK(push.msg.senderId == 1);
+    CHECK(push.msg.message.empty());
+
+    std::string longer(70000, 'q');  // 超出 u16，正文以 u32 长度前缀编码
+    OfflineMsgListResp offline{true, {{4, "hi"}, {5, longer}, {0, ""}}};
+    auto off = roundTrip(offline);
+    CHECK(off.msg.messages.size() == 3);
+    for (size_t i = 0; i < off.msg.messages.size() && i < 3; ++i) {
+        CHECK(off.msg.messages[i].senderId == offline.messages[i].senderId);
+        CHECK(off.msg.messages[i].content == offline.messages[i].content);
+    }
+
+    auto hreq = roundTrip(ChatHistoryReq{7, 8});
+    CHECK(hreq.msg.userId == 7);
+    CHECK(hreq.msg.peerId == 8);
+
+    ChatHistoryResp history{true, {{7, "first"}, {8, "second"}}};
+    auto hist = roundTrip(history);
+    CHECK(hist.msg.ok);
+    CHECK(hist.msg.messages.size() == 2);
+    for (size_t i = 0; i < hist.msg.messages.size() && i < 2; ++i) {
+        CHECK(hist.msg.messages[i].senderId == history.messages[i].senderId);
+        CHECK(hist.msg.messages[i].content == history.messages[i].content);
+    }
+
+    auto preq = roundTrip(ChatHistoryPageReq{7, 8, 1234, 50});
+    CHECK(preq.msg.userId == 7);
+    CHECK(preq.msg.peerId == 8);
+    CHECK(preq.msg.beforeMsgId == 1234);
+    CHECK(preq.msg.limit == 50);
+
+    ChatHistoryPageResp page{true, 3, true, false, {{99, 7, "newest"}, {98, 8, ""}}};
+    auto pr = roundTrip(page);
+    CHECK(pr.msg.ok);
+    CHECK(pr.msg.seq == 3);
+    CHECK(pr.msg.last);
+    CHECK(!pr.msg.more);
+    CHECK(pr.msg.messages.size() == 2);
+    for (size_t i = 0; i < pr.msg.messages.size() && i < 2; ++i) {
+        CHECK(pr.msg.messages[i].msgId == page.messages[i].msgId);
+        CHECK(pr.msg.messages[i].senderId == page.messages[i].senderId);
+        CHECK(pr.msg.messages[i].content == page.messages[i].content);
+    }
+}
+
+void controlMessages() {
+    auto busy = roundTrip(ServerBusy{LOGIN_REQ, 250});
+    CHECK(busy.msg.requestType == LOGIN_REQ);
+    CHECK(busy.msg.retryAfterMs == 250);
+
+    std::vector<uint8_t> sub = encodeMessage(UserPairReq{1, 2});
+    std::string_view subBody(reinterpret_cast<const char*>(sub.data()), sub.size());
+    MultiReq multi{{{FRIEND_REQUEST_REQ, subBody}, {BLOCK_USER_REQ, subBody}, {LOGOUT_REQ, ""}}};
+    auto mr = roundTrip(multi);
+    CHECK(mr.msg.requests.size() == 3);
+    for (size_t i = 0; i < mr.msg.requests.size() && i < 3; ++i) {
+        CHECK(mr.msg.requests[i].type == multi.requests[i].type);
+        CHECK(mr.msg.requests[i].body == multi.requests[i].body);
+    }
+
+    MultiResp resp{{{0, FRIEND_REQUEST_RESP, 0, "\x01"}, {2, FRIEND_LIST_RESP, FLAG_COMPRESSED, subBody}}};
+    auto ms = roundTrip(resp);
+    CHECK(ms.msg.responses.size() == 2);
+    for (size_t i = 0; i < ms.msg.responses.size() && i < 2; ++i) {
+        CHECK(ms.msg.responses[i].index == resp.responses[i].index);
+        CHECK(ms.msg.responses[i].type == resp.responses[i].type);
+        CHECK(ms.msg.responses[i].flags == resp.responses[i].flags);
+        CHECK(ms.msg.responses[i].body == resp.responses[i].body);
+    }
+}
+
+void wireLayout() {
+    // 小端整数、u16 / u32 长度前缀、Rest 正文不带前缀
+    CHECK(encodeMessage(UpdateUserReq{0x01020304, "ab", "c"}) ==
+          bytesOf({0x04, 0x03, 0x02, 0x01, 2, 0, 'a', 'b', 1, 0, 'c'}));
+    CHECK(encodeMessage(PrivateMsgReq{1, 2, "hi"}) == bytesOf({1, 0, 0, 0, 2, 0, 0, 0, 'h', 'i'}));
+    CHECK(encodeMessage(ChatHistoryResp{true, {{5, "xy"}}}) ==
+          bytesOf({1, 1, 0, 0, 0, 5, 0, 0, 0, 2, 0, 0, 0, 'x', 'y'}));
+    CHECK(encodeMessage(FriendListResp{false, {{0x0100, true}}}) == bytesOf({0, 1, 0, 0, 0, 0, 1, 0, 0, 1}));
+    CHECK(encodeMessage(ChatHistoryPageReq{1, 2, 3, 0x0405}) ==
+          bytesOf({1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 5, 4}));
+    CHECK(encodeMessage(ServerBusy{LOGIN_REQ, 1}) == bytesOf({LOGIN_REQ, 1, 0, 0, 0}));
+    CHECK(encodeMessage(SubResponse{1, 2, 3, "z"}) == bytesOf({1, 0, 2, 3, 0, 1, 0, 0, 0, 'z'}));
+
+    // 超出 u16 的短字符串被截断，长度计算与写入一致
+    std::string huge(70000, 'n');
+    CreateGroupReq group{huge};
+    std::vector<uint8_t> out = encodeMessage(group);
+    CHECK(out.size() == wire::encodedSize(group));
+    CHECK(out.size() == 2 + UINT16_MAX);
+}
+
+void rejectsForgedCounts() {
+    // 声称有 2^32-1 个条目而负载只剩几个字节：不按伪造的个数分配，直接失败
+    std::vector<uint8_t> forged = bytesOf({1, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0});
+    FriendListResp friends;
+    CHECK(!decodeMessage(forged.data(), forged.size(), friends));
+    ChatHistoryResp history;
+    CHECK(!decodeMessage(forged.data(), forged.size(), history));
+    MultiReq multi;
+    CHECK(!decodeMessage(forged.data() + 1, forged.size() - 1, multi));
+}
+
+void compactLists() {
+    FriendListResp friends{true, {{900, false}, {-5, true}, {3, true}, {4, false}, {70000, true}}};
+    std::vector<uint8_t> out = encodeCompact(friends);
+    FriendListResp fl;
+    CHECK(decodeCompact(out.data(), out.size(), fl));
+    CHECK(fl.ok);
+    CHECK(fl.friends.size() == friends.friends.size());
+    // 解码结果按 ID 升序（按无符号比较的差值回绕，负数 ID 同样往返）
+    for (const auto &f : friends.friends) {
+        bool found = false;
+        for (const auto &g : fl.friends) found |= g.friendId == f.friendId && g.blocked == f.blocked;
+        CHECK(found);
+    }
+
+    FriendRequestListResp requests{false, {{30, 1}, {10, 2}, {20, 300000}}};
+    out = encodeCompact(requests);
+    FriendRequestListResp rl;
+    CHECK(decodeCompact(out.data(), out.size(), rl));
+    CHECK(!rl.ok);
+    CHECK(rl.requests.size() == 3);
+    for (size_t i = 0; i < rl.requests.size() && i < 3; ++i) CHECK(rl.requests[i].requestId == 10 * static_cast<int>(i + 1));
+    for (const auto &r : rl.requests) {
+        if (r.requestId == 10) CHECK(r.fromUserId == 2);
+        if (r.requestId == 20) CHECK(r.fromUserId == 300000);
+        if (r.requestId == 30) CHECK(r.fromUserId == 1);
+    }
+
+    for (size_t len = 0; len < out.size(); ++len) {
+        FriendRequestListResp partial;
+        CHECK(!decodeCompact(out.data(), len, partial));
+    }
+}
+
+} // namespace
+
+int main() {
+    accountMessages();
+    friendMessages();
+    groupAndChatMessages();
+    controlMessages();
+    wireLayout();
+    rejectsForgedCounts();
+    compactLists();
+    return checkFailures();
+}
@@ -0,0 +1,90 @@
+// WorkQueueTest.cpp
+// 工作窃取双端队列按值存放元素：所有者压入弹出、多个线程同时窃取，容量取得很小使槽位不断绕回，
+// 检查每个任务恰好执行一次；元素为 Task，窃取者移出途中槽位被覆盖会表现为重复、丢失或执行错乱
+#include "Check.h"
+#include "Task.h"
+#include "WorkQueue.h"
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t N = 300000;
+constexpr unsigned THIEVES = 3;
+
+struct Mark {
+    std::atomic<uint8_t> *seen;
+    size_t index;
+
+    void operator()() { seen[index].fetch_add(1, std::memory_order_relaxed); }
+};
+
+void eachTaskRunsOnce(size_t capacity) {
+    ChaseLevDeque<Task> deque(capacity);
+    std::unique_ptr<std::atomic<uint8_t>[]> seen(new std::atomic<uint8_t>[N]);
+    for (size_t i = 0; i < N; ++i) seen[i].store(0, std::memory_order_relaxed);
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> stolen{0};
+
+    std::vector<std::thread> thieves;
+    for (unsigned t = 0; t < THIEVES; ++t) {
+        thieves.emplace_back([&] {
+            Task task;
+            while (done.load(std::memory_order_acquire) < N) {
+                if (deque.steal(task)) {
+                    task();
+                    task.reset();
+                    stolen.fetch_add(1, std::memory_order_relaxed);
+                    done.fetch_add(1, std::memory_order_release);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    Task task;
+    for (size_t i = 0; i < N; ++i) {
+        Task next(Mark{seen.get(), i});
+        // 满或绕回的槽位尚未被窃取者读完时压入失败，所有者自己弹出一个再试
+        while (!deque.push(std::move(next))) {
+            if (deque.pop(task)) {
+                task();
+                task.reset();
+                done.fetch_add(1, std::memory_order_release);
+            }
+        }
+        CHECK(!next);
+        if (i % 16 == 0) std::this_thread::yield();  // 单核机器上也让窃取者有机会与所有者交错
+        if (i % 3 == 0 && deque.pop(task)) {
+            task();
+            task.reset();
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+    while (deque.pop(task)) {
+        task();
+        task.reset();
+        done.fetch_add(1, std::memory_order_release);
+    }
+    for (auto &t : thieves) t.join();
+
+    CHECK(done.load() == N);
+    CHECK(deque.empty());
+    size_t wrong = 0;
+    for (size_t i = 0; i < N; ++i) wrong += seen[i].load() != 1;
+    CHECK(wrong == 0);
+    std::cout << "capacity " << capacity << ": " << stolen.load() << " of " << N << " stolen" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    eachTaskRunsOnce(2);
+    eachTaskRunsOnce(8);
+    eachTaskRunsOnce(1024);
+    return checkFailures();
+}